@@ -0,0 +1,247 @@
+//
+//    FILE:	I2C_eepromAsync.cpp
+// PURPOSE:	Non-blocking transfers for I2C_eepromV2
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromAsync.h>
+#include <I2C_eepromCipher.h>
+#include <I2C_eepromTrace.h>
+
+//
+// Definitions ... local
+//
+#define STEP_NONE	0
+#define STEP_PROBE	1	// ACK probe: write cycle over?
+#define STEP_CHUNK	2
+
+#ifdef I2C_EEPROM_TRACE
+#define TRACE_NOW()			micros()
+#define TRACE(ee, type, addr, len, start, rv) I2C_eepromTrace::record(type, (ee)->_deviceAddress, addr, len, start, rv)
+#else
+#define TRACE_NOW()			0
+#define TRACE(ee, type, addr, len, start, rv)
+#endif
+
+
+//
+// Constructor ...
+//
+I2C_eepromAsync::I2C_eepromAsync(I2C_eeprom& ee) {
+	this->_ee	 = &ee;
+	this->_target	 = &ee;
+	this->_frameSize = ee.get_bus()->get_bufferSize();
+	this->_frame	 = (uint8_t*)malloc(_frameSize);
+	this->_op	 = I2C_EEPROM_ASYNC_IDLE;
+	this->_step	 = STEP_NONE;
+	this->_status	 = 0;
+	this->_rv	 = 0;
+	this->_done	 = NULL;
+	this->_ctx	 = NULL;
+}
+
+I2C_eepromAsync::~I2C_eepromAsync() {
+	free(_frame);
+}
+
+
+//
+// Start writing <length> bytes from <buffer> to PROM @ <memoryAddress>
+// <buffer> must stay untouched until the job is done
+// returns 0 = started otherwise error
+//
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+int I2C_eepromAsync::startWrite(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, I2C_eepromDone done, void* ctx) {
+	return _start(I2C_EEPROM_ASYNC_WRITE, memoryAddress, (uint8_t*)buffer, length, done, ctx);
+}
+#else
+int I2C_eepromAsync::startWrite(const uint16_t, const uint8_t*, const uint16_t, I2C_eepromDone, void*) {
+	return I2C_EEPROM_ERR_READONLY;		// read-only profile
+}
+#endif
+
+
+//
+// Start reading <length> bytes from PROM @ <memoryAddress> to <buffer>
+// returns 0 = started otherwise error
+//
+int I2C_eepromAsync::startRead(const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length, I2C_eepromDone done, void* ctx) {
+	return _start(I2C_EEPROM_ASYNC_READ, memoryAddress, buffer, length, done, ctx);
+}
+
+
+//
+// Move the job on: take in the transaction on the bus when it is over and
+// start the next one
+//
+bool I2C_eepromAsync::poll() {
+
+	if (_op == I2C_EEPROM_ASYNC_IDLE) return false;
+
+	if (_step != STEP_NONE) {
+		_target->_bus->pollTransfer();
+		if (_status == I2C_EEPROM_BUS_PENDING) return true;
+		if (!_complete()) return false;
+	}
+
+	_next();
+	if (_status == I2C_EEPROM_BUS_PENDING) return true;
+	return _complete();		// not a background bus: done already
+}
+
+
+//
+// Utility functions
+//
+bool	I2C_eepromAsync::busy()		{ return _op != I2C_EEPROM_ASYNC_IDLE;	}
+int	I2C_eepromAsync::result()	{ return _rv;				}
+
+int I2C_eepromAsync::wait() {
+	while (poll()) ;
+	return _rv;
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+int I2C_eepromAsync::_start(uint8_t op, uint16_t addr, uint8_t* buf, uint16_t len, I2C_eepromDone done, void* ctx) {
+	if (_op != I2C_EEPROM_ASYNC_IDLE) return I2C_EEPROM_ERR_BUSY;
+	if (_frame == NULL) return I2C_EEPROM_ERR_RANGE;
+	if (addr + (uint32_t)len > _ee->_bytes()) return I2C_EEPROM_ERR_RANGE;
+
+	_target	= _ee;
+	_step	= STEP_NONE;
+	_addr	= addr;
+	_buf	= buf;
+	_left	= len;
+	_done	= done;
+	_ctx	= ctx;
+	_rv	= 0;
+	_op	= op;
+
+	if (len == 0) _finish(0);
+	return 0;
+}
+
+
+//
+// Next transaction for _target: ACK probe while it may be in its write
+// cycle, otherwise the chunk ... sized at the head of the mirror chain
+//
+void I2C_eepromAsync::_next() {
+I2C_eeprom*	t = _target;
+uint8_t		words = t->get_addrWords();
+uint8_t*	rx = NULL;
+uint16_t	rxLen = 0;
+uint16_t	txLen = words;
+
+	if (t->_cycling()) {
+		_step	 = STEP_PROBE;
+		_started = TRACE_NOW();
+		t->_bus->lock();
+		t->_bus->startTransfer(t->_deviceAddress, NULL, 0, NULL, 0, &_status);
+		t->_bus->unlock();
+		return;
+	}
+
+	if (t == _ee) {
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+		if (_op == I2C_EEPROM_ASYNC_WRITE) {
+			_cnt = min(_left, _frameSize - words);
+			for (I2C_eeprom* m = _ee; m != NULL; m = m->_mirror) {
+				_cnt = min(_cnt, m->_writeChunk(_addr));
+				_cnt = min(_cnt, _frameSize - m->get_addrWords());
+			}
+		} else
+#endif
+			_cnt = min(_left, _ee->_chunk());
+	}
+
+	_frame[0] = (words > 1) ? _addr >> 8 : _addr & 0xFF;
+	_frame[1] = _addr & 0xFF;
+
+	if (_op == I2C_EEPROM_ASYNC_WRITE) {
+		if (t->_cipher != NULL) {
+			t->_cipher->seek(_addr);
+			for (uint16_t i=0; i<_cnt; i++) _frame[words + i] = _buf[i] ^ t->_cipher->next();
+		} else {
+			memcpy(_frame + words, _buf, _cnt);
+		}
+		txLen += _cnt;
+	} else {
+		rx	= _buf;
+		rxLen	= _cnt;
+	}
+
+	_step	 = STEP_CHUNK;
+	_started = TRACE_NOW();
+	t->_bus->lock();
+	t->_bus->startTransfer(t->_devAddr(_addr), _frame, txLen, rx, rxLen, &_status);
+	t->_bus->unlock();
+}
+
+
+//
+// The transaction on the bus is over ... returns true while the job goes on
+//
+bool I2C_eepromAsync::_complete() {
+I2C_eeprom*	t = _target;
+uint8_t		step = _step;
+uint8_t		rv = _status;
+
+	_step = STEP_NONE;
+
+	if (step == STEP_PROBE) {
+		if (rv == 0) t->_writing = false;
+		TRACE(t, I2C_EEPROM_TRACE_WAIT, 0, 1, _started, 0);
+		return true;
+	}
+
+	if (_op == I2C_EEPROM_ASYNC_WRITE) {
+		t->_lastWrite	= micros();
+		t->_writing	= !t->_fram;
+		TRACE(t, I2C_EEPROM_TRACE_WRITE, _addr, _cnt, _started, rv);
+		if (rv != 0) {
+			_finish(rv);
+			return false;
+		}
+		_target = t->_mirror;			// same chunk down the chain
+		if (_target != NULL) return true;
+	} else {
+		TRACE(t, I2C_EEPROM_TRACE_READ, _addr, _cnt, _started, rv ? I2C_EEPROM_ERR_READ : 0);
+		if (rv != 0) {
+			_finish(I2C_EEPROM_ERR_READ);
+			return false;
+		}
+		if (t->_cipher != NULL) {
+			t->_cipher->seek(_addr);
+			for (uint16_t i=0; i<_cnt; i++) _buf[i] ^= t->_cipher->next();
+		}
+	}
+
+	_target	= _ee;
+	_addr	+= _cnt;
+	_buf	+= _cnt;
+	_left	-= _cnt;
+
+	if (_left == 0) {
+		_finish(0);
+		return false;
+	}
+	return true;
+}
+
+
+void I2C_eepromAsync::_finish(int rv) {
+	_rv	= rv;
+	_op	= I2C_EEPROM_ASYNC_IDLE;
+	_target	= _ee;
+	if (_done != NULL) _done(_ctx, rv);
+}
@@ -0,0 +1,89 @@
+#ifndef I2C_EEPROM_ASYNC_H
+#define I2C_EEPROM_ASYNC_H
+//
+//    FILE: I2C_eepromAsync.h
+// PURPOSE: Non-blocking transfers for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// A transfer is started and then moved on by poll() from loop(). Each poll()
+// starts at most one bus transaction: one write chunk, one read chunk or one
+// ACK probe while the PROM is in its write cycle. The 5 ms write cycles - where
+// the blocking calls spend nearly all of their time - are thus left to the main
+// loop. Completion is signalled through a callback (called from poll()) and busy().
+//
+// Transactions go through I2C_eepromBus::startTransfer(). On an interrupt
+// driven backend (I2C_eepromTWI) poll() only hands the chunk over and the
+// bytes move while loop() goes on; on Wire each poll() waits for its one
+// transaction. Writes go to the whole mirror chain, chunk by chunk.
+//
+//	I2C_eepromAsync job(ee);
+//
+//	job.startWrite(0x100, data, sizeof(data), done);
+//	...
+//	void loop() { job.poll(); ... }
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+// Job in progress
+#define I2C_EEPROM_ASYNC_IDLE	0
+#define I2C_EEPROM_ASYNC_WRITE	1
+#define I2C_EEPROM_ASYNC_READ	2
+
+typedef void (*I2C_eepromDone)(void* ctx, int rv);
+
+
+class I2C_eepromAsync {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromAsync(I2C_eeprom& ee);
+    ~I2C_eepromAsync();
+
+    int		startWrite(	const uint16_t	memoryAddress,
+				const uint8_t*	buffer,
+				const uint16_t	length,
+				I2C_eepromDone	done = NULL,
+				void*		ctx  = NULL);
+
+    int		startRead(	const uint16_t	memoryAddress,
+				      uint8_t*	buffer,
+				const uint16_t	length,
+				I2C_eepromDone	done = NULL,
+				void*		ctx  = NULL);
+
+    bool	poll(void);		// one step; true while busy
+    bool	busy(void);
+    int		result(void);		// of the last job: 0 = OK otherwise error
+    int		wait(void);		// poll() until done; returns result()
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    I2C_eeprom*	_target;		// of the mirror chain, the chunk goes to
+    uint8_t*	_frame;			// address words + chunk as they go out
+    uint16_t	_frameSize;
+    uint8_t	_op;
+    uint8_t	_step;			// on the bus: nothing, ACK probe, chunk
+    volatile uint8_t _status;		// of the transaction on the bus
+    uint16_t	_addr;
+    uint8_t*	_buf;
+    uint16_t	_left;
+    uint16_t	_cnt;			// chunk
+    uint32_t	_started;		// trace
+    int		_rv;
+    I2C_eepromDone _done;
+    void*	_ctx;
+
+    int		_start(uint8_t op, uint16_t addr, uint8_t* buf, uint16_t len, I2C_eepromDone done, void* ctx);
+    void	_next(void);
+    bool	_complete(void);
+    void	_finish(int rv);
+};
+#endif
@@ -0,0 +1,95 @@
+//
+//    FILE:	I2C_eepromBD.cpp
+// PURPOSE:	Block device on I2C_eepromV2 for a filesystem (LittleFS et al.)
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromBD.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromBD::I2C_eepromBD(I2C_eeprom& ee, const uint16_t base, const uint16_t blocks, const uint8_t blockPages) {
+uint8_t		per = blockPages;
+uint32_t	room;
+
+	this->_ee	= &ee;
+	this->_base	= base;
+	this->_pageSize	= ee.get_pageSize();
+	this->_reads	= 0;
+	this->_progs	= 0;
+
+	this->_blockSize = 0;
+	this->_blocks	 = 0;
+
+	// Unknown PROM, <base> off a page boundary or past the end: no blocks,
+	// every call fails with I2C_EEPROM_ERR_RANGE
+	if (_pageSize == 0 || base % _pageSize != 0 || base >= (uint32_t)ee.get_pages() * _pageSize) return;
+
+	if (per == 0) per = (I2C_EEPROM_BD_MIN + _pageSize - 1) / _pageSize;
+	this->_blockSize = per * _pageSize;
+
+	room = ((uint32_t)ee.get_pages() * _pageSize - base) / _blockSize;
+	this->_blocks	= (blocks == 0 || blocks > room) ? room : blocks;
+}
+
+
+//
+// Sequential read of <size> bytes @ <offset> of <block>
+//
+int I2C_eepromBD::read(const uint16_t block, const uint16_t offset, uint8_t* buffer, const uint16_t size) {
+	if (!_inside(block, offset, size)) return I2C_EEPROM_ERR_RANGE;
+
+	_reads++;
+	if (_ee->readBlock(_base + (uint32_t)block * _blockSize + offset, buffer, size) != size)
+		return I2C_EEPROM_ERR_READ;
+	return 0;
+}
+
+
+//
+// Whole pages only: <offset> and <size> multiples of get_progSize()
+//
+int I2C_eepromBD::prog(const uint16_t block, const uint16_t offset, const uint8_t* buffer, const uint16_t size) {
+	if (!_inside(block, offset, size) || offset % _pageSize != 0 || size % _pageSize != 0)
+		return I2C_EEPROM_ERR_RANGE;
+
+	_progs += size / _pageSize;
+	return _ee->writeBlock(_base + (uint32_t)block * _blockSize + offset, buffer, size);
+}
+
+
+int I2C_eepromBD::erase(const uint16_t block) {
+	return (block < _blocks) ? 0 : I2C_EEPROM_ERR_RANGE;
+}
+
+
+int I2C_eepromBD::sync() {
+	_ee->waitEEReady();
+	return 0;
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromBD::get_blockSize()	{ return _blockSize;	}
+uint16_t	I2C_eepromBD::get_blocks()	{ return _blocks;	}
+uint16_t	I2C_eepromBD::get_progSize()	{ return _pageSize;	}
+uint32_t	I2C_eepromBD::get_reads()	{ return _reads;	}
+uint32_t	I2C_eepromBD::get_progs()	{ return _progs;	}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+bool I2C_eepromBD::_inside(const uint16_t block, const uint16_t offset, const uint16_t size) {
+	return block < _blocks && (uint32_t)offset + size <= _blockSize;
+}
@@ -0,0 +1,72 @@
+#ifndef I2C_EEPROM_BD_H
+#define I2C_EEPROM_BD_H
+//
+//    FILE: I2C_eepromBD.h
+// PURPOSE: Block device on I2C_eepromV2 for a filesystem (LittleFS et al.)
+// VERSION: see I2C_EEPROM_VERSION
+//
+// A block is one or more PROM pages; without <blockPages> given, as many as
+// make 128 bytes at least (the smallest block LittleFS takes). The program
+// unit is the page, so a filesystem writes whole, aligned pages only; reads
+// run on sequentially within a block. A PROM needs no erase: erase() does
+// nothing, sync() waits for the last write cycle.
+//
+//	I2C_eepromBD	bd(ee, 0, 0);		// whole PROM
+//
+// I2C_eepromLFS.h fills a struct lfs_config from it.
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_BD_MIN	128		// bytes per block at least
+
+
+class I2C_eepromBD {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <blocks> blocks from <base> (page aligned) on; 0 = up to the end of the PROM
+     * <base> off a page boundary or past the end: get_blocks() is 0, every call fails
+     */
+    I2C_eepromBD(I2C_eeprom& ee, const uint16_t base, const uint16_t blocks, const uint8_t blockPages = 0);
+
+    // returns 0 = OK otherwise error
+    int		read(		const uint16_t	block,
+				const uint16_t	offset,
+				      uint8_t*	buffer,
+				const uint16_t	size);
+
+    int		prog(		const uint16_t	block,
+				const uint16_t	offset,
+				const uint8_t*	buffer,
+				const uint16_t	size);
+
+    int		erase(const uint16_t block);
+    int		sync(void);
+
+    uint16_t	get_blockSize(void);
+    uint16_t	get_blocks(void);
+    uint16_t	get_progSize(void);		// page
+    uint32_t	get_reads(void);
+    uint32_t	get_progs(void);		// pages written
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pageSize;
+    uint16_t	_blockSize;
+    uint16_t	_blocks;
+    uint32_t	_reads;
+    uint32_t	_progs;
+
+    bool	_inside(const uint16_t block, const uint16_t offset, const uint16_t size);
+};
+#endif
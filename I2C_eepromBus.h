@@ -0,0 +1,184 @@
+#ifndef I2C_EEPROM_BUS_H
+#define I2C_EEPROM_BUS_H
+//
+//    FILE: I2C_eepromBus.h
+// PURPOSE: Transport for I2C_eepromV2 ... the bus an I2C_eeprom talks to
+// VERSION: see I2C_EEPROM_VERSION
+//
+// The interface follows Wire, so any Wire-alike plugs in through I2C_eepromWireT:
+//
+//	I2C_eepromWire		bus1(Wire1);		// second hardware controller
+//	I2C_eepromWireT<SoftWire> bus2(sw);		// bit banged
+//	I2C_eeprom		ee(bus1, 0x50, 256);
+//
+// Further backends: I2C_eepromSim (in-memory, any platform) and
+// I2C_eepromLinux (/dev/i2c-N on a Linux host).
+//
+// startTransfer() hands a whole transaction to the backend. One that moves
+// the bytes by interrupt or DMA returns at once and the CPU is free until
+// <status> leaves I2C_EEPROM_BUS_PENDING: I2C_eepromTWI (AVR, interrupt
+// driven; define I2C_EEPROM_TWI below, it replaces Wire) and I2C_eepromSim
+// with setBackground(). I2C_eepromAsync drives its jobs through it. The
+// default here runs the transaction on the Wire-style calls before returning.
+//
+// With I2C_EEPROM_THREADSAFE defined (here or in the build flags) each bus
+// carries a mutex; I2C_eeprom holds it for one transaction at a time, so
+// tasks sharing an instance or a bus interleave between transactions.
+// Use one I2C_eepromBus object per physical bus.
+//
+// Released to the public domain
+//
+
+//#define I2C_EEPROM_THREADSAFE
+//#define I2C_EEPROM_TWI		// AVR: interrupt driven TWI instead of Wire
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#elif defined(ARDUINO)
+#include "WProgram.h"
+#else
+#include "I2C_eepromHost.h"
+#endif
+
+#define I2C_EEPROM_BUS_PENDING	0xFF	// startTransfer() <status>: on the bus
+
+#ifdef I2C_EEPROM_THREADSAFE
+#include <I2C_eepromThread.h>
+#ifndef I2C_EEPROM_THREADS
+#error "I2C_EEPROM_THREADSAFE: no threads on this platform"
+#endif
+#endif
+
+
+class I2C_eepromBus {
+public:
+    virtual void	begin(int speed) = 0;		// speed in Khz
+
+    virtual void	beginTransmission(uint8_t address) = 0;
+    virtual size_t	write(const uint8_t* buffer, size_t length) = 0;
+    virtual size_t	write(uint8_t data)		{ return write(&data, 1); }
+    virtual uint8_t	endTransmission(bool stop = true) = 0;	// 0 = OK; 1..4 as Wire
+
+    virtual uint16_t	requestFrom(uint8_t address, uint16_t length) = 0;
+    virtual int		available(void) = 0;
+    virtual int		read(void) = 0;
+
+    // Bytes per transaction, memory address included
+    virtual uint16_t	get_bufferSize(void) = 0;
+
+    // One transaction: <tx> out, then - repeated START - <rxLen> bytes into
+    // <rx>. <status> reads I2C_EEPROM_BUS_PENDING until it is over, then
+    // 0 = OK or 1..4 as Wire. A transaction in flight is waited for first.
+    virtual void	startTransfer(	uint8_t			address,
+					const uint8_t*		tx,
+					uint16_t		txLen,
+					uint8_t*		rx,
+					uint16_t		rxLen,
+					volatile uint8_t*	status);
+    virtual void	pollTransfer(void)		{ }	// backends without interrupt
+    virtual bool	get_background(void)		{ return false; }
+
+    virtual ~I2C_eepromBus() {}
+
+    // Held by I2C_eeprom around each transaction
+#ifdef I2C_EEPROM_THREADSAFE
+    void		lock(void)		{ _mutex.lock();	}
+    void		unlock(void)		{ _mutex.unlock();	}
+private:
+    I2C_eepromMutex	_mutex;
+#else
+    void		lock(void)		{ }
+    void		unlock(void)		{ }
+#endif
+};
+
+
+inline void I2C_eepromBus::startTransfer(uint8_t address, const uint8_t* tx, uint16_t txLen, uint8_t* rx, uint16_t rxLen, volatile uint8_t* status) {
+uint8_t		rv;
+uint16_t	cnt = 0;
+
+	beginTransmission(address);
+	if (txLen > 0) write(tx, txLen);
+	rv = endTransmission(rxLen == 0);
+	if (rv == 0 && rxLen > 0) {
+		uint16_t n = requestFrom(address, rxLen);
+		while (cnt < n && available()) rx[cnt++] = read();
+		if (cnt != rxLen) rv = 4;
+	}
+	*status = rv;
+}
+
+
+#if defined(ARDUINO) && defined(I2C_EEPROM_TWI)
+#include <I2C_eepromTWI.h>
+#elif defined(ARDUINO)
+#include <Wire.h>
+
+#if ARDUINO >= 100
+    #define I2C_EEPROM_WIRE_WRITE(w, b, n)	(w).write(b, n)
+    #define I2C_EEPROM_WIRE_WRITE1(w, b)	(w).write(b)
+    #define I2C_EEPROM_WIRE_READ(w)		(w).read()
+    #define I2C_EEPROM_WIRE_END(w, s)		(w).endTransmission(s)
+#else
+    #define I2C_EEPROM_WIRE_WRITE(w, b, n)	(w).send((uint8_t*)(b), n)
+    #define I2C_EEPROM_WIRE_WRITE1(w, b)	((w).send(b), 1)
+    #define I2C_EEPROM_WIRE_READ(w)		(w).receive()
+    #define I2C_EEPROM_WIRE_END(w, s)		(w).endTransmission()
+#endif
+
+#ifndef BUFFER_LENGTH
+#define BUFFER_LENGTH	32
+#endif
+
+//
+// Bus clock ... TWBR on AVR, setClock() where there is one, nothing for Wire-alikes
+//
+// 0=1000, 1=888, 2=800, 8=500, 12=400, 24=250, 32=200, 72=100, 152=50 [Khz]
+// F_CPU/16+(2*TWBR) // TWBR is a uint8_t
+//
+template <class W> inline void I2C_eepromClock(W& wire, int speed) {}
+
+inline void I2C_eepromClock(TwoWire& wire, int speed) {
+#ifdef TWBR
+	switch (speed) {
+		case  50:	TWBR=152;	break;
+		case 200:	TWBR=32;	break;
+		case 250:	TWBR=24;	break;
+		case 400:	TWBR=12;	break;
+		case 500:	TWBR=8;		break;
+		case 800:	TWBR=2;		break;
+		case 888:	TWBR=1;		break;
+		case 1000:	TWBR=0;		break;
+		default:	TWBR=72;
+	}
+#elif ARDUINO >= 10600
+	wire.setClock(speed * 1000UL);
+#endif
+}
+
+
+//
+// Any Wire-alike: TwoWire (Wire, Wire1, ...), SoftWire, ...
+//
+template <class W> class I2C_eepromWireT : public I2C_eepromBus {
+public:
+    I2C_eepromWireT(W& wire) : _wire(wire) {}
+
+    void	begin(int speed)			{ _wire.begin(); I2C_eepromClock(_wire, speed); }
+    void	beginTransmission(uint8_t address)	{ _wire.beginTransmission(address); }
+    size_t	write(const uint8_t* buffer, size_t length) { return I2C_EEPROM_WIRE_WRITE(_wire, buffer, length); }
+    size_t	write(uint8_t data)			{ return I2C_EEPROM_WIRE_WRITE1(_wire, data); }
+    uint8_t	endTransmission(bool stop)		{ return I2C_EEPROM_WIRE_END(_wire, stop); }
+    uint16_t	requestFrom(uint8_t address, uint16_t length) { return _wire.requestFrom(address, (uint8_t)length); }
+    int		available()				{ return _wire.available(); }
+    int		read()					{ return I2C_EEPROM_WIRE_READ(_wire); }
+    uint16_t	get_bufferSize()			{ return BUFFER_LENGTH; }
+
+private:
+    W&		_wire;
+};
+
+typedef I2C_eepromWireT<TwoWire> I2C_eepromWire;
+#endif
+
+#endif
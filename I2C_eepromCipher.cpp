@@ -0,0 +1,98 @@
+//
+//    FILE:	I2C_eepromCipher.cpp
+// PURPOSE:	Encryption at rest for I2C_eepromV2 ... keystream by PROM address
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromCipher.h>
+
+#define ROTL(v, n)	(((v) << (n)) | ((v) >> (32 - (n))))
+#define QR(a, b, c, d)	a += b; d ^= a; d = ROTL(d, 16);	\
+			c += d; b ^= c; b = ROTL(b, 12);	\
+			a += b; d ^= a; d = ROTL(d,  8);	\
+			c += d; b ^= c; b = ROTL(b,  7)
+
+
+static uint32_t _le32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+//
+// Constructor ...
+//
+I2C_eepromChaCha20::I2C_eepromChaCha20(const uint8_t* key, const uint8_t* nonce) {
+	this->_state[0]	= 0x61707865;		// "expand 32-byte k"
+	this->_state[1]	= 0x3320646E;
+	this->_state[2]	= 0x79622D32;
+	this->_state[3]	= 0x6B206574;
+	for (uint8_t i=0; i<8; i++) this->_state[4 + i] = _le32(key + 4 * i);
+	this->_state[12] = 0;
+	for (uint8_t i=0; i<3; i++) this->_state[13 + i] = _le32(nonce + 4 * i);
+
+	this->_position	= 0;
+	this->_valid	= false;
+}
+
+I2C_eepromChaCha20::~I2C_eepromChaCha20() {
+	memset(_state, 0, sizeof(_state));
+	memset(_block, 0, sizeof(_block));
+}
+
+
+void I2C_eepromChaCha20::seek(const uint32_t position) {
+	_position = position;
+}
+
+
+//
+// A block is made when the position leaves the one held ... sequential
+// bytes cost one block per 64
+//
+uint8_t I2C_eepromChaCha20::next() {
+	if (!_valid || _state[12] != (_position >> 6) + 1) {
+		_state[12] = _position >> 6;
+		_generate();
+		_valid = true;
+	}
+	return _block[_position++ & 63];
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// Keystream block _state[12] to _block; counter on
+//
+void I2C_eepromChaCha20::_generate() {
+uint32_t x[16];
+
+	memcpy(x, _state, sizeof(x));
+	for (uint8_t r=0; r<10; r++) {
+		QR(x[0], x[4], x[ 8], x[12]);
+		QR(x[1], x[5], x[ 9], x[13]);
+		QR(x[2], x[6], x[10], x[14]);
+		QR(x[3], x[7], x[11], x[15]);
+		QR(x[0], x[5], x[10], x[15]);
+		QR(x[1], x[6], x[11], x[12]);
+		QR(x[2], x[7], x[ 8], x[13]);
+		QR(x[3], x[4], x[ 9], x[14]);
+	}
+	for (uint8_t i=0; i<16; i++) {
+		uint32_t v = x[i] + _state[i];
+
+		_block[4 * i]	  = v;
+		_block[4 * i + 1] = v >> 8;
+		_block[4 * i + 2] = v >> 16;
+		_block[4 * i + 3] = v >> 24;
+	}
+	_state[12]++;
+	memset(x, 0, sizeof(x));
+}
@@ -0,0 +1,68 @@
+#ifndef I2C_EEPROM_CIPHER_H
+#define I2C_EEPROM_CIPHER_H
+//
+//    FILE: I2C_eepromCipher.h
+// PURPOSE: Encryption at rest for I2C_eepromV2 ... keystream by PROM address
+// VERSION: see I2C_EEPROM_VERSION
+//
+// With a cipher set an I2C_eeprom XORs every byte with the keystream byte of
+// its PROM address on the way to and from the bus: no buffer, no second
+// pass, and any address can be read alone.
+//
+//	I2C_eepromChaCha20 key(secret, nonce);	// 32 byte key, 12 byte nonce
+//	ee.setCipher(&key);			// NULL: plain again
+//
+// The same address always gets the same keystream. That keeps the data of a
+// PROM taken away secret, but two versions of a byte XOR to the XOR of the
+// plain texts; give every unit its own nonce. There is no integrity check:
+// add a CRC (crc32()) or a MAC of your own. One cipher object per I2C_eeprom;
+// a mirror or the destination of a copyTo() uses its own (or none).
+//
+// Released to the public domain
+//
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#elif defined(ARDUINO)
+#include "WProgram.h"
+#else
+#include "I2C_eepromHost.h"
+#endif
+
+
+class I2C_eepromCipher {
+public:
+    virtual void	seek(const uint32_t position) = 0;	// keystream to byte <position>
+    virtual uint8_t	next(void) = 0;				// keystream byte, position on
+
+    virtual ~I2C_eepromCipher() {}
+};
+
+
+//
+// ChaCha20 (RFC 7539): block counter = position / 64
+//
+class I2C_eepromChaCha20 : public I2C_eepromCipher {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromChaCha20(const uint8_t* key, const uint8_t* nonce);
+    ~I2C_eepromChaCha20();
+
+    void	seek(const uint32_t position);
+    uint8_t	next(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    uint32_t	_state[16];		// constants, key, counter, nonce
+    uint8_t	_block[64];		// keystream of block _state[12] - 1
+    uint32_t	_position;
+    bool	_valid;			// _block made
+
+    void	_generate(void);
+};
+#endif
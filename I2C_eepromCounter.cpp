@@ -0,0 +1,163 @@
+//
+//    FILE:	I2C_eepromCounter.cpp
+// PURPOSE:	Wear spreading monotonic counter over I2C_eepromV2
+//
+// Bits of the unary part are cleared from bit 0 of its first byte on; the
+// bytes before the current one are 0x00, the ones behind 0xFF.
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromCounter.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromCounter::I2C_eepromCounter(I2C_eeprom& ee, const uint16_t base, const uint16_t pages) {
+	this->_ee	= &ee;
+	this->_base	= base;
+	this->_pages	= pages;
+	this->_pageSize	= ee.get_pageSize();
+	this->_page	= 0;
+	this->_used	= 0;
+	this->_value	= 0;
+}
+
+
+//
+// Current page: the one with the highest valid head
+// returns 0 = OK otherwise error
+//
+int I2C_eepromCounter::begin() {
+uint8_t		buf[I2C_EEPROM_PAGEMAX];
+uint32_t	v, n;
+bool		found = false;
+uint16_t	lo, hi;
+
+	if (_pages == 0 || _pageSize <= I2C_EEPROM_COUNTER_HEAD || _pageSize > I2C_EEPROM_PAGEMAX)
+		return I2C_EEPROM_ERR_RANGE;
+	if (_addr(_pages) > (uint32_t)_ee->get_pages() * _pageSize) return I2C_EEPROM_ERR_RANGE;
+
+	for (uint16_t p=0; p<_pages; p++) {
+		if (_ee->readBlock(_addr(p), buf, I2C_EEPROM_COUNTER_HEAD) != I2C_EEPROM_COUNTER_HEAD)
+			return I2C_EEPROM_ERR_READ;
+
+		memcpy(&v, buf, 4);
+		memcpy(&n, buf + 4, 4);
+		if (v != ~n) continue;
+
+		if (!found || v > _value) {
+			_value	= v;
+			_page	= p;
+			found	= true;
+		}
+	}
+	if (!found) return format(0);
+
+	if (_ee->readBlock(_addr(_page), buf, _pageSize) != _pageSize) return I2C_EEPROM_ERR_READ;
+
+	// First byte not 0x00 ... binary search
+	lo = I2C_EEPROM_COUNTER_HEAD;
+	hi = _pageSize;
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) / 2;
+
+		if (buf[mid] == 0x00) lo = mid + 1;
+		else hi = mid;
+	}
+	_used = (lo - I2C_EEPROM_COUNTER_HEAD) * 8;
+	if (lo < _pageSize)
+		for (uint8_t b = ~buf[lo]; b; b >>= 1) _used += b & 1;
+
+	_value += _used;
+	return 0;
+}
+
+
+//
+// Page 0 starts at <value>, the heads of all others are erased
+// returns 0 = OK otherwise error
+//
+int I2C_eepromCounter::format(const uint32_t value) {
+int rv;
+
+	if (_pages == 0 || _pageSize <= I2C_EEPROM_COUNTER_HEAD || _pageSize > I2C_EEPROM_PAGEMAX)
+		return I2C_EEPROM_ERR_RANGE;
+
+	for (uint16_t p=1; p<_pages; p++) {
+		rv = _ee->setBlock(_addr(p), 0xFF, I2C_EEPROM_COUNTER_HEAD);
+		if (rv != 0) return rv;
+	}
+	return _startPage(0, value);
+}
+
+
+//
+// One count: a byte write; a page write when the page is used up
+// returns 0 = OK otherwise error
+//
+int I2C_eepromCounter::increment() {
+uint16_t	at;
+int		rv;
+
+	if (_used == get_perPage())
+		return _startPage((_page + 1) % _pages, _value + 1);
+
+	at = I2C_EEPROM_COUNTER_HEAD + _used / 8;
+	rv = _ee->writeByte(_addr(_page) + at, 0xFF << (_used % 8 + 1));
+	if (rv != 0) return rv;
+
+	_used++;
+	_value++;
+	return 0;
+}
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromCounter::value()	{ return _value;	}
+uint16_t	I2C_eepromCounter::get_page()	{ return _page;		}
+uint16_t	I2C_eepromCounter::get_perPage(){ return (_pageSize - I2C_EEPROM_COUNTER_HEAD) * 8; }
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+uint32_t I2C_eepromCounter::_addr(const uint16_t page) {
+	return _base + (uint32_t)page * _pageSize;
+}
+
+
+//
+// Erased unary part first, the head after it as a transaction of its own.
+// The bus splits a page into chunks: with the head in the first one a
+// power loss after it would leave a good head over 0x00 bytes of the lap
+// before. The head's transaction only starts when the PROM answers again,
+// i.e. with the erase programmed; until it is, an old head of this page
+// is lower than the current page's and does not win in begin().
+//
+int I2C_eepromCounter::_startPage(const uint16_t page, const uint32_t value) {
+uint8_t		head[I2C_EEPROM_COUNTER_HEAD];
+uint32_t	n = ~value;
+int		rv;
+
+	rv = _ee->setBlock(_addr(page) + I2C_EEPROM_COUNTER_HEAD, 0xFF, _pageSize - I2C_EEPROM_COUNTER_HEAD);
+	if (rv != 0) return rv;
+
+	memcpy(head, &value, 4);
+	memcpy(head + 4, &n, 4);
+	rv = _ee->writeBlock(_addr(page), head, I2C_EEPROM_COUNTER_HEAD);
+	if (rv != 0) return rv;
+
+	_page	= page;
+	_used	= 0;
+	_value	= value;
+	return 0;
+}
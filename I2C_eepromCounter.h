@@ -0,0 +1,72 @@
+#ifndef I2C_EEPROM_COUNTER_H
+#define I2C_EEPROM_COUNTER_H
+//
+//    FILE: I2C_eepromCounter.h
+// PURPOSE: Wear spreading monotonic counter over I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// The counter lives in <pages> PROM pages (pageSize 16 and up), used in turn:
+//
+//	| value (4) | ~value (4) | unary: one bit cleared per count ... |
+//
+// The current page holds the count it was started with; every increment
+// clears the next bit of the unary part, a single byte write. When the page
+// is used up the next one gets an erased unary part and then, in a write of
+// its own, the head with the new count. On a 24x256 (64 byte page) that is
+// two writes per 448 counts, and the wear goes round all <pages>.
+//
+// begin() reads the 8 byte head of every page and the current page once;
+// after that value() is a RAM read and increment() needs no read at all.
+// A power loss while changing pages leaves the page before current: a torn
+// erase sits behind that page's old (lower) head, a torn head does not check.
+// The head only goes out once the erase is programmed.
+//
+//	I2C_eepromCounter boots(ee, 0x7E00, 8);	// last 8 pages of a 24x256
+//	boots.begin();				// formats to 0 if there is no counter
+//	boots.increment();
+//	Serial.println(boots.value());
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_COUNTER_HEAD	8	// value, ~value
+
+
+class I2C_eepromCounter {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <pages> PROM pages from <base> (page aligned) on; 2 and up survive a power loss while changing pages
+     */
+    I2C_eepromCounter(I2C_eeprom& ee, const uint16_t base, const uint16_t pages);
+
+    int		begin(void);			// find the current page; format(0) if there is none
+    int		format(const uint32_t value);	// start over at <value>
+
+    int		increment(void);
+    uint32_t	value(void);
+
+    uint16_t	get_page(void);			// current page
+    uint16_t	get_perPage(void);		// counts per page
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pages;
+    uint16_t	_pageSize;
+    uint16_t	_page;			// current page
+    uint16_t	_used;			// bits cleared in the current page
+    uint32_t	_value;
+
+    uint32_t	_addr(const uint16_t page);
+    int		_startPage(const uint16_t page, const uint32_t value);
+};
+#endif
@@ -0,0 +1,245 @@
+//
+//    FILE:	I2C_eepromECC.cpp
+// PURPOSE:	Error correcting region on top of I2C_eepromV2
+//
+// Parity of a block of n bytes, b = bits of the byte index (n <= 256):
+//	line parity	XOR of the indices of all bytes with odd parity (b bits)
+//	line parity'	same with the indices inverted
+//	column parity	P1 P1' P2 P2' P4 P4' over all bytes (6 bits)
+// A single flipped bit changes exactly one of each pair; the line pairs then
+// give the byte, the column pairs the bit.
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromECC.h>
+
+//
+// Per byte value: bit 0..5 column parity P1 P1' P2 P2' P4 P4', bit 6 parity of the byte
+//
+static const uint8_t _eccTable[256] PROGMEM = {
+	0x00, 0x6a, 0x69, 0x03, 0x66, 0x0c, 0x0f, 0x65, 0x65, 0x0f, 0x0c, 0x66, 0x03, 0x69, 0x6a, 0x00,
+	0x5a, 0x30, 0x33, 0x59, 0x3c, 0x56, 0x55, 0x3f, 0x3f, 0x55, 0x56, 0x3c, 0x59, 0x33, 0x30, 0x5a,
+	0x59, 0x33, 0x30, 0x5a, 0x3f, 0x55, 0x56, 0x3c, 0x3c, 0x56, 0x55, 0x3f, 0x5a, 0x30, 0x33, 0x59,
+	0x03, 0x69, 0x6a, 0x00, 0x65, 0x0f, 0x0c, 0x66, 0x66, 0x0c, 0x0f, 0x65, 0x00, 0x6a, 0x69, 0x03,
+	0x56, 0x3c, 0x3f, 0x55, 0x30, 0x5a, 0x59, 0x33, 0x33, 0x59, 0x5a, 0x30, 0x55, 0x3f, 0x3c, 0x56,
+	0x0c, 0x66, 0x65, 0x0f, 0x6a, 0x00, 0x03, 0x69, 0x69, 0x03, 0x00, 0x6a, 0x0f, 0x65, 0x66, 0x0c,
+	0x0f, 0x65, 0x66, 0x0c, 0x69, 0x03, 0x00, 0x6a, 0x6a, 0x00, 0x03, 0x69, 0x0c, 0x66, 0x65, 0x0f,
+	0x55, 0x3f, 0x3c, 0x56, 0x33, 0x59, 0x5a, 0x30, 0x30, 0x5a, 0x59, 0x33, 0x56, 0x3c, 0x3f, 0x55,
+	0x55, 0x3f, 0x3c, 0x56, 0x33, 0x59, 0x5a, 0x30, 0x30, 0x5a, 0x59, 0x33, 0x56, 0x3c, 0x3f, 0x55,
+	0x0f, 0x65, 0x66, 0x0c, 0x69, 0x03, 0x00, 0x6a, 0x6a, 0x00, 0x03, 0x69, 0x0c, 0x66, 0x65, 0x0f,
+	0x0c, 0x66, 0x65, 0x0f, 0x6a, 0x00, 0x03, 0x69, 0x69, 0x03, 0x00, 0x6a, 0x0f, 0x65, 0x66, 0x0c,
+	0x56, 0x3c, 0x3f, 0x55, 0x30, 0x5a, 0x59, 0x33, 0x33, 0x59, 0x5a, 0x30, 0x55, 0x3f, 0x3c, 0x56,
+	0x03, 0x69, 0x6a, 0x00, 0x65, 0x0f, 0x0c, 0x66, 0x66, 0x0c, 0x0f, 0x65, 0x00, 0x6a, 0x69, 0x03,
+	0x59, 0x33, 0x30, 0x5a, 0x3f, 0x55, 0x56, 0x3c, 0x3c, 0x56, 0x55, 0x3f, 0x5a, 0x30, 0x33, 0x59,
+	0x5a, 0x30, 0x33, 0x59, 0x3c, 0x56, 0x55, 0x3f, 0x3f, 0x55, 0x56, 0x3c, 0x59, 0x33, 0x30, 0x5a,
+	0x00, 0x6a, 0x69, 0x03, 0x66, 0x0c, 0x0f, 0x65, 0x65, 0x0f, 0x0c, 0x66, 0x03, 0x69, 0x6a, 0x00,
+};
+
+#define ECC_PARITY	0x40
+#define ECC_COLUMN	0x3F
+
+
+//
+// Constructor ...
+//
+I2C_eepromECC::I2C_eepromECC(I2C_eeprom& ee, const uint16_t base, const uint16_t pages) {
+	this->_ee		= &ee;
+	this->_base		= base;
+	this->_pages		= pages;
+	this->_pageSize		= ee.get_pageSize();
+	this->_data		= _pageSize - I2C_EEPROM_ECC_BYTES;
+	this->_corrected	= 0;
+	this->_uncorrectable	= 0;
+}
+
+
+//
+// Write <length> bytes @ <address>; page parts are read, corrected, merged
+// and written back as whole pages
+// returns 0 = OK otherwise error (I2C_EEPROM_ERR_ECC: part of an uncorrectable
+// page, not written ... rewrite the whole page to recover it)
+//
+int I2C_eepromECC::write(const uint16_t address, const uint8_t* buffer, const uint16_t length) {
+uint8_t		page[I2C_EEPROM_PAGEMAX];
+uint32_t	addr = address;
+uint16_t	len  = length;
+bool		fixed;
+int		rv;
+
+	if (_pageSize > I2C_EEPROM_PAGEMAX) return I2C_EEPROM_ERR_RANGE;
+	if (addr + len > get_size()) return I2C_EEPROM_ERR_RANGE;
+
+	while (len > 0) {
+		uint16_t p   = addr / _data;
+		uint16_t off = addr % _data;
+		uint16_t cnt = min(len, (uint16_t)(_data - off));
+
+		// Whole page new: no need to read the old one. Else the old one
+		// must be good: new parity over corrupt bytes would pass them
+		// as valid from then on (_readPage() counts the uncorrectable)
+		if (cnt < _data) {
+			rv = _readPage(p, page, &fixed);
+			if (rv != 0) return rv;
+		}
+		memcpy(page + off, buffer, cnt);
+		encode(page, _data, page + _data);
+
+		rv = _ee->writeBlock(_base + (uint32_t)p * _pageSize, page, _pageSize);
+		if (rv != 0) return rv;
+
+		addr	+= cnt;
+		buffer	+= cnt;
+		len	-= cnt;
+	}
+	return 0;
+}
+
+
+//
+// Read <length> bytes @ <address>, single bit errors corrected
+// returns 0 = OK, I2C_EEPROM_ERR_ECC (data delivered as read) otherwise error
+//
+int I2C_eepromECC::read(const uint16_t address, uint8_t* buffer, const uint16_t length) {
+uint8_t		page[I2C_EEPROM_PAGEMAX];
+uint32_t	addr = address;
+uint16_t	len  = length;
+bool		fixed;
+int		rv = 0;
+
+	if (_pageSize > I2C_EEPROM_PAGEMAX) return I2C_EEPROM_ERR_RANGE;
+	if (addr + len > get_size()) return I2C_EEPROM_ERR_RANGE;
+
+	while (len > 0) {
+		uint16_t off = addr % _data;
+		uint16_t cnt = min(len, (uint16_t)(_data - off));
+		int	 r   = _readPage(addr / _data, page, &fixed);
+
+		if (r == I2C_EEPROM_ERR_READ) return r;
+		if (r != 0) rv = r;
+		memcpy(buffer, page + off, cnt);
+
+		addr	+= cnt;
+		buffer	+= cnt;
+		len	-= cnt;
+	}
+	return rv;
+}
+
+
+//
+// Read every page; those with a corrected bit are written back
+// returns 0 = OK otherwise the first error
+//
+int I2C_eepromECC::scrub() {
+uint8_t	page[I2C_EEPROM_PAGEMAX];
+bool	fixed;
+int	rv = 0;
+
+	for (uint16_t p=0; p<_pages; p++) {
+		int r = _readPage(p, page, &fixed);
+
+		if (r == 0 && fixed)
+			r = _ee->writeBlock(_base + (uint32_t)p * _pageSize, page, _pageSize);
+		if (r != 0 && rv == 0) rv = r;
+	}
+	return rv;
+}
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromECC::get_size()		{ return (uint32_t)_pages * _data;	}
+uint16_t	I2C_eepromECC::get_dataPerPage()	{ return _data;				}
+uint32_t	I2C_eepromECC::get_corrected()		{ return _corrected;			}
+uint32_t	I2C_eepromECC::get_uncorrectable()	{ return _uncorrectable;		}
+
+
+//
+// Parity of <length> bytes @ <data> to <ecc>, stored inverted
+//
+void I2C_eepromECC::encode(const uint8_t* data, const uint16_t length, uint8_t* ecc) {
+uint8_t	line = 0, lineN = 0, column = 0;
+uint8_t	mask = 0;
+
+	while ((uint16_t)mask + 1 < length) mask = (mask << 1) | 1;
+
+	for (uint16_t i=0; i<length; i++) {
+		uint8_t t = pgm_read_byte(&_eccTable[data[i]]);
+
+		column ^= t;
+		if (t & ECC_PARITY) {
+			line  ^= i;
+			lineN ^= ~i & mask;
+		}
+	}
+	ecc[0] = ~line;
+	ecc[1] = ~lineN;
+	ecc[2] = ~(column & ECC_COLUMN);
+}
+
+
+//
+// Check <length> bytes @ <data> against <ecc>; a single bit error is fixed
+// returns bits corrected (0, 1); -1 = uncorrectable
+//
+int I2C_eepromECC::correct(uint8_t* data, const uint16_t length, const uint8_t* ecc) {
+uint8_t	calc[I2C_EEPROM_ECC_BYTES];
+uint8_t	s0, s1, s2;
+uint8_t	mask = 0;
+uint8_t	bits = 0;
+
+	while ((uint16_t)mask + 1 < length) mask = (mask << 1) | 1;
+
+	encode(data, length, calc);
+	s0 = calc[0] ^ ecc[0];
+	s1 = calc[1] ^ ecc[1];
+	s2 = calc[2] ^ ecc[2];
+	if ((s0 | s1 | s2) == 0) return 0;
+
+	// One bit: each pair differs in exactly one of its two
+	if ((s0 ^ s1) == mask && (((s2 >> 1) ^ s2) & 0x15) == 0x15) {
+		uint8_t bit = (s2 & 0x01) | ((s2 >> 1) & 0x02) | ((s2 >> 2) & 0x04);
+
+		if (s0 >= length) return -1;
+		data[s0] ^= 1 << bit;
+		return 1;
+	}
+
+	// A single flipped bit in the parity bytes themselves: data fine
+	for (uint8_t i=0; i<8; i++) bits += ((s0 >> i) & 1) + ((s1 >> i) & 1) + ((s2 >> i) & 1);
+	return (bits == 1) ? 0 : -1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// Whole page <page> to <buffer>, data corrected; <fixed>: a bit was
+// returns 0 = OK, I2C_EEPROM_ERR_ECC, I2C_EEPROM_ERR_READ
+//
+int I2C_eepromECC::_readPage(const uint16_t page, uint8_t* buffer, bool* fixed) {
+int r;
+
+	*fixed = false;
+	if (_ee->readBlock(_base + (uint32_t)page * _pageSize, buffer, _pageSize) != _pageSize)
+		return I2C_EEPROM_ERR_READ;
+
+	r = correct(buffer, _data, buffer + _data);
+	if (r < 0) {
+		_uncorrectable++;
+		return I2C_EEPROM_ERR_ECC;
+	}
+	if (r > 0) {
+		_corrected += r;
+		*fixed = true;
+	}
+	return 0;
+}
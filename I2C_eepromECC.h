@@ -0,0 +1,79 @@
+#ifndef I2C_EEPROM_ECC_H
+#define I2C_EEPROM_ECC_H
+//
+//    FILE: I2C_eepromECC.h
+// PURPOSE: Error correcting region on top of I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Each PROM page of the region keeps 3 parity bytes behind its data:
+//
+//	| data (pageSize - 3) | line parity | line parity' | column parity |
+//
+// Hamming code as used for NAND flash (SmartMedia): a single bit error per
+// page is corrected, two are detected. The kernel costs one table lookup
+// (PROGMEM) and a few XORs per byte. Parity is stored inverted, so an erased
+// page (all 0xFF) reads as valid.
+//
+// Reads correct on the fly; writes of part of a page read, correct and
+// rewrite the whole page (one page write, parity included). Such a write to
+// a page with an uncorrectable error fails with I2C_EEPROM_ERR_ECC; only a
+// write of the whole page replaces it.
+//
+//	I2C_eepromECC	ecc(ee, 0x1000, 64);	// 64 pages from 0x1000 on
+//
+//	ecc.write(0, buf, len);			// logical addresses, get_size() bytes
+//	rv = ecc.read(0, buf, len);		// I2C_EEPROM_ERR_ECC: uncorrectable
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_ECC_BYTES	3	// per page
+
+
+class I2C_eepromECC {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <pages> PROM pages from <base> (page aligned) on
+     */
+    I2C_eepromECC(I2C_eeprom& ee, const uint16_t base, const uint16_t pages);
+
+    int		write(		const uint16_t	address,
+				const uint8_t*	buffer,
+				const uint16_t	length);
+
+    int		read(		const uint16_t	address,
+				      uint8_t*	buffer,
+				const uint16_t	length);
+
+    int		scrub(void);			// rewrite pages holding a corrected bit
+
+    uint32_t	get_size(void);			// data bytes
+    uint16_t	get_dataPerPage(void);
+    uint32_t	get_corrected(void);		// bits corrected
+    uint32_t	get_uncorrectable(void);	// pages beyond repair
+
+    // Kernel ... <ecc> gets I2C_EEPROM_ECC_BYTES
+    static void	encode(const uint8_t* data, const uint16_t length, uint8_t* ecc);
+    static int	correct(uint8_t* data, const uint16_t length, const uint8_t* ecc);	// bits fixed; -1 = uncorrectable
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pages;
+    uint16_t	_pageSize;
+    uint16_t	_data;			// data bytes per page
+    uint32_t	_corrected;
+    uint32_t	_uncorrectable;
+
+    int		_readPage(const uint16_t page, uint8_t* buffer, bool* fixed);
+};
+#endif
@@ -0,0 +1,261 @@
+//
+//    FILE:	I2C_eepromGroup.cpp
+// PURPOSE:	PROMs on one or more buses striped into one address space
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromGroup.h>
+#ifdef I2C_EEPROM_PTHREAD
+#include <sched.h>
+#endif
+
+
+//
+// Constructor ...
+//
+I2C_eepromGroup::I2C_eepromGroup(const uint16_t stripe) {
+	this->_members	  = 0;
+	this->_buses	  = 0;
+	this->_stripe	  = stripe;
+	this->_pageStripe = stripe == 0;
+	this->_memberSize = 0;
+	this->_tasks	  = true;
+	this->_rv	  = 0;
+
+#ifdef I2C_EEPROM_FREERTOS
+	this->_ended	  = xSemaphoreCreateCounting(I2C_EEPROM_GROUP_MAX, 0);
+#endif
+}
+
+I2C_eepromGroup::~I2C_eepromGroup() {
+	for (uint8_t m=0; m<_members; m++) delete _job[m];
+#ifdef I2C_EEPROM_FREERTOS
+	vSemaphoreDelete(_ended);
+#endif
+}
+
+
+//
+// Next member ... stripes are dealt out in order of add()
+// returns false = group full or <ee> not begin()ed
+//
+bool I2C_eepromGroup::add(I2C_eeprom& ee) {
+uint8_t		b;
+uint32_t	bytes = (uint32_t)ee.get_pages() * ee.get_pageSize();
+
+	if (_members == I2C_EEPROM_GROUP_MAX || bytes == 0) return false;
+
+	for (b=0; b<_buses && _bus[b] != ee.get_bus(); b++) ;
+	if (b == _buses) _bus[_buses++] = ee.get_bus();
+
+	_ee[_members]	 = &ee;
+	_job[_members]	 = new I2C_eepromAsync(ee);
+	_busOf[_members] = b;
+	_members++;
+
+	if (_pageStripe && ee.get_pageSize() > _stripe) _stripe = ee.get_pageSize();
+
+	_memberSize = 0xFFFFFFFF;
+	for (uint8_t m=0; m<_members; m++)
+		_memberSize = min(_memberSize, (uint32_t)_ee[m]->get_pages() * _ee[m]->get_pageSize());
+	_memberSize -= _memberSize % _stripe;
+	return true;
+}
+
+
+//
+// Write / read <length> bytes @ group <address>; all members at once
+// returns 0 = OK otherwise the first error
+//
+int I2C_eepromGroup::write(const uint32_t address, const uint8_t* buffer, const uint32_t length) {
+	return _transfer(true, address, (uint8_t*)buffer, length);
+}
+
+int I2C_eepromGroup::read(const uint32_t address, uint8_t* buffer, const uint32_t length) {
+	return _transfer(false, address, buffer, length);
+}
+
+
+#ifdef I2C_EEPROM_THREADS
+void I2C_eepromGroup::setTasks(const bool on) {
+	_tasks = on;
+}
+#endif
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromGroup::get_size()		{ return _memberSize * _members;	}
+uint16_t	I2C_eepromGroup::get_stripe()		{ return _stripe;			}
+uint8_t		I2C_eepromGroup::get_members()		{ return _members;			}
+uint8_t		I2C_eepromGroup::get_buses()		{ return _buses;			}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+int I2C_eepromGroup::_transfer(const bool writing, const uint32_t address, uint8_t* buffer, const uint32_t length) {
+uint32_t first = address / _stripe;
+
+	if (_members == 0 || address + length > get_size()) return I2C_EEPROM_ERR_RANGE;
+	if (length == 0) return 0;
+
+	_writing = writing;
+	_address = address;
+	_buffer	 = buffer;
+	_end	 = address + length;
+	_rv	 = 0;
+
+	// First stripe of each member at or after the one holding <address>
+	for (uint8_t m=0; m<_members; m++) {
+		_next[m]    = first + (m + _members - first % _members) % _members;
+		_started[m] = false;
+	}
+
+#ifdef I2C_EEPROM_THREADS
+	if (_tasks && _buses > 1) {
+		uint8_t started = 0;
+#ifndef I2C_EEPROM_FREERTOS
+		pthread_t thread[I2C_EEPROM_GROUP_MAX];
+#endif
+
+		for (uint8_t b=1; b<_buses; b++) {
+			_runner[b].group = this;
+			_runner[b].bus	 = b;
+#ifdef I2C_EEPROM_FREERTOS
+			if (xTaskCreate(_main, "I2C_eepromGroup", I2C_EEPROM_GROUP_STACK, &_runner[b], uxTaskPriorityGet(NULL), NULL) != pdPASS) break;
+#else
+			if (pthread_create(&thread[b], NULL, _main, &_runner[b]) != 0) break;
+#endif
+			started++;
+		}
+		// This task serves bus 0 ... and those no task could be started for
+		_serve(0);
+		for (uint8_t b=1 + started; b<_buses; b++) _serve(b);
+
+		for (uint8_t b=1; b<=started; b++)
+#ifdef I2C_EEPROM_FREERTOS
+			xSemaphoreTake(_ended, portMAX_DELAY);
+#else
+			pthread_join(thread[b], NULL);
+#endif
+		return _rv;
+	}
+#endif
+
+	_serve(I2C_EEPROM_GROUP_MAX);
+	return _rv;
+}
+
+
+#ifdef I2C_EEPROM_THREADS
+#ifdef I2C_EEPROM_FREERTOS
+void I2C_eepromGroup::_main(void* runner) {
+I2C_eepromGroupRunner* r = (I2C_eepromGroupRunner*)runner;
+
+	r->group->_serve(r->bus);
+	xSemaphoreGive(r->group->_ended);
+	vTaskDelete(NULL);
+}
+#else
+void* I2C_eepromGroup::_main(void* runner) {
+I2C_eepromGroupRunner* r = (I2C_eepromGroupRunner*)runner;
+
+	r->group->_serve(r->bus);
+	return NULL;
+}
+#endif
+#endif
+
+
+//
+// Poll the jobs of the members on <bus> in turn, each starting its next
+// stripe when done, until none is left. Tasks yield after each round: most
+// polls are write cycle polls, the other buses may have data to move
+//
+void I2C_eepromGroup::_serve(const uint8_t bus) {
+bool busy = true;
+
+	while (busy) {
+		busy = false;
+		for (uint8_t m=0; m<_members; m++) {
+			if (bus != I2C_EEPROM_GROUP_MAX && _busOf[m] != bus) continue;
+
+			if (_job[m]->poll()) {
+				busy = true;
+				continue;
+			}
+			// A job's result stays until the next: only one of this transfer counts
+			if (_started[m] && _job[m]->result() != 0) _fail(_job[m]->result());
+			_started[m] = _start(m);
+			if (_started[m]) busy = true;
+		}
+#ifdef I2C_EEPROM_FREERTOS
+		if (bus != I2C_EEPROM_GROUP_MAX) taskYIELD();
+#elif defined(I2C_EEPROM_PTHREAD)
+		if (bus != I2C_EEPROM_GROUP_MAX) sched_yield();
+#endif
+	}
+}
+
+
+//
+// Start the next stripe of member <m> ... none after an error
+// returns true = started
+//
+bool I2C_eepromGroup::_start(const uint8_t m) {
+uint32_t	s = _next[m];
+uint32_t	lo = max(_address, s * _stripe);
+uint32_t	hi = min(_end, (s + 1) * _stripe);
+uint16_t	local;
+int		rv;
+
+	if (_result() != 0 || lo >= hi) return false;
+	_next[m] += _members;
+
+	local = (s / _members) * _stripe + (lo - s * _stripe);
+	if (_writing)
+		rv = _job[m]->startWrite(local, _buffer + (lo - _address), hi - lo);
+	else
+		rv = _job[m]->startRead(local, _buffer + (lo - _address), hi - lo);
+
+	if (rv != 0) {
+		_fail(rv);
+		return false;
+	}
+	return true;
+}
+
+
+//
+// First error of the transfer ... set and read by the tasks of all buses
+//
+void I2C_eepromGroup::_fail(const int rv) {
+#ifdef I2C_EEPROM_THREADS
+	_lock.lock();
+#endif
+	if (_rv == 0) _rv = rv;
+#ifdef I2C_EEPROM_THREADS
+	_lock.unlock();
+#endif
+}
+
+int I2C_eepromGroup::_result() {
+int rv;
+
+#ifdef I2C_EEPROM_THREADS
+	_lock.lock();
+#endif
+	rv = _rv;
+#ifdef I2C_EEPROM_THREADS
+	_lock.unlock();
+#endif
+	return rv;
+}
@@ -0,0 +1,106 @@
+#ifndef I2C_EEPROM_GROUP_H
+#define I2C_EEPROM_GROUP_H
+//
+//    FILE: I2C_eepromGroup.h
+// PURPOSE: PROMs on one or more buses striped into one address space
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Stripe n of the group lives on member n % members, so a large transfer
+// keeps all of them going: each member runs an I2C_eepromAsync job and they
+// are polled in turn, so their 5 ms write cycles overlap. Members on other
+// controllers (Wire1, ...) transfer at the same time where there are tasks
+// (ESP32, Linux: one per bus, see I2C_eepromThread.h), or on buses that move
+// the bytes in the background (I2C_eepromTWI, see I2C_eepromBus.h): poll()
+// then only hands each transaction over. Without either (SAMD, AVR on Wire)
+// every poll() waits for its transaction, so the buses take turns and reads
+// get no faster than on one bus; writes still gain from the write cycles.
+//
+//	I2C_eepromWire	bus1(Wire1);
+//	I2C_eeprom	ee0(0x50, 256), ee1(0x51, 256);	// on Wire
+//	I2C_eeprom	ee2(bus1, 0x50, 256), ee3(bus1, 0x51, 256);
+//	I2C_eepromGroup	group;				// stripe: largest page
+//
+//	group.add(ee0); group.add(ee2); group.add(ee1); group.add(ee3);
+//	group.write(0, image, sizeof(image));		// 4 x 32 KB as one
+//
+// Members begin()ed by the caller; add() them alternating between buses so
+// neighbouring stripes go to different ones.
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromAsync.h>
+#include <I2C_eepromThread.h>
+
+#define I2C_EEPROM_GROUP_MAX	8	// members
+#define I2C_EEPROM_GROUP_STACK	2048	// FreeRTOS task stack per extra bus [bytes]
+
+
+class I2C_eepromGroup {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromGroup(const uint16_t stripe = 0);	// bytes; 0 = largest page of the members
+    ~I2C_eepromGroup();
+
+    bool	add(I2C_eeprom& ee);
+
+    int		write(const uint32_t address, const uint8_t* buffer, const uint32_t length);
+    int		read(const uint32_t address, uint8_t* buffer, const uint32_t length);
+
+#ifdef I2C_EEPROM_THREADS
+    void	setTasks(const bool on);	// one task per bus (default) or all in the caller's
+#endif
+
+    uint32_t	get_size(void);
+    uint16_t	get_stripe(void);
+    uint8_t	get_members(void);
+    uint8_t	get_buses(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee[I2C_EEPROM_GROUP_MAX];
+    I2C_eepromAsync* _job[I2C_EEPROM_GROUP_MAX];
+    uint8_t	_busOf[I2C_EEPROM_GROUP_MAX];	// index into _bus
+    I2C_eepromBus* _bus[I2C_EEPROM_GROUP_MAX];
+    uint8_t	_members;
+    uint8_t	_buses;
+    uint16_t	_stripe;
+    bool	_pageStripe;			// _stripe follows the largest page
+    uint32_t	_memberSize;			// bytes used on each member
+    bool	_tasks;
+
+    // Transfer in progress
+    bool	_writing;
+    uint32_t	_address;
+    uint8_t*	_buffer;
+    uint32_t	_end;
+    uint32_t	_next[I2C_EEPROM_GROUP_MAX];	// next stripe per member
+    bool	_started[I2C_EEPROM_GROUP_MAX];	// member's job is one of this transfer
+    int		_rv;
+
+#ifdef I2C_EEPROM_THREADS
+    I2C_eepromMutex _lock;			// guards _rv
+    struct I2C_eepromGroupRunner {
+	I2C_eepromGroup* group;
+	uint8_t		bus;
+    } _runner[I2C_EEPROM_GROUP_MAX];
+#ifdef I2C_EEPROM_FREERTOS
+    SemaphoreHandle_t _ended;
+    static void	_main(void* runner);
+#else
+    static void* _main(void* runner);
+#endif
+#endif
+
+    int		_transfer(const bool writing, const uint32_t address, uint8_t* buffer, const uint32_t length);
+    void	_serve(const uint8_t bus);		// I2C_EEPROM_GROUP_MAX = all
+    bool	_start(const uint8_t member);
+    void	_fail(const int rv);
+    int		_result(void);
+};
+#endif
@@ -0,0 +1,231 @@
+//
+//    FILE:	I2C_eepromHash.cpp
+// PURPOSE:	Read-mostly hash table in PROM pages for I2C_eepromV2
+//
+// build() keeps I2C_EEPROM_HASH_WINDOW buckets and one page of spill in RAM.
+// Spill out of a window goes first into the next one, ahead of the records
+// of its own, so every record sits in its home bucket or behind a run of
+// full buckets starting there ... which is all find() relies on.
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromHash.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromHash::I2C_eepromHash(I2C_eeprom& ee, const uint16_t base, const uint16_t pages) {
+	this->_ee	 = &ee;
+	this->_base	 = base;
+	this->_pages	 = pages;
+	this->_pageSize	 = ee.get_pageSize();
+	this->_keySize	 = 0;
+	this->_valueSize = 0;
+	this->_buckets	 = 0;
+	this->_home	 = 0;
+	this->_entries	 = 0;
+	this->_lookups	 = 0;
+	this->_pageReads = 0;
+}
+
+
+//
+// returns 0 = OK, I2C_EEPROM_ERR_VERIFY (no table) otherwise error
+//
+int I2C_eepromHash::begin() {
+uint8_t		hdr[I2C_EEPROM_HASH_HEADER];
+uint32_t	crc;
+
+	if (_ee->readBlock(_base, hdr, sizeof(hdr)) != sizeof(hdr)) return _fail(I2C_EEPROM_ERR_READ);
+
+	memcpy(&crc, hdr + 12, sizeof(crc));
+	if (hdr[0] + (hdr[1] << 8) != I2C_EEPROM_HASH_MAGIC
+	 || crc != I2C_eeprom::crc32Update(0, hdr, 12))
+		return _fail(I2C_EEPROM_ERR_VERIFY);
+
+	_keySize   = hdr[2];
+	_valueSize = hdr[3];
+	_buckets   = hdr[4] + (hdr[5] << 8);
+	_home	   = hdr[6] + (hdr[7] << 8);
+	memcpy(&_entries, hdr + 8, sizeof(_entries));
+
+	if (_buckets + 1 > _pages || get_slots() == 0) return _fail(I2C_EEPROM_ERR_VERIFY);
+	return 0;
+}
+
+
+//
+// Write a table of <count> records from <source>; the header goes last
+// returns 0 = OK, I2C_EEPROM_ERR_RANGE (too many records) otherwise error
+//
+int I2C_eepromHash::build(const uint8_t keySize, const uint8_t valueSize, const uint32_t count, I2C_eepromHashSource source, void* ctx) {
+uint8_t		stage[I2C_EEPROM_HASH_WINDOW * I2C_EEPROM_PAGEMAX];
+uint8_t		spill[I2C_EEPROM_PAGEMAX];
+uint8_t		rec[I2C_EEPROM_PAGEMAX];
+uint16_t	spilled = 0;
+uint16_t	recSize = keySize + valueSize;
+uint8_t		slots;
+int		rv;
+
+	if (_pages < 2 || _pageSize > I2C_EEPROM_PAGEMAX || keySize == 0 || recSize >= _pageSize)
+		return I2C_EEPROM_ERR_RANGE;
+	if (_base + (uint32_t)_pages * _pageSize > (uint32_t)_ee->get_pages() * _pageSize)
+		return I2C_EEPROM_ERR_RANGE;
+
+	_keySize   = keySize;
+	_valueSize = valueSize;
+	_buckets   = _pages - 1;
+	_home	   = _buckets - _buckets / 16;
+	_entries   = count;
+	slots	   = get_slots();
+
+	// Old header away first: a torn build leaves no table, here either
+	rv = _ee->setBlock(_base, 0xFF, I2C_EEPROM_HASH_HEADER);
+	if (rv != 0) return _fail(rv);
+
+	for (uint16_t w0=0; w0<_buckets; w0+=I2C_EEPROM_HASH_WINDOW) {
+		uint16_t w1 = min((uint16_t)(w0 + I2C_EEPROM_HASH_WINDOW), _buckets);
+		uint16_t kept = 0;
+
+		memset(stage, 0xFF, sizeof(stage));
+		for (uint16_t b=0; b<w1 - w0; b++) stage[b * _pageSize] = 0;
+
+		// Spill of the window before ... then the records at home here
+		for (uint16_t s=0; s<spilled; s+=recSize) {
+			uint16_t b;
+
+			for (b=0; b<w1 - w0 && stage[b * _pageSize] == slots; b++) ;
+			if (b < w1 - w0) {
+				uint8_t* cnt = &stage[b * _pageSize];
+
+				memcpy(cnt + 1 + *cnt * recSize, spill + s, recSize);
+				(*cnt)++;
+			} else {
+				memmove(spill + kept, spill + s, recSize);
+				kept += recSize;
+			}
+		}
+		spilled = kept;
+
+		for (uint32_t i=0; i<count; i++) {
+			uint16_t home, b;
+
+			source(ctx, i, rec);
+			home = fnv1a(rec, keySize) % _home;
+			if (home < w0 || home >= w1) continue;
+
+			for (b=home - w0; b<w1 - w0 && stage[b * _pageSize] == slots; b++) ;
+			if (b < w1 - w0) {
+				uint8_t* cnt = &stage[b * _pageSize];
+
+				memcpy(cnt + 1 + *cnt * recSize, rec, recSize);
+				(*cnt)++;
+			} else {
+				if (spilled + recSize > sizeof(spill)) return _fail(I2C_EEPROM_ERR_RANGE);
+				memcpy(spill + spilled, rec, recSize);
+				spilled += recSize;
+			}
+		}
+
+		rv = _ee->writeBlock(_bucket(w0), stage, (w1 - w0) * _pageSize);
+		if (rv != 0) return _fail(rv);
+	}
+	if (spilled > 0) return _fail(I2C_EEPROM_ERR_RANGE);
+
+	rv = _writeHeader();
+	return (rv != 0) ? _fail(rv) : 0;
+}
+
+
+//
+// Look <key> up; its value goes to <value> if not NULL
+// returns true = found
+//
+bool I2C_eepromHash::find(const uint8_t* key, uint8_t* value) {
+uint8_t		page[I2C_EEPROM_PAGEMAX];
+uint16_t	recSize = _keySize + _valueSize;
+uint8_t		slots = get_slots();
+
+	if (_buckets == 0) return false;
+	_lookups++;
+
+	for (uint16_t b = fnv1a(key, _keySize) % _home; b<_buckets; b++) {
+		_pageReads++;
+		if (_ee->readBlock(_bucket(b), page, _pageSize) != _pageSize) return false;
+
+		for (uint8_t s=0; s<page[0] && s<slots; s++) {
+			uint8_t* rec = page + 1 + s * recSize;
+
+			if (memcmp(rec, key, _keySize) == 0) {
+				if (value != NULL) memcpy(value, rec + _keySize, _valueSize);
+				return true;
+			}
+		}
+		if (page[0] < slots) break;	// not full ... nothing spilled past
+	}
+	return false;
+}
+
+
+uint32_t I2C_eepromHash::fnv1a(const uint8_t* data, const uint8_t length) {
+uint32_t h = 2166136261UL;
+
+	for (uint8_t i=0; i<length; i++) {
+		h ^= data[i];
+		h *= 16777619UL;
+	}
+	return h;
+}
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromHash::get_entries()	{ return _entries;	}
+uint16_t	I2C_eepromHash::get_buckets()	{ return _buckets;	}
+uint32_t	I2C_eepromHash::get_lookups()	{ return _lookups;	}
+uint32_t	I2C_eepromHash::get_pageReads()	{ return _pageReads;	}
+
+uint8_t I2C_eepromHash::get_slots() {
+	return (_keySize == 0) ? 0 : (_pageSize - 1) / (_keySize + _valueSize);
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+uint32_t I2C_eepromHash::_bucket(const uint16_t b) {
+	return _base + (uint32_t)(b + 1) * _pageSize;
+}
+
+
+//
+// No table: find() misses from now on ... returns <rv>
+//
+int I2C_eepromHash::_fail(const int rv) {
+	_buckets = 0;
+	return rv;
+}
+
+
+int I2C_eepromHash::_writeHeader() {
+uint8_t		hdr[I2C_EEPROM_HASH_HEADER];
+uint32_t	crc;
+
+	hdr[0] = I2C_EEPROM_HASH_MAGIC & 0xFF;	hdr[1] = I2C_EEPROM_HASH_MAGIC >> 8;
+	hdr[2] = _keySize;			hdr[3] = _valueSize;
+	hdr[4] = _buckets & 0xFF;		hdr[5] = _buckets >> 8;
+	hdr[6] = _home & 0xFF;			hdr[7] = _home >> 8;
+	memcpy(hdr + 8, &_entries, sizeof(_entries));
+	crc = I2C_eeprom::crc32Update(0, hdr, 12);
+	memcpy(hdr + 12, &crc, sizeof(crc));
+
+	return _ee->writeBlock(_base, hdr, sizeof(hdr));
+}
@@ -0,0 +1,95 @@
+#ifndef I2C_EEPROM_HASH_H
+#define I2C_EEPROM_HASH_H
+//
+//    FILE: I2C_eepromHash.h
+// PURPOSE: Read-mostly hash table in PROM pages for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Fixed size records (key, value) in page sized buckets:
+//
+//	| header | bucket 0 | bucket 1 | ... | bucket n-1 |
+//	bucket:	| count | key value | key value | ... |
+//
+// A key (FNV-1a) picks its home bucket among the first 15/16 of the buckets;
+// a full bucket spills into the next one, the last 1/16 takes the spill of
+// the end. A lookup reads the home bucket ... one page read; only when that
+// is full and the key not in it, the next page follows. The time stays the
+// same however many keys there are.
+//
+// build() writes the whole table in full pages. It asks the <source> for
+// record <i> (key followed by value) once per window of buckets held in RAM;
+// the source may be a PROGMEM array, a file or a computation. Fill up to
+// about 3/4 of the slots; beyond that runs of full buckets grow and build()
+// may give up with I2C_EEPROM_ERR_RANGE.
+//
+//	void tag(void* ctx, uint32_t i, uint8_t* rec) {
+//		memcpy_P(rec, &tags[i], 4);
+//	}
+//
+//	I2C_eepromHash	ht(ee, 0, 1024);	// 24x512: whole PROM
+//	ht.build(4, 0, tagCount, tag, NULL);	// 4 byte keys, no value
+//	if (ht.find(id)) ...
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_HASH_MAGIC	0x4854		// "HT"
+#define I2C_EEPROM_HASH_HEADER	16
+#define I2C_EEPROM_HASH_WINDOW	4		// buckets per build() pass (stack: 1 page each)
+
+
+typedef void (*I2C_eepromHashSource)(void* ctx, const uint32_t i, uint8_t* record);
+
+
+class I2C_eepromHash {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <pages> PROM pages from <base> (page aligned) on: the header page and the buckets
+     */
+    I2C_eepromHash(I2C_eeprom& ee, const uint16_t base, const uint16_t pages);
+
+    int		begin(void);		// load the header; I2C_EEPROM_ERR_VERIFY: no table
+
+    int		build(		const uint8_t	keySize,
+				const uint8_t	valueSize,
+				const uint32_t	count,
+				I2C_eepromHashSource source,
+				void*		ctx);
+
+    bool	find(const uint8_t* key, uint8_t* value = NULL);
+
+    static uint32_t fnv1a(const uint8_t* data, const uint8_t length);
+
+    uint32_t	get_entries(void);
+    uint16_t	get_buckets(void);
+    uint8_t	get_slots(void);		// records per bucket
+    uint32_t	get_lookups(void);
+    uint32_t	get_pageReads(void);		// by find()
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pages;
+    uint16_t	_pageSize;
+    uint8_t	_keySize;
+    uint8_t	_valueSize;
+    uint16_t	_buckets;
+    uint16_t	_home;			// buckets a key can hash to
+    uint32_t	_entries;
+    uint32_t	_lookups;
+    uint32_t	_pageReads;
+
+    uint32_t	_bucket(const uint16_t b);
+    int		_fail(const int rv);
+    int		_writeHeader(void);
+};
+#endif
@@ -0,0 +1,98 @@
+//
+//    FILE:	I2C_eepromHost.cpp
+// PURPOSE:	The bits of the Arduino core I2C_eepromV2 needs on a (Linux) host
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#ifndef ARDUINO
+
+#include <I2C_eepromHost.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static const I2C_eepromClock_t* _clock = NULL;
+
+void I2C_eepromHost_setClock(const I2C_eepromClock_t* clock) {
+	_clock = clock;
+}
+
+
+uint32_t micros() {
+struct timespec	ts;
+
+	if (_clock != NULL) return _clock->now();
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+uint32_t millis() {
+	return micros() / 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+	if (_clock != NULL)
+		_clock->sleep(us);
+	else
+		usleep(us);
+}
+
+void delay(uint32_t ms) {
+	delayMicroseconds(ms * 1000);
+}
+
+
+//
+// Print
+//
+size_t Print::write(const uint8_t* buffer, size_t length) {
+size_t n = 0;
+
+	while (length-- > 0) n += write(*buffer++);
+	return n;
+}
+
+size_t Print::print(const char* s) {
+	return write((const uint8_t*)s, strlen(s));
+}
+
+size_t Print::print(char c) {
+	return write((uint8_t)c);
+}
+
+size_t Print::print(long v, int base) {
+char buf[24];
+
+	if (base == HEX)
+		snprintf(buf, sizeof(buf), "%lX", (unsigned long)v);
+	else
+		snprintf(buf, sizeof(buf), "%ld", v);
+	return print(buf);
+}
+
+size_t Print::print(unsigned long v, int base) {
+char buf[24];
+
+	snprintf(buf, sizeof(buf), (base == HEX) ? "%lX" : "%lu", v);
+	return print(buf);
+}
+
+
+//
+// I2C_eepromFile
+//
+int I2C_eepromFile::peek() {
+int c = fgetc(_file);
+
+	if (c != EOF) ungetc(c, _file);
+	return c;
+}
+
+int I2C_eepromFile::available() {
+	return (peek() == EOF) ? 0 : 1;
+}
+
+#endif
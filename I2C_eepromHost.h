@@ -0,0 +1,105 @@
+#ifndef I2C_EEPROM_HOST_H
+#define I2C_EEPROM_HOST_H
+//
+//    FILE: I2C_eepromHost.h
+// PURPOSE: The bits of the Arduino core I2C_eepromV2 needs on a (Linux) host
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Pulled in by I2C_eepromV2.h when ARDUINO is not defined: gateways talking to
+// /dev/i2c-N and simulator runs. Time may come from a virtual clock (see
+// I2C_eepromSim) so simulated write cycles cost no wall time.
+//
+// Released to the public domain
+//
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+
+#define DEC	10
+#define HEX	16
+
+#define PROGMEM
+#define PSTR(s)			(s)
+#define pgm_read_byte(p)	(*(const uint8_t*)(p))
+#define pgm_read_word(p)	(*(const uint16_t*)(p))
+#define pgm_read_dword(p)	(*(const uint32_t*)(p))
+
+// As the core's macros: compared and returned in the common type of a and b
+template <class A, class B> inline typename std::common_type<A, B>::type min(A a, B b) {
+	typedef typename std::common_type<A, B>::type T;
+	return ((T)b < (T)a) ? (T)b : (T)a;
+}
+template <class A, class B> inline typename std::common_type<A, B>::type max(A a, B b) {
+	typedef typename std::common_type<A, B>::type T;
+	return ((T)a < (T)b) ? (T)b : (T)a;
+}
+
+
+//
+// Time ... wall clock unless a virtual one is hooked in
+//
+typedef struct {
+	uint32_t	(*now)(void);			// micros
+	void		(*sleep)(uint32_t us);
+} I2C_eepromClock_t;
+
+void		I2C_eepromHost_setClock(const I2C_eepromClock_t* clock);	// NULL = wall clock
+
+uint32_t	micros(void);
+uint32_t	millis(void);
+void		delay(uint32_t ms);
+void		delayMicroseconds(uint32_t us);
+
+
+//
+// Print/Stream ... just what the library uses
+//
+class Print {
+public:
+    virtual size_t	write(uint8_t c) = 0;
+    virtual size_t	write(const uint8_t* buffer, size_t length);
+
+    size_t		print(const char* s);
+    size_t		print(char c);
+    size_t		print(long v, int base = DEC);
+    size_t		print(unsigned long v, int base = DEC);
+    size_t		print(int v, int base = DEC)		{ return print((long)v, base); }
+    size_t		print(unsigned int v, int base = DEC)	{ return print((unsigned long)v, base); }
+    size_t		println(void)				{ return print('\n'); }
+    template <class T> size_t println(T v)			{ return print(v) + println(); }
+    template <class T> size_t println(T v, int base)		{ return print(v, base) + println(); }
+
+    virtual ~Print() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int		available(void) = 0;
+    virtual int		read(void) = 0;
+    virtual int		peek(void) = 0;
+    virtual void	flush(void) {}
+};
+
+
+//
+// A host file as Stream ... i.e. an image for writeStream()
+//
+class I2C_eepromFile : public Stream {
+public:
+    I2C_eepromFile(FILE* file) : _file(file) {}
+
+    size_t	write(uint8_t c)	{ return fputc(c, _file) == EOF ? 0 : 1; }
+    int		available(void);
+    int		read(void)		{ return fgetc(_file); }
+    int		peek(void);
+    void	flush(void)		{ fflush(_file); }
+
+private:
+    FILE*	_file;
+};
+
+#endif
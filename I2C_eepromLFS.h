@@ -0,0 +1,69 @@
+#ifndef I2C_EEPROM_LFS_H
+#define I2C_EEPROM_LFS_H
+//
+//    FILE: I2C_eepromLFS.h
+// PURPOSE: LittleFS on an I2C_eepromBD ... include where lfs.h is available
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Header only: nothing of it is built unless a sketch includes it.
+//
+//	I2C_eepromBD	bd(ee, 0, 0);
+//	lfs_t		lfs;
+//	struct lfs_config cfg;
+//
+//	I2C_eepromLFS_config(&cfg, bd);
+//	if (lfs_mount(&lfs, &cfg) != 0) {
+//		lfs_format(&lfs, &cfg);
+//		lfs_mount(&lfs, &cfg);
+//	}
+//
+// Caches are one page; the buffers are left to lfs (malloc) unless set
+// before mounting.
+//
+// Released to the public domain
+//
+
+#include <lfs.h>
+#include <I2C_eepromBD.h>
+
+#define I2C_EEPROM_LFS_CYCLES	500	// writes to a metadata block before it moves on
+
+
+static inline int I2C_eepromLFS_read(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
+	return ((I2C_eepromBD*)c->context)->read(block, off, (uint8_t*)buffer, size) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static inline int I2C_eepromLFS_prog(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
+	return ((I2C_eepromBD*)c->context)->prog(block, off, (const uint8_t*)buffer, size) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static inline int I2C_eepromLFS_erase(const struct lfs_config* c, lfs_block_t block) {
+	return ((I2C_eepromBD*)c->context)->erase(block) == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static inline int I2C_eepromLFS_sync(const struct lfs_config* c) {
+	return ((I2C_eepromBD*)c->context)->sync() == 0 ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+
+//
+// <cfg> for <bd>: program unit and caches one page, reads of any size
+//
+static inline void I2C_eepromLFS_config(struct lfs_config* cfg, I2C_eepromBD& bd) {
+	memset(cfg, 0, sizeof(*cfg));
+
+	cfg->context	    = &bd;
+	cfg->read	    = I2C_eepromLFS_read;
+	cfg->prog	    = I2C_eepromLFS_prog;
+	cfg->erase	    = I2C_eepromLFS_erase;
+	cfg->sync	    = I2C_eepromLFS_sync;
+
+	cfg->read_size	    = 1;
+	cfg->prog_size	    = bd.get_progSize();
+	cfg->block_size	    = bd.get_blockSize();
+	cfg->block_count    = bd.get_blocks();
+	cfg->cache_size	    = bd.get_progSize();
+	cfg->lookahead_size = 8;
+	cfg->block_cycles   = I2C_EEPROM_LFS_CYCLES;
+}
+#endif
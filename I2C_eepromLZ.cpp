@@ -0,0 +1,352 @@
+//
+//    FILE:	I2C_eepromLZ.cpp
+// PURPOSE:	Compressed frame log on top of I2C_eepromV2
+//
+// Bit stream, MSB first:
+//	1 <8 bit literal>
+//	0 <8 bit distance-1> <4 bit length-2>		... back reference into the frame
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromLZ.h>
+
+//
+// Definitions ... local
+//
+#define LZ_WINDOW	256	// 8 bit distance
+#define LZ_MINMATCH	2	// 13 bits back ref vs. 18 bits for two literals
+#define LZ_MAXMATCH	17	// 4 bit length
+
+#define LZ_CHECK	0x5A
+
+
+//
+// Bit I/O through one TWI chunk of RAM
+//
+typedef struct {
+	I2C_eeprom*	ee;
+	uint16_t	pageSize;
+	uint32_t	addr;		// PROM address of buf[0]
+	uint32_t	left;		// bytes allowed (write) / available (read)
+	uint8_t		buf[I2C_TWIBUFFERSIZE];
+	uint8_t		cnt;
+	uint8_t		pos;
+	uint8_t		acc;
+	uint8_t		nbits;
+	int		rv;
+} LZio;
+
+
+static void _flush(LZio* io) {
+	if (io->cnt > 0 && io->rv == 0)
+		io->rv = io->ee->writeBlock(io->addr, io->buf, io->cnt);
+	io->addr += io->cnt;
+	io->cnt	  = 0;
+}
+
+// Flush level: one write transaction, never across a page boundary
+static uint8_t _cap(LZio* io) {
+uint16_t room = io->pageSize - io->addr % io->pageSize;
+
+	return min(room, I2C_TWIBUFFERSIZE);
+}
+
+static void _putbyte(LZio* io, uint8_t b) {
+	if (io->left == 0) {
+		io->rv = I2C_EEPROM_ERR_RANGE;
+		return;
+	}
+	io->left--;
+	io->buf[io->cnt++] = b;
+	if (io->cnt == _cap(io)) _flush(io);
+}
+
+static void _putbits(LZio* io, uint16_t v, uint8_t n) {
+	while (n-- > 0) {
+		io->acc = (io->acc << 1) | ((v >> n) & 1);
+		if (++io->nbits == 8) {
+			_putbyte(io, io->acc);
+			io->nbits = 0;
+		}
+	}
+}
+
+static uint16_t _getbits(LZio* io, uint8_t n) {
+uint16_t v = 0;
+
+	while (n-- > 0) {
+		if (io->nbits == 0) {
+			if (io->pos == io->cnt) {
+				uint8_t cnt = min(io->left, I2C_TWIBUFFERSIZE);
+				if (cnt == 0 || io->ee->readBlock(io->addr, io->buf, cnt) != cnt) {
+					io->rv = I2C_EEPROM_ERR_READ;
+					return 0;
+				}
+				io->addr += cnt;
+				io->left -= cnt;
+				io->cnt	  = cnt;
+				io->pos	  = 0;
+			}
+			io->acc	  = io->buf[io->pos++];
+			io->nbits = 8;
+		}
+		v = (v << 1) | ((io->acc >> --io->nbits) & 1);
+	}
+	return v;
+}
+
+
+//
+// Constructor ...
+//
+I2C_eepromLZ::I2C_eepromLZ(I2C_eeprom& ee, const uint16_t base, const uint32_t size) {
+	this->_ee	= &ee;
+	this->_base	= base;
+	this->_size	= size;
+	this->_tail	= 0;
+	this->_frames	= 0;
+	this->_raw	= 0;
+	this->_stored	= 0;
+	this->_curFrame	= 0;
+	this->_curPos	= 0;
+}
+
+
+//
+// Walk the frame headers to find the end of the log
+//
+int I2C_eepromLZ::begin() {
+uint16_t raw, stored;
+
+	_tail = _frames = 0;
+	_raw  = _stored = 0;
+	_curFrame = _curPos = 0;
+
+	while (_header(_tail, &raw, &stored)) {
+		uint32_t next = _next(_tail, stored);
+
+		_raw	+= raw;
+		_stored	+= next - _tail;
+		_frames++;
+		_tail	 = next;
+	}
+	return _frames;
+}
+
+
+int I2C_eepromLZ::format() {
+	_tail = _frames = 0;
+	_raw  = _stored = 0;
+	_curFrame = _curPos = 0;
+
+	return _ee->setBlock(_base, 0xFF, I2C_EEPROM_LZ_HEADER);
+}
+
+
+//
+// Compress <buffer> into a new frame
+//
+// Data first, then the end mark behind it, the header last: a frame is there
+// completely or not at all.
+// returns 0 = OK otherwise error (I2C_EEPROM_ERR_RANGE: region full)
+//
+int I2C_eepromLZ::append(const uint8_t* buffer, const uint16_t length) {
+LZio		io;
+uint8_t		hdr[I2C_EEPROM_LZ_HEADER];
+uint32_t	room;
+uint16_t	stored;
+uint16_t	i = 0;
+int		rv;
+
+	if (length == 0 || length > I2C_EEPROM_LZ_MAXFRAME) return I2C_EEPROM_ERR_RANGE;
+	if (_tail + I2C_EEPROM_LZ_HEADER >= _size) return I2C_EEPROM_ERR_RANGE;
+	room = _size - _tail - I2C_EEPROM_LZ_HEADER;
+
+	io.ee		= _ee;
+	io.pageSize	= _ee->get_pageSize();
+	io.addr		= _base + _tail + I2C_EEPROM_LZ_HEADER;
+	io.left		= min(room, (uint32_t)length - 1);	// must shrink to be worth it
+	io.cnt = io.nbits = 0;
+	io.rv		= 0;
+
+	while (i < length && io.rv == 0) {
+		uint8_t  best = 0;
+		uint16_t dist = 0;
+
+		// Longest match in the window ... the frame itself is the window
+		for (uint16_t j = (i > LZ_WINDOW) ? i - LZ_WINDOW : 0; j < i; j++) {
+			uint8_t k = 0;
+			while (k < LZ_MAXMATCH && i + k < length && buffer[j + k] == buffer[i + k]) k++;
+			if (k > best) {
+				best = k;
+				dist = i - j;
+				if (k == LZ_MAXMATCH) break;
+			}
+		}
+
+		if (best >= LZ_MINMATCH) {
+			_putbits(&io, 0, 1);
+			_putbits(&io, dist - 1, 8);
+			_putbits(&io, best - LZ_MINMATCH, 4);
+			i += best;
+		} else {
+			_putbits(&io, 0x100 | buffer[i], 9);
+			i++;
+		}
+	}
+	if (io.nbits > 0 && io.rv == 0) _putbyte(&io, io.acc << (8 - io.nbits));
+	_flush(&io);
+
+	if (io.rv == 0) {
+		stored = io.addr - (_base + _tail + I2C_EEPROM_LZ_HEADER);
+	} else {
+		if (io.rv != I2C_EEPROM_ERR_RANGE) return io.rv;
+
+		// Did not shrink ... store as is
+		if (length > room) return I2C_EEPROM_ERR_RANGE;
+		rv = _ee->writeBlock(_base + _tail + I2C_EEPROM_LZ_HEADER, buffer, length);
+		if (rv != 0) return rv;
+		stored = length | I2C_EEPROM_LZ_RAW;
+	}
+
+	uint32_t next = _next(_tail, stored);
+	if (next + I2C_EEPROM_LZ_HEADER <= _size) {
+		rv = _ee->setBlock(_base + next, 0xFF, I2C_EEPROM_LZ_HEADER);
+		if (rv != 0) return rv;
+	}
+
+	hdr[0] = length & 0xFF;
+	hdr[1] = length >> 8;
+	hdr[2] = stored & 0xFF;
+	hdr[3] = stored >> 8;
+	hdr[4] = LZ_CHECK ^ hdr[0] ^ hdr[1] ^ hdr[2] ^ hdr[3];
+	rv = _ee->writeBlock(_base + _tail, hdr, I2C_EEPROM_LZ_HEADER);
+	if (rv != 0) return rv;
+
+	_raw	+= length;
+	_stored	+= next - _tail;
+	_frames++;
+	_tail	 = next;
+	return 0;
+}
+
+
+//
+// Decompress <frame> into <buffer>, at most <length> bytes
+// returns bytes delivered; 0 = no such frame or error
+//
+uint16_t I2C_eepromLZ::read(const uint16_t frame, uint8_t* buffer, const uint16_t length) {
+LZio		io;
+uint32_t	pos;
+uint16_t	raw, stored;
+uint16_t	o = 0;
+
+	if (!_seek(frame, &pos, &raw, &stored)) return 0;
+	raw = min(raw, length);
+
+	if (stored & I2C_EEPROM_LZ_RAW)
+		return _ee->readBlock(_base + pos + I2C_EEPROM_LZ_HEADER, buffer, raw);
+
+	io.ee	= _ee;
+	io.addr	= _base + pos + I2C_EEPROM_LZ_HEADER;
+	io.left	= stored;
+	io.cnt = io.pos = io.nbits = 0;
+	io.rv	= 0;
+
+	while (o < raw) {
+		if (_getbits(&io, 1)) {
+			buffer[o++] = _getbits(&io, 8);
+		} else {
+			uint16_t dist = _getbits(&io, 8) + 1;
+			uint8_t  len  = _getbits(&io, 4) + LZ_MINMATCH;
+			if (dist > o) return 0;		// corrupt
+			while (len-- > 0 && o < raw) {
+				buffer[o] = buffer[o - dist];
+				o++;
+			}
+		}
+		if (io.rv != 0) return 0;
+	}
+	return o;
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromLZ::get_frames()		{ return _frames;		}
+uint32_t	I2C_eepromLZ::get_free()		{ return _size - _tail;		}
+uint32_t	I2C_eepromLZ::get_rawBytes()		{ return _raw;			}
+uint32_t	I2C_eepromLZ::get_storedBytes()		{ return _stored;		}
+
+uint8_t I2C_eepromLZ::get_ratio() {
+	return _raw ? (uint8_t)min(_stored * 100 / _raw, 255UL) : 0;
+}
+
+uint16_t I2C_eepromLZ::get_frameLength(const uint16_t frame) {
+uint32_t pos;
+uint16_t raw, stored;
+
+	return _seek(frame, &pos, &raw, &stored) ? raw : 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// Read and check a frame header @ region offset <pos>
+//
+bool I2C_eepromLZ::_header(const uint32_t pos, uint16_t* raw, uint16_t* stored) {
+uint8_t hdr[I2C_EEPROM_LZ_HEADER];
+
+	if (pos + I2C_EEPROM_LZ_HEADER > _size) return false;
+	if (_ee->readBlock(_base + pos, hdr, I2C_EEPROM_LZ_HEADER) != I2C_EEPROM_LZ_HEADER) return false;
+	if ((LZ_CHECK ^ hdr[0] ^ hdr[1] ^ hdr[2] ^ hdr[3]) != hdr[4]) return false;
+
+	*raw	= hdr[0] | (hdr[1] << 8);
+	*stored	= hdr[2] | (hdr[3] << 8);
+
+	return *raw != 0 && *raw <= I2C_EEPROM_LZ_MAXFRAME
+	    && pos + I2C_EEPROM_LZ_HEADER + (*stored & ~I2C_EEPROM_LZ_RAW) <= _size;
+}
+
+
+//
+// Page aligned offset behind a frame
+//
+uint32_t I2C_eepromLZ::_next(const uint32_t pos, const uint16_t stored) {
+uint16_t	ps  = _ee->get_pageSize();
+uint32_t	end = pos + I2C_EEPROM_LZ_HEADER + (stored & ~I2C_EEPROM_LZ_RAW);
+
+	return (end + ps - 1) / ps * ps;
+}
+
+
+//
+// Locate <frame>; continues from the cursor when moving forward
+//
+bool I2C_eepromLZ::_seek(const uint16_t frame, uint32_t* pos, uint16_t* raw, uint16_t* stored) {
+	if (frame >= _frames) return false;
+
+	if (frame < _curFrame) {
+		_curFrame = 0;
+		_curPos	  = 0;
+	}
+
+	while (_header(_curPos, raw, stored)) {
+		if (_curFrame == frame) {
+			*pos = _curPos;
+			return true;
+		}
+		_curPos = _next(_curPos, *stored);
+		_curFrame++;
+	}
+	return false;
+}
@@ -0,0 +1,75 @@
+#ifndef I2C_EEPROM_LZ_H
+#define I2C_EEPROM_LZ_H
+//
+//    FILE: I2C_eepromLZ.h
+// PURPOSE: Compressed frame log on top of I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// A region of the PROM holds a sequence of frames. Each frame starts on a page
+// boundary with a small header, followed by the LZSS compressed data (8 bit
+// window, 4 bit length; heatshrink style). A frame that does not shrink is
+// stored as is. Compression works on the caller's buffer and decompression
+// into the caller's buffer; besides one TWI chunk nothing else is needed in RAM.
+//
+// Frames are read back by index; locating one costs a header read per frame
+// skipped (sequential reads are served from a cursor).
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+// Frame header: raw length (2), stored length (2; bit 15 = uncompressed), check (1)
+#define I2C_EEPROM_LZ_HEADER	5
+#define I2C_EEPROM_LZ_RAW	0x8000
+#define I2C_EEPROM_LZ_MAXFRAME	0x7FFF
+
+
+class I2C_eepromLZ {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * Compressed log in <size> bytes of <ee> starting at <base>
+     * <base> should be page aligned.
+     */
+    I2C_eepromLZ(I2C_eeprom& ee, const uint16_t base, const uint32_t size);
+
+    int		begin(void);			// scan existing frames; returns frame count
+    int		format(void);			// drop all frames
+
+    int		append(		const uint8_t*	buffer,
+				const uint16_t	length);
+
+    uint16_t	read(		const uint16_t	frame,
+				      uint8_t*	buffer,
+				const uint16_t	length);
+
+    uint16_t	get_frames(void);
+    uint16_t	get_frameLength(const uint16_t frame);	// raw length; 0 = no such frame
+    uint32_t	get_free(void);			// bytes left in region
+    uint32_t	get_rawBytes(void);		// sum of raw frame lengths
+    uint32_t	get_storedBytes(void);		// sum of PROM bytes used, headers included
+    uint8_t	get_ratio(void);		// stored in % of raw
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint32_t	_size;
+    uint32_t	_tail;		// offset of next frame
+    uint16_t	_frames;
+    uint32_t	_raw;
+    uint32_t	_stored;
+    uint16_t	_curFrame;	// cursor for sequential frame access
+    uint32_t	_curPos;
+
+    bool	_header(const uint32_t pos, uint16_t* raw, uint16_t* stored);
+    uint32_t	_next(const uint32_t pos, const uint16_t stored);
+    bool	_seek(const uint16_t frame, uint32_t* pos, uint16_t* raw, uint16_t* stored);
+};
+#endif
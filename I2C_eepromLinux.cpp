@@ -0,0 +1,151 @@
+//
+//    FILE:	I2C_eepromLinux.cpp
+// PURPOSE:	Linux i2c-dev transport for I2C_eepromV2
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromLinux.h>
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromLinux::I2C_eepromLinux(const char* device, const uint16_t bufferSize) {
+	this->_device		= device;
+	this->_fd		= -1;
+	this->_bufferSize	= bufferSize;
+	this->_ioctls		= 0;
+	this->_tx		= (uint8_t*)malloc(bufferSize);
+	this->_txLen		= 0;
+	this->_txOverflow	= false;
+	this->_txPending	= false;
+	this->_rx		= (uint8_t*)malloc(bufferSize);
+	this->_rxLen		= 0;
+	this->_rxPos		= 0;
+}
+
+I2C_eepromLinux::~I2C_eepromLinux() {
+	if (_fd >= 0) close(_fd);
+	free(_tx);
+	free(_rx);
+}
+
+
+int		I2C_eepromLinux::get_fd()		{ return _fd;		}
+uint32_t	I2C_eepromLinux::get_ioctls()		{ return _ioctls;	}
+uint16_t	I2C_eepromLinux::get_bufferSize()	{ return _bufferSize;	}
+
+
+//
+// Open the adapter ... the clock is the kernel's business (device tree,
+// i2c-N bus frequency), i2c-dev has no way to set it: <speed> is not used
+//
+void I2C_eepromLinux::begin(int) {
+	if (_fd < 0) _fd = open(_device, O_RDWR);
+}
+
+
+void I2C_eepromLinux::beginTransmission(uint8_t address) {
+	_txAddress	= address;
+	_txLen		= 0;
+	_txOverflow	= false;
+	_txPending	= false;
+}
+
+size_t I2C_eepromLinux::write(const uint8_t* buffer, size_t length) {
+size_t n = min(length, (size_t)(_bufferSize - _txLen));
+
+	memcpy(_tx + _txLen, buffer, n);
+	_txLen += n;
+	if (n < length) _txOverflow = true;
+	return n;
+}
+
+
+//
+// With STOP the write goes out as one message; without it waits for requestFrom()
+//
+uint8_t I2C_eepromLinux::endTransmission(bool stop) {
+struct i2c_msg			msg;
+struct i2c_rdwr_ioctl_data	xfer;
+
+	if (_txOverflow) return 1;
+	if (_fd < 0) return 4;
+
+	if (!stop) {
+		_txPending = true;
+		return 0;
+	}
+
+	msg.addr	= _txAddress;
+	msg.flags	= 0;
+	msg.len		= _txLen;
+	msg.buf		= _tx;
+	xfer.msgs	= &msg;
+	xfer.nmsgs	= 1;
+
+	_ioctls++;
+	if (ioctl(_fd, I2C_RDWR, &xfer) < 0)
+		return (errno == ENXIO || errno == EREMOTEIO || errno == EIO) ? 2 : 4;
+
+	return 0;
+}
+
+
+//
+// Pending address write and the read in one ioctl
+//
+uint16_t I2C_eepromLinux::requestFrom(uint8_t address, uint16_t length) {
+struct i2c_msg			msg[2];
+struct i2c_rdwr_ioctl_data	xfer;
+uint8_t				n = 0;
+
+	_rxLen = _rxPos = 0;
+	if (_fd < 0) return 0;
+
+	if (_txPending && _txAddress == address) {
+		msg[n].addr	= address;
+		msg[n].flags	= 0;
+		msg[n].len	= _txLen;
+		msg[n].buf	= _tx;
+		n++;
+	}
+	_txPending = false;
+
+	length		= min(length, _bufferSize);
+	msg[n].addr	= address;
+	msg[n].flags	= I2C_M_RD;
+	msg[n].len	= length;
+	msg[n].buf	= _rx;
+	n++;
+
+	xfer.msgs	= msg;
+	xfer.nmsgs	= n;
+
+	_ioctls++;
+	if (ioctl(_fd, I2C_RDWR, &xfer) < 0) return 0;
+
+	_rxLen = length;
+	return length;
+}
+
+int I2C_eepromLinux::available() {
+	return _rxLen - _rxPos;
+}
+
+int I2C_eepromLinux::read() {
+	return (_rxPos < _rxLen) ? _rx[_rxPos++] : -1;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef I2C_EEPROM_LINUX_H
+#define I2C_EEPROM_LINUX_H
+//
+//    FILE: I2C_eepromLinux.h
+// PURPOSE: Linux i2c-dev transport for I2C_eepromV2 (gateways, Raspberry Pi et al.)
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Talks to /dev/i2c-N with I2C_RDWR. A transaction is kept in user space until
+// it is complete, so a page write is one ioctl and a read is one ioctl with
+// the address write and the sequential read as combined messages (repeated START).
+//
+//	I2C_eepromLinux	bus("/dev/i2c-1");
+//	I2C_eeprom	ee(bus, 0x50, 512);
+//
+//	ee.begin(400);		// bus clock is set by the kernel (device tree)
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromBus.h>
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#define I2C_EEPROM_LINUX_BUFFER	4096	// bytes per transaction
+
+
+class I2C_eepromLinux : public I2C_eepromBus {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromLinux(const char* device, const uint16_t bufferSize = I2C_EEPROM_LINUX_BUFFER);
+    ~I2C_eepromLinux();
+
+    int		get_fd(void);		// -1 = not open (begin() not called or failed)
+    uint32_t	get_ioctls(void);	// system calls issued
+
+    // I2C_eepromBus
+    void	begin(int speed);
+    void	beginTransmission(uint8_t address);
+    size_t	write(const uint8_t* buffer, size_t length);
+    uint8_t	endTransmission(bool stop = true);
+    uint16_t	requestFrom(uint8_t address, uint16_t length);
+    int		available(void);
+    int		read(void);
+    uint16_t	get_bufferSize(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    const char*	_device;
+    int		_fd;
+    uint16_t	_bufferSize;
+    uint32_t	_ioctls;
+
+    uint8_t	_txAddress;
+    uint8_t*	_tx;
+    uint16_t	_txLen;
+    bool	_txOverflow;
+    bool	_txPending;		// address phase waiting for requestFrom()
+
+    uint8_t*	_rx;
+    uint16_t	_rxLen;
+    uint16_t	_rxPos;
+};
+
+#endif
+#endif
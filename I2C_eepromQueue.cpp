@@ -0,0 +1,178 @@
+//
+//    FILE:	I2C_eepromQueue.cpp
+// PURPOSE:	Lock-free ingest queue for I2C_eepromV2
+//
+// Head and tail run free and are masked on access; the fill level is their
+// difference. The producer writes the data, then _head; the consumer reads
+// (or writes out) the data, then _tail.
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromQueue.h>
+
+
+//
+// Constructor ...
+// A <size> that is no power of 2 is rounded down to one
+//
+I2C_eepromQueue::I2C_eepromQueue(uint8_t* buffer, const uint16_t size) {
+uint16_t n = 1;
+
+	while (n * 2 <= size && n * 2 <= I2C_EEPROM_QUEUE_MAX) n *= 2;
+
+	this->_buf	= buffer;
+	this->_mask	= n - 1;
+	this->_head	= 0;
+	this->_tail	= 0;
+	this->_overruns	= 0;
+	this->_ee	= NULL;
+	this->_base	= 0;
+	this->_size	= 0;
+	this->_cursor	= 0;
+	this->_wrapped	= false;
+	this->_peak	= 0;
+}
+
+
+//
+// Queue <length> bytes at <record> ... all or nothing
+// returns false on overrun
+//
+bool I2C_eepromQueue::push(const void* record, const uint8_t length) {
+I2C_eepromQueueIndex	head = _head;
+I2C_eepromQueueIndex	used = head - _tail;
+const uint8_t*		src  = (const uint8_t*)record;
+
+	if ((uint16_t)_mask + 1 - used < length) {
+		_overruns++;
+		return false;
+	}
+
+	for (uint8_t i=0; i<length; i++)
+		_buf[(head + i) & _mask] = src[i];
+
+	I2C_EEPROM_BARRIER();
+	_head = head + length;
+	return true;
+}
+
+bool I2C_eepromQueue::push(const uint8_t data) {
+I2C_eepromQueueIndex	head = _head;
+
+	if ((I2C_eepromQueueIndex)(head - _tail) > _mask) {
+		_overruns++;
+		return false;
+	}
+
+	_buf[head & _mask] = data;
+
+	I2C_EEPROM_BARRIER();
+	_head = head + 1;
+	return true;
+}
+
+
+//
+// Drain into <size> bytes of <ee> from <base> on; the cursor wraps at the end
+//
+void I2C_eepromQueue::attach(I2C_eeprom& ee, const uint16_t base, const uint32_t size) {
+	this->_ee	= &ee;
+	this->_base	= base;
+	this->_size	= size;
+	this->_cursor	= 0;
+	this->_wrapped	= false;
+}
+
+
+//
+// Write queued bytes to the PROM, one page (or the rest of it) per batch;
+// a batch wrapping round the ring still goes out as one page write.
+// A batch that would end short of the page boundary waits for more data,
+// unless the ring is half full or <flush> is set.
+// Call from loop() ... blocks for the write cycles of the batches written.
+// returns 0 = OK otherwise error
+//
+int I2C_eepromQueue::drain(const bool flush) {
+uint16_t	pageSize;
+uint16_t	n, pos, cnt, first;
+uint32_t	room;
+int		rv;
+
+	if (_ee == NULL || _size == 0) return I2C_EEPROM_ERR_RANGE;
+	pageSize = _ee->get_pageSize();
+
+	for (;;) {
+		n = available();
+		if (n > _peak) _peak = n;
+		if (n == 0) return 0;
+		I2C_EEPROM_BARRIER();			// head before the data it covers
+
+		room = pageSize - (_base + _cursor) % pageSize;
+		room = min(room, _size - _cursor);
+		if (n < room && n < ((uint16_t)_mask + 1) / 2 && !flush) return 0;
+
+		pos = _tail & _mask;
+		cnt = min(n, (uint16_t)room);
+		first = min(cnt, (uint16_t)(_mask + 1 - pos));	// contiguous in the ring
+
+		if (first == cnt) {
+			rv = _ee->writeBlock(_base + _cursor, _buf + pos, cnt);
+		} else {
+			// Batch wraps round the ring: both parts in one page write
+			I2C_eepromSeg seg[2] = {
+				{ (uint16_t)(_base + _cursor),		_buf + pos,	first,			0 },
+				{ (uint16_t)(_base + _cursor + first),	_buf,		(uint16_t)(cnt - first), 0 }
+			};
+			rv = _ee->writev(seg, 2);
+		}
+		if (rv != 0) return rv;
+
+		I2C_EEPROM_BARRIER();
+		_tail = _tail + cnt;
+
+		_cursor += cnt;
+		if (_cursor == _size) {
+			_cursor  = 0;
+			_wrapped = true;
+		}
+	}
+}
+
+
+//
+// Take up to <length> bytes off the queue without the PROM
+// returns bytes taken
+//
+uint16_t I2C_eepromQueue::pop(uint8_t* buffer, const uint16_t length) {
+I2C_eepromQueueIndex	tail = _tail;
+uint16_t		cnt  = min(length, available());
+
+	I2C_EEPROM_BARRIER();				// head before the data it covers
+	for (uint16_t i=0; i<cnt; i++)
+		buffer[i] = _buf[(tail + i) & _mask];
+
+	I2C_EEPROM_BARRIER();
+	_tail = tail + cnt;
+	return cnt;
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromQueue::available()	{ return (I2C_eepromQueueIndex)(_head - _tail);	}
+uint16_t	I2C_eepromQueue::get_free()	{ return (uint16_t)_mask + 1 - available();	}
+uint16_t	I2C_eepromQueue::get_size()	{ return (uint16_t)_mask + 1;			}
+uint16_t	I2C_eepromQueue::get_peak()	{ return _peak;					}
+uint32_t	I2C_eepromQueue::get_cursor()	{ return _cursor;				}
+bool		I2C_eepromQueue::get_wrapped()	{ return _wrapped;				}
+
+// Written in the ISR; two equal reads make a consistent one on 8 bit CPUs
+uint16_t I2C_eepromQueue::get_overruns() {
+uint16_t n;
+
+	do n = _overruns; while (n != _overruns);
+	return n;
+}
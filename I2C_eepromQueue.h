@@ -0,0 +1,99 @@
+#ifndef I2C_EEPROM_QUEUE_H
+#define I2C_EEPROM_QUEUE_H
+//
+//    FILE: I2C_eepromQueue.h
+// PURPOSE: Lock-free ingest queue for I2C_eepromV2 ... push in an ISR, drain in loop()
+// VERSION: see I2C_EEPROM_VERSION
+//
+// One producer (an ISR) pushes records into a RAM ring given by the caller,
+// one consumer (loop()) drains it to a region of the PROM. Neither side
+// disables interrupts: each index is written by one side only and published
+// after the data behind it (I2C_EEPROM_BARRIER).
+//
+// A record is pushed whole or not at all; a push that does not fit counts as
+// an overrun. drain() writes page-sized batches from the ring (wrapping round
+// its end or not), so a burst costs no more write cycles than the PROM pages
+// it fills.
+//
+//	static uint8_t	ring[128];
+//	I2C_eepromQueue	q(ring, sizeof(ring));
+//
+//	ISR(TIMER1_COMPA_vect)	{ q.push(&sample, sizeof(sample)); }
+//
+//	q.attach(ee, 0, 8192);
+//	loop()			{ q.drain(); }
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+//
+// Ring indices must be read and written in one instruction: a byte on AVR
+//
+#ifdef __AVR__
+typedef uint8_t		I2C_eepromQueueIndex;
+#define I2C_EEPROM_QUEUE_MAX	128
+#else
+typedef uint16_t	I2C_eepromQueueIndex;
+#define I2C_EEPROM_QUEUE_MAX	32768
+#endif
+
+//
+// Data before index on push(), index before data on pop()/drain(): compiler
+// barrier on single core AVR, full fence elsewhere
+//
+#ifdef __AVR__
+#define I2C_EEPROM_BARRIER()	__asm__ __volatile__ ("" ::: "memory")
+#else
+#define I2C_EEPROM_BARRIER()	__sync_synchronize()
+#endif
+
+
+class I2C_eepromQueue {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * Ring of <size> bytes at <buffer>
+     * <size> must be a power of 2 up to I2C_EEPROM_QUEUE_MAX
+     */
+    I2C_eepromQueue(uint8_t* buffer, const uint16_t size);
+
+    // Producer side ... ISR safe
+    bool	push(const void* record, const uint8_t length);
+    bool	push(const uint8_t data);
+
+    // Consumer side
+    void	attach(I2C_eeprom& ee, const uint16_t base, const uint32_t size);
+    int		drain(const bool flush = false);	// 0 = OK otherwise error
+    uint16_t	pop(uint8_t* buffer, const uint16_t length);
+
+    uint16_t	available(void);		// bytes queued
+    uint16_t	get_free(void);
+    uint16_t	get_size(void);
+    uint16_t	get_overruns(void);		// pushes dropped
+    uint16_t	get_peak(void);			// highest fill level seen by drain()
+    uint32_t	get_cursor(void);		// region offset of the next drained byte
+    bool	get_wrapped(void);		// cursor went round at least once
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    uint8_t*	_buf;
+    I2C_eepromQueueIndex _mask;
+    volatile I2C_eepromQueueIndex _head;	// producer only ... free running
+    volatile I2C_eepromQueueIndex _tail;	// consumer only ... free running
+    volatile uint16_t _overruns;		// producer only
+
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint32_t	_size;
+    uint32_t	_cursor;
+    bool	_wrapped;
+    uint16_t	_peak;
+};
+#endif
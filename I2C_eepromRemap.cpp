@@ -0,0 +1,347 @@
+//
+//    FILE:	I2C_eepromRemap.cpp
+// PURPOSE:	Logical pages over I2C_eepromV2 with bad page retirement to spares
+//
+// Table arrays are stored as they are in RAM (little endian on AVR, ARM, ESP, x86)
+// and written with one writev().
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromRemap.h>
+
+#define BADBIT(p)	(_bad[(p) >> 3] & (1 << ((p) & 7)))
+
+
+//
+// Constructor ...
+//
+I2C_eepromRemap::I2C_eepromRemap(I2C_eeprom& ee, const uint16_t base, const uint16_t pages, const uint16_t spares) {
+	this->_ee	  = &ee;
+	this->_base	  = base;
+	this->_pages	  = pages;
+	this->_spares	  = spares;
+	this->_pageSize	  = ee.get_pageSize();
+	this->_tablePages = (_tableBytes() + _pageSize - 1) / _pageSize;
+	this->_data	  = base + 2UL * _tablePages * _pageSize;
+	this->_map	  = (uint16_t*)malloc(pages * sizeof(uint16_t));
+	this->_bad	  = (uint8_t*)malloc((pages + spares + 7) / 8);
+	this->_count	  = (uint16_t*)malloc((pages + spares) * sizeof(uint16_t));
+	this->_used	  = 0;
+	this->_retired	  = 0;
+	this->_begun	  = false;
+}
+
+I2C_eepromRemap::~I2C_eepromRemap() {
+	free(_map);
+	free(_bad);
+	free(_count);
+}
+
+
+//
+// Load the table ... copy A, copy B if A is broken; the other copy is
+// brought up to date
+// returns 0 = OK otherwise error (I2C_EEPROM_ERR_CRC: no good copy, format() to start over)
+//
+int I2C_eepromRemap::begin() {
+uint8_t		hdr[I2C_EEPROM_REMAP_HEADER];
+uint32_t	copyB = _base + (uint32_t)_tablePages * _pageSize;
+uint32_t	other = copyB;
+int		rv;
+
+	_begun = false;
+	if (_map == NULL || _bad == NULL || _count == NULL) return I2C_EEPROM_ERR_RANGE;
+	if (_pageSize > I2C_EEPROM_PAGEMAX) return I2C_EEPROM_ERR_RANGE;
+	if (_data + (uint32_t)(_pages + _spares) * _pageSize > (uint32_t)_ee->get_pages() * _pageSize)
+		return I2C_EEPROM_ERR_RANGE;
+
+	rv = _loadTable(_base);
+	if (rv != 0) {
+		rv    = _loadTable(copyB);
+		other = _base;
+	}
+	if (rv != 0) return rv;
+
+	_retired = 0;
+	for (uint16_t p=0; p<_pages + _spares; p++)
+		if (BADBIT(p)) _retired++;
+	_begun = true;
+
+	_header(hdr);
+	if (_checkTable(other, hdr) != 0) _saveTable();		// best effort, the table is loaded
+	return 0;
+}
+
+
+//
+// Fresh table: logical page n on data page n, all spares free
+//
+int I2C_eepromRemap::format() {
+	if (_map == NULL || _bad == NULL || _count == NULL) return I2C_EEPROM_ERR_RANGE;
+
+	for (uint16_t p=0; p<_pages; p++) _map[p] = p;
+	memset(_bad, 0, (_pages + _spares + 7) / 8);
+	memset(_count, 0, (_pages + _spares) * sizeof(uint16_t));
+	_used	 = 0;
+	_retired = 0;
+	_begun	 = true;
+	return _saveTable();
+}
+
+
+int I2C_eepromRemap::save() {
+	if (!_begun) return I2C_EEPROM_ERR_CRC;
+	return _saveTable();
+}
+
+
+//
+// Write <length> bytes @ logical <address>; each page part is verified and
+// moved to a spare if it fails
+// returns 0 = OK otherwise error (I2C_EEPROM_ERR_VERIFY: bad page, no spare left;
+// I2C_EEPROM_ERR_CRC: no table, begin() or format() first)
+//
+int I2C_eepromRemap::write(const uint16_t address, const uint8_t* buffer, const uint16_t length) {
+uint32_t	addr = address;
+uint16_t	len  = length;
+int		rv;
+
+	if (!_begun) return I2C_EEPROM_ERR_CRC;
+	if (addr + len > get_size()) return I2C_EEPROM_ERR_RANGE;
+
+	while (len > 0) {
+		uint16_t page = addr / _pageSize;
+		uint16_t off  = addr % _pageSize;
+		uint16_t cnt  = min(len, (uint16_t)(_pageSize - off));
+
+		rv = _writePage(_map[page], off, buffer, cnt);
+		if (rv != 0) rv = _retire(page, off, buffer, cnt);
+		if (rv != 0) return rv;
+
+		addr	+= cnt;
+		buffer	+= cnt;
+		len	-= cnt;
+	}
+	return 0;
+}
+
+
+//
+// Read <length> bytes @ logical <address>
+// returns bytes read ... none without a table
+//
+uint16_t I2C_eepromRemap::read(const uint16_t address, uint8_t* buffer, const uint16_t length) {
+uint32_t	addr = address;
+uint16_t	len  = length;
+uint16_t	got  = 0;
+
+	if (!_begun || addr + len > get_size()) return 0;
+
+	while (len > 0) {
+		uint16_t off = addr % _pageSize;
+		uint16_t cnt = min(len, (uint16_t)(_pageSize - off));
+		uint16_t n   = _ee->readBlock(_data + (uint32_t)_map[addr / _pageSize] * _pageSize + off, buffer, cnt);
+
+		got += n;
+		if (n != cnt) break;
+
+		addr	+= cnt;
+		buffer	+= cnt;
+		len	-= cnt;
+	}
+	return got;
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromRemap::get_physical(const uint16_t page)	{ return (_begun && page < _pages) ? _map[page] : 0;		}
+uint16_t	I2C_eepromRemap::get_writes(const uint16_t page)	{ return (_begun && page < _pages) ? _count[_map[page]] : 0;	}
+uint16_t	I2C_eepromRemap::get_sparesLeft()	{ return _spares - _used;			}
+uint16_t	I2C_eepromRemap::get_retired()		{ return _retired;				}
+uint32_t	I2C_eepromRemap::get_size()		{ return (uint32_t)_pages * _pageSize;		}
+uint16_t	I2C_eepromRemap::get_tablePages()	{ return 2 * _tablePages;			}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+uint16_t I2C_eepromRemap::_tableBytes() {
+	return I2C_EEPROM_REMAP_HEADER + _pages * 2 + (_pages + _spares + 7) / 8 + (_pages + _spares) * 2;
+}
+
+uint32_t I2C_eepromRemap::_tableCRC(const uint8_t* hdr) {
+uint32_t crc;
+
+	crc = I2C_eeprom::crc32Update(0,   hdr,              8);
+	crc = I2C_eeprom::crc32Update(crc, (uint8_t*)_map,   _pages * sizeof(uint16_t));
+	crc = I2C_eeprom::crc32Update(crc, _bad,             (_pages + _spares + 7) / 8);
+	return I2C_eeprom::crc32Update(crc, (uint8_t*)_count, (_pages + _spares) * sizeof(uint16_t));
+}
+
+
+void I2C_eepromRemap::_header(uint8_t* hdr) {
+uint32_t crc;
+
+	hdr[0] = I2C_EEPROM_REMAP_MAGIC & 0xFF;	hdr[1] = I2C_EEPROM_REMAP_MAGIC >> 8;
+	hdr[2] = _pages & 0xFF;			hdr[3] = _pages >> 8;
+	hdr[4] = _spares & 0xFF;		hdr[5] = _spares >> 8;
+	hdr[6] = _used & 0xFF;			hdr[7] = _used >> 8;
+	crc = _tableCRC(hdr);
+	memcpy(hdr + 8, &crc, sizeof(crc));
+}
+
+//
+// The copy @ <at>: header and the three arrays, back to back
+//
+void I2C_eepromRemap::_segs(I2C_eepromSeg* seg, const uint32_t at, uint8_t* hdr) {
+	seg[0].addr = at;
+	seg[0].buf  = hdr;
+	seg[0].len  = I2C_EEPROM_REMAP_HEADER;
+	seg[1].addr = at + I2C_EEPROM_REMAP_HEADER;
+	seg[1].buf  = (uint8_t*)_map;
+	seg[1].len  = _pages * sizeof(uint16_t);
+	seg[2].addr = seg[1].addr + seg[1].len;
+	seg[2].buf  = _bad;
+	seg[2].len  = (_pages + _spares + 7) / 8;
+	seg[3].addr = seg[2].addr + seg[2].len;
+	seg[3].buf  = (uint8_t*)_count;
+	seg[3].len  = (_pages + _spares) * sizeof(uint16_t);
+}
+
+
+//
+// Copy @ <at> into RAM
+// returns 0 = OK otherwise error (I2C_EEPROM_ERR_CRC: not a table of this layout)
+//
+int I2C_eepromRemap::_loadTable(const uint32_t at) {
+uint8_t		hdr[I2C_EEPROM_REMAP_HEADER];
+uint32_t	crc;
+I2C_eepromSeg	seg[4];
+
+	_segs(seg, at, hdr);
+	if (_ee->readv(seg, 4) != 0) return I2C_EEPROM_ERR_READ;
+
+	memcpy(&crc, hdr + 8, sizeof(crc));
+	if (hdr[0] + (hdr[1] << 8) != I2C_EEPROM_REMAP_MAGIC
+	 || hdr[2] + (hdr[3] << 8) != _pages
+	 || hdr[4] + (hdr[5] << 8) != _spares
+	 || hdr[6] + (hdr[7] << 8) > _spares
+	 || crc != _tableCRC(hdr))
+		return I2C_EEPROM_ERR_CRC;
+
+	_used = hdr[6] + (hdr[7] << 8);
+	return 0;
+}
+
+
+//
+// Read the copy @ <at> back against RAM and <hdr>
+// returns 0 = same otherwise error
+//
+int I2C_eepromRemap::_checkTable(const uint32_t at, uint8_t* hdr) {
+uint8_t		check[I2C_TWIBUFFERSIZE];
+I2C_eepromSeg	seg[4];
+
+	_segs(seg, at, hdr);
+	for (uint8_t s=0; s<4; s++)
+		for (uint16_t done=0; done<seg[s].len; ) {
+			uint8_t cnt = min(seg[s].len - done, I2C_TWIBUFFERSIZE);
+
+			if (_ee->readBlock(seg[s].addr + done, check, cnt) != cnt) return I2C_EEPROM_ERR_READ;
+			if (memcmp(check, seg[s].buf + done, cnt) != 0) return I2C_EEPROM_ERR_VERIFY;
+			done += cnt;
+		}
+	return 0;
+}
+
+
+//
+// Copy A, then copy B ... each in one writev() (page writes only) and read
+// back. Until A is complete B holds the table before; both are written
+// even if A fails, so a worn copy A does not freeze the table.
+// returns 0 = OK otherwise the first error
+//
+int I2C_eepromRemap::_saveTable() {
+uint8_t		hdr[I2C_EEPROM_REMAP_HEADER];
+I2C_eepromSeg	seg[4];
+int		rv = 0;
+
+	_header(hdr);
+	for (uint8_t c=0; c<2; c++) {
+		uint32_t at = _base + (uint32_t)c * _tablePages * _pageSize;
+
+		_segs(seg, at, hdr);
+		int r = _ee->writev(seg, 4);
+		if (r == 0) r = _checkTable(at, hdr);
+		if (rv == 0) rv = r;
+	}
+	return rv;
+}
+
+
+//
+// Write and read back a part of physical page <phys>; up to
+// I2C_EEPROM_REMAP_TRIES times, a one-off NACK or glitch is no worn page
+// returns 0 = OK otherwise error of the last try
+//
+int I2C_eepromRemap::_writePage(const uint16_t phys, const uint16_t offset, const uint8_t* buffer, const uint16_t length) {
+uint8_t		check[I2C_TWIBUFFERSIZE];
+uint32_t	addr = _data + (uint32_t)phys * _pageSize + offset;
+int		rv = 0;
+
+	for (uint8_t t=0; t<I2C_EEPROM_REMAP_TRIES; t++) {
+		if (_count[phys] != 0xFFFF) _count[phys]++;
+
+		rv = _ee->writeBlock(addr, buffer, length);
+		for (uint16_t done=0; rv == 0 && done<length; ) {
+			uint8_t cnt = min(length - done, I2C_TWIBUFFERSIZE);
+
+			if (_ee->readBlock(addr + done, check, cnt) != cnt)
+				rv = I2C_EEPROM_ERR_READ;
+			else if (memcmp(check, buffer + done, cnt) != 0)
+				rv = I2C_EEPROM_ERR_VERIFY;
+			done += cnt;
+		}
+		if (rv == 0) break;
+	}
+	return rv;
+}
+
+
+//
+// Logical <page> failed: retire its physical page, carry the old content
+// and the new part over to the next good spare, rewrite the table
+//
+int I2C_eepromRemap::_retire(const uint16_t page, const uint16_t offset, const uint8_t* buffer, const uint16_t length) {
+uint8_t		stage[I2C_EEPROM_PAGEMAX];
+uint16_t	phys = _map[page];
+
+	_ee->readBlock(_data + (uint32_t)phys * _pageSize, stage, _pageSize);	// best effort
+	memcpy(stage + offset, buffer, length);
+
+	_bad[phys >> 3] |= 1 << (phys & 7);
+	_retired++;
+
+	while (_used < _spares) {
+		uint16_t spare = _pages + _used++;
+
+		if (BADBIT(spare)) continue;
+		if (_writePage(spare, 0, stage, _pageSize) == 0) {
+			_map[page] = spare;
+			return _saveTable();
+		}
+		_bad[spare >> 3] |= 1 << (spare & 7);
+		_retired++;
+	}
+
+	_saveTable();
+	return I2C_EEPROM_ERR_VERIFY;
+}
@@ -0,0 +1,105 @@
+#ifndef I2C_EEPROM_REMAP_H
+#define I2C_EEPROM_REMAP_H
+//
+//    FILE: I2C_eepromRemap.h
+// PURPOSE: Logical pages over I2C_eepromV2 with bad page retirement to spares
+// VERSION: see I2C_EEPROM_VERSION
+//
+// A region of the PROM is split into the table, <pages> logical data pages
+// and <spares> spare pages.
+//
+// Every write is read back. A page that fails (NACK or different data) twice
+// in a row is retired: its content plus the new data go to the next spare,
+// the map entry points there from then on and the table is rewritten. One
+// NACK or glitch alone costs a page nothing. The map is a RAM array, so a
+// lookup is one index operation; until begin() or format() there is none and
+// write() returns I2C_EEPROM_ERR_CRC.
+//
+// Table: magic (2), pages (2), spares (2), spares used (2), CRC-32 (4) of
+// those and of map (2 per page), bad bits (1 per physical page), write
+// counts (2 per physical page). Write counts go to the PROM on a remap or
+// save().
+//
+// The table is the one place that knows where data went, so it is kept
+// twice, copy A then copy B, each written and read back. A torn or worn
+// copy A leaves copy B with the table before; begin() takes the first
+// good copy and rewrites the other one. With neither good begin() returns
+// I2C_EEPROM_ERR_CRC and formatting (losing all remaps) is the caller's call.
+//
+//	| table A | table B | data 0 .. pages-1 | spare 0 .. spares-1 |
+//
+//	I2C_eepromRemap	rm(ee, 0, 480, 16);	// 24x512: 480 + 16 + table pages
+//	if (rm.begin() == I2C_EEPROM_ERR_CRC)	// first use (or both copies lost)
+//		rm.format();
+//	rm.write(addr, buf, len);
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_REMAP_MAGIC	0x524D		// "RM"
+#define I2C_EEPROM_REMAP_HEADER	12
+#define I2C_EEPROM_REMAP_TRIES	2		// writes of a page part before its page is retired
+
+
+class I2C_eepromRemap {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * Region from <base> (page aligned) on: the table, <pages> logical pages, <spares> spares
+     */
+    I2C_eepromRemap(I2C_eeprom& ee, const uint16_t base, const uint16_t pages, const uint16_t spares);
+    ~I2C_eepromRemap();
+
+    int		begin(void);		// load the table; I2C_EEPROM_ERR_CRC: there is none
+    int		format(void);		// identity map, no bad pages, counts 0
+    int		save(void);		// write counts to the PROM
+
+    int		write(		const uint16_t	address,
+				const uint8_t*	buffer,
+				const uint16_t	length);
+
+    uint16_t	read(		const uint16_t	address,
+				      uint8_t*	buffer,
+				const uint16_t	length);
+
+    uint16_t	get_physical(const uint16_t page);	// data page index behind logical <page>
+    uint16_t	get_writes(const uint16_t page);	// writes to the physical page behind <page>
+    uint16_t	get_sparesLeft(void);
+    uint16_t	get_retired(void);
+    uint32_t	get_size(void);		// logical bytes
+    uint16_t	get_tablePages(void);	// both copies
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pages;
+    uint16_t	_spares;
+    uint16_t	_pageSize;
+    uint16_t	_tablePages;		// one copy
+    uint32_t	_data;			// PROM address of data page 0
+    uint16_t*	_map;			// logical -> physical
+    uint8_t*	_bad;			// bit per physical page
+    uint16_t*	_count;			// writes per physical page
+    uint16_t	_used;			// spares taken
+    uint16_t	_retired;
+    bool	_begun;			// table in RAM: begin() or format()
+
+    uint16_t	_tableBytes(void);
+    uint32_t	_tableCRC(const uint8_t* hdr);
+    void	_header(uint8_t* hdr);
+    void	_segs(I2C_eepromSeg* seg, const uint32_t at, uint8_t* hdr);
+    int		_loadTable(const uint32_t at);
+    int		_checkTable(const uint32_t at, uint8_t* hdr);
+    int		_saveTable(void);
+    int		_writePage(const uint16_t phys, const uint16_t offset, const uint8_t* buffer, const uint16_t length);
+    int		_retire(const uint16_t page, const uint16_t offset, const uint8_t* buffer, const uint16_t length);
+};
+#endif
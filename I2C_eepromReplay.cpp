@@ -0,0 +1,238 @@
+//
+//    FILE:	I2C_eepromReplay.cpp
+// PURPOSE:	Capture the calls of a sketch; replay them on the simulator
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromReplay.h>
+
+
+#ifdef I2C_EEPROM_CAPTURE
+Print* I2C_eepromCapture::_out = NULL;
+
+void I2C_eepromCapture::begin(Print& out) {
+	_out = &out;
+}
+
+void I2C_eepromCapture::end() {
+	_out = NULL;
+}
+
+void I2C_eepromCapture::op(const char op, const uint8_t device, const uint16_t address, const uint16_t length) {
+	if (_out == NULL) return;
+
+	_out->print("#EE ");
+	_out->print(op);
+	_out->print(' ');
+	_out->print((unsigned int)device);
+	_out->print(' ');
+	_out->print((unsigned int)address);
+	_out->print(' ');
+	_out->print((unsigned int)length);
+	_out->print(' ');
+	_out->println((unsigned long)micros());
+}
+#endif
+
+
+#ifndef ARDUINO
+
+//
+// Constructor ...
+//
+I2C_eepromReplay::I2C_eepromReplay(I2C_eepromSim& sim) {
+	this->_sim	   = &sim;
+	this->_devices	   = 0;
+	this->_sorted	   = true;
+	this->_skipped	   = 0;
+	this->_busMicros   = 0;
+	this->_writeCycles = 0;
+	this->_elapsed	   = 0;
+	for (uint8_t o=0; o<sizeof(_n) / sizeof(_n[0]); o++) {
+		_lat[o]	 = NULL;
+		_n[o]	 = 0;
+		_size[o] = 0;
+	}
+}
+
+I2C_eepromReplay::~I2C_eepromReplay() {
+	for (uint8_t o=0; o<sizeof(_n) / sizeof(_n[0]); o++) free(_lat[o]);
+}
+
+
+bool I2C_eepromReplay::attach(I2C_eeprom& ee) {
+	if (_devices == I2C_EEPROM_REPLAY_DEVICES) return false;
+	_ee[_devices++] = &ee;
+	return true;
+}
+
+
+//
+// Replay the "#EE" lines of <in> ... other lines are passed over
+// returns calls replayed
+//
+uint32_t I2C_eepromReplay::run(Stream& in, const bool timed) {
+static uint8_t	buf[65535];
+char		line[80];
+uint32_t	calls = 0;
+uint32_t	t0 = 0, r0 = 0;
+uint32_t	start = I2C_eepromSim::now();
+uint32_t	bus   = _sim->get_busMicros();
+uint32_t	wc    = _sim->get_writeCycles();
+
+	for (uint32_t i=0; i<sizeof(buf); i++) buf[i] = i * 31 + 7;
+
+	while (_line(in, line, sizeof(line))) {
+		char		op;
+		unsigned int	dev, addr, len;
+		unsigned long	t;
+		I2C_eeprom*	ee = NULL;
+		int8_t		o;
+
+		if (strncmp(line, "#EE ", 4) != 0) continue;
+		if (sscanf(line + 4, "%c %u %u %u %lu", &op, &dev, &addr, &len, &t) != 5 || (o = _op(op)) < 0) {
+			_skipped++;
+			continue;
+		}
+		for (uint8_t d=0; d<_devices; d++)
+			if (_ee[d]->get_deviceAddress() == dev) ee = _ee[d];
+		if (ee == NULL) {
+			_skipped++;
+			continue;
+		}
+
+		// Keep the sketch's pace: no call earlier than on the unit
+		if (calls == 0) {
+			t0 = t;
+			r0 = I2C_eepromSim::now();
+		} else if (timed) {
+			uint32_t due = r0 + (uint32_t)(t - t0);
+			int32_t	 gap = (int32_t)(due - I2C_eepromSim::now());
+			if (gap > 0) I2C_eepromSim::advance(gap);
+		}
+
+		uint32_t before = I2C_eepromSim::now();
+		switch (op) {
+			case 'R': ee->readBlock(addr, buf, len);	break;
+			case 'r': ee->readByte(addr);			break;
+			case 'W': ee->writeBlock(addr, buf, len);	break;
+			case 'w': ee->writeByte(addr, buf[addr & 0xFF]); break;
+			case 'S': ee->setBlock(addr, 0x55, len);	break;
+			case 'U': ee->updateBlock(addr, buf, len);	break;
+		}
+		uint32_t lat = I2C_eepromSim::now() - before;
+
+		if (_n[o] == _size[o]) {
+			uint32_t  size = _size[o] ? 2 * _size[o] : 256;
+			uint32_t* p    = (uint32_t*)realloc(_lat[o], size * sizeof(uint32_t));
+
+			if (p == NULL) break;
+			_lat[o]	 = p;
+			_size[o] = size;
+		}
+		_lat[o][_n[o]++] = lat;
+		_sorted = false;
+		calls++;
+	}
+
+	_elapsed     += I2C_eepromSim::now() - start;
+	_busMicros   += _sim->get_busMicros() - bus;
+	_writeCycles += _sim->get_writeCycles() - wc;
+	return calls;
+}
+
+
+//
+// Totals, then per op: calls, p50, p90, p99, max [us]
+//
+void I2C_eepromReplay::report(Print& out) {
+char line[100];
+
+	snprintf(line, sizeof(line), "elapsed %lu us, bus %lu us, write cycles %lu, skipped %lu\n",
+		(unsigned long)_elapsed, (unsigned long)_busMicros,
+		(unsigned long)_writeCycles, (unsigned long)_skipped);
+	out.print(line);
+	out.print("op     calls      p50      p90      p99      max\n");
+
+	for (uint8_t o=0; o<sizeof(_n) / sizeof(_n[0]); o++) {
+		char op = I2C_EEPROM_REPLAY_OPS[o];
+
+		if (_n[o] == 0) continue;
+		snprintf(line, sizeof(line), "%c  %9lu %8lu %8lu %8lu %8lu\n", op, (unsigned long)_n[o],
+			(unsigned long)get_latency(op, 50), (unsigned long)get_latency(op, 90),
+			(unsigned long)get_latency(op, 99), (unsigned long)get_latency(op, 100));
+		out.print(line);
+	}
+}
+
+
+uint32_t I2C_eepromReplay::get_calls(const char op) {
+int8_t o = _op(op);
+
+	return (o < 0) ? 0 : _n[o];
+}
+
+//
+// Nearest rank
+//
+uint32_t I2C_eepromReplay::get_latency(const char op, const uint8_t percent) {
+int8_t		o = _op(op);
+uint32_t	rank;
+
+	if (o < 0 || _n[o] == 0) return 0;
+	_sort();
+
+	rank = ((uint64_t)_n[o] * percent + 99) / 100;
+	return _lat[o][(rank > 0 ? rank : 1) - 1];
+}
+
+uint32_t I2C_eepromReplay::get_skipped() {
+	return _skipped;
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+int8_t I2C_eepromReplay::_op(const char op) {
+const char* p = strchr(I2C_EEPROM_REPLAY_OPS, op);
+
+	return (p == NULL || op == 0) ? -1 : p - I2C_EEPROM_REPLAY_OPS;
+}
+
+
+static int _cmp(const void* a, const void* b) {
+uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+void I2C_eepromReplay::_sort() {
+	if (_sorted) return;
+	for (uint8_t o=0; o<sizeof(_n) / sizeof(_n[0]); o++)
+		if (_n[o] > 1) qsort(_lat[o], _n[o], sizeof(uint32_t), _cmp);
+	_sorted = true;
+}
+
+
+//
+// One line of <in>, without the line end; overlong lines are cut
+// returns false = end of input
+//
+bool I2C_eepromReplay::_line(Stream& in, char* buf, const uint8_t size) {
+uint8_t	n = 0;
+int	c;
+
+	while ((c = in.read()) >= 0 && c != '\n')
+		if (c != '\r' && n < size - 1) buf[n++] = c;
+	buf[n] = 0;
+	return c >= 0 || n > 0;
+}
+
+#endif
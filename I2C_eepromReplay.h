@@ -0,0 +1,97 @@
+#ifndef I2C_EEPROM_REPLAY_H
+#define I2C_EEPROM_REPLAY_H
+//
+//    FILE: I2C_eepromReplay.h
+// PURPOSE: Capture the calls of a sketch; replay them on the simulator
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Capture ... with I2C_EEPROM_CAPTURE defined (here or in the build flags)
+// every readBlock(), readByte(), writeBlock(), writeByte(), setBlock() and
+// updateBlock() (and the _P ones) prints one line to the Print given:
+//
+//	#EE <op> <device> <address> <length> <micros>
+//
+// op: R readBlock, r readByte, W writeBlock, w writeByte, S setBlock,
+// U updateBlock. Lines start with "#EE", the sketch's own output may go in
+// between. Without the define nothing of it is built.
+//
+//	I2C_eepromCapture::begin(Serial);
+//
+// Replay ... on a host: the lines of a capture (i.e. a saved serial log) go
+// to the I2C_eeproms attached, on an I2C_eepromSim with the virtual clock.
+// With <timed> the gaps between calls are kept, so write cycles may end in
+// them as they do on the unit. Data written is a pattern; updateBlock()
+// therefore finds it unchanged from the second time on.
+//
+//	I2C_eepromReplay rp(sim);
+//	rp.attach(ee);
+//	rp.run(log, true);
+//	rp.report(out);			// bus time, write cycles, latency percentiles
+//
+// Released to the public domain
+//
+
+//#define I2C_EEPROM_CAPTURE
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_REPLAY_DEVICES	8
+#define I2C_EEPROM_REPLAY_OPS		"RrWwSU"
+
+
+#ifdef I2C_EEPROM_CAPTURE
+class I2C_eepromCapture {
+public:
+    static void	begin(Print& out);
+    static void	end(void);
+    static void	op(const char op, const uint8_t device, const uint16_t address, const uint16_t length);
+
+private:
+    static Print* _out;
+};
+#endif
+
+
+#ifndef ARDUINO
+#include <I2C_eepromSim.h>
+
+class I2C_eepromReplay {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromReplay(I2C_eepromSim& sim);
+    ~I2C_eepromReplay();
+
+    bool	attach(I2C_eeprom& ee);		// serves the lines of its device address
+
+    uint32_t	run(Stream& in, const bool timed = true);	// returns calls replayed
+
+    void	report(Print& out);
+    uint32_t	get_calls(const char op);
+    uint32_t	get_latency(const char op, const uint8_t percent);	// [us]; 100 = max
+    uint32_t	get_skipped(void);		// lines of no attached device, bad lines
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eepromSim* _sim;
+    I2C_eeprom*	_ee[I2C_EEPROM_REPLAY_DEVICES];
+    uint8_t	_devices;
+    uint32_t*	_lat[sizeof(I2C_EEPROM_REPLAY_OPS) - 1];	// latencies per op
+    uint32_t	_n[sizeof(I2C_EEPROM_REPLAY_OPS) - 1];
+    uint32_t	_size[sizeof(I2C_EEPROM_REPLAY_OPS) - 1];
+    bool	_sorted;
+    uint32_t	_skipped;
+    uint32_t	_busMicros;
+    uint32_t	_writeCycles;
+    uint32_t	_elapsed;
+
+    int8_t	_op(const char op);
+    bool	_line(Stream& in, char* buf, const uint8_t size);
+    void	_sort(void);
+};
+#endif
+#endif
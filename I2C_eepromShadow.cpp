@@ -0,0 +1,135 @@
+//
+//    FILE:	I2C_eepromShadow.cpp
+// PURPOSE:	RAM mirror of a PROM region, synced page by page without read back
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromShadow.h>
+
+
+//
+// Constructor ...
+// <size> bytes of <ram> mirror the PROM from <base> on
+//
+I2C_eepromShadow::I2C_eepromShadow(I2C_eeprom& ee, const uint16_t base, uint8_t* ram, const uint16_t size) {
+	this->_ee	= &ee;
+	this->_base	= base;
+	this->_ram	= ram;
+	this->_size	= size;
+	this->_pageSize	= ee.get_pageSize();
+	this->_pages	= (size == 0 || _pageSize == 0) ? 0 : (base % _pageSize + size + _pageSize - 1) / _pageSize;
+	this->_crc	= (_pages == 0) ? NULL : (uint32_t*)malloc(_pages * sizeof(uint32_t));
+	if (_crc == NULL) this->_pages = 0;	// unknown PROM or no RAM: begin() fails
+	this->_written	= 0;
+	this->_syncs	= 0;
+}
+
+I2C_eepromShadow::~I2C_eepromShadow() {
+	free(_crc);
+}
+
+
+//
+// Take the starting point: read the region into RAM (once, at boot) or
+// accept the RAM content as what the PROM holds
+// returns 0 = OK otherwise error
+//
+int I2C_eepromShadow::begin(const bool load) {
+	if (_pages == 0 && _size > 0) return I2C_EEPROM_ERR_RANGE;
+	if (_base + (uint32_t)_size > (uint32_t)_ee->get_pages() * _pageSize) return I2C_EEPROM_ERR_RANGE;
+
+	if (load && _ee->readBlock(_base, _ram, _size) != _size) return I2C_EEPROM_ERR_READ;
+
+	for (uint16_t p=0; p<_pages; p++) _crc[p] = _pageCRC(p);
+	return 0;
+}
+
+
+//
+// Write the pages changed since the last sync ... no reads
+// A page failing to write stays dirty for the next sync()
+// returns 0 = OK otherwise the first error
+//
+int I2C_eepromShadow::sync() {
+uint16_t	off, len;
+uint32_t	crc;
+int		rv = 0;
+
+	_written = 0;
+	_syncs++;
+	for (uint16_t p=0; p<_pages; p++) {
+		crc = _pageCRC(p);
+		if (crc == _crc[p]) continue;
+
+		_page(p, &off, &len);
+		int r = _ee->writeBlock(_base + off, _ram + off, len);
+		if (r == 0) {
+			_crc[p] = crc;
+			_written++;
+		} else if (rv == 0) {
+			rv = r;
+		}
+	}
+	return rv;
+}
+
+
+bool I2C_eepromShadow::dirty() {
+	for (uint16_t p=0; p<_pages; p++)
+		if (_pageCRC(p) != _crc[p]) return true;
+	return false;
+}
+
+
+//
+// Force the pages holding <length> bytes @ <offset> into the next sync()
+//
+void I2C_eepromShadow::touch(const uint16_t offset, const uint16_t length) {
+uint16_t first, last;
+
+	if (_pages == 0 || length == 0 || offset >= _size) return;
+
+	first = (_base % _pageSize + offset) / _pageSize;
+	last  = (_base % _pageSize + min((uint32_t)offset + length, (uint32_t)_size) - 1) / _pageSize;
+	for (uint16_t p=first; p<=last; p++)
+		_crc[p] = ~_pageCRC(p);
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromShadow::get_pages()	{ return _pages;	}
+uint16_t	I2C_eepromShadow::get_written()	{ return _written;	}
+uint32_t	I2C_eepromShadow::get_syncs()	{ return _syncs;	}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// Part of the region in PROM page <page>: <offset> into the region, <length>
+//
+void I2C_eepromShadow::_page(const uint16_t page, uint16_t* offset, uint16_t* length) {
+uint32_t from = (uint32_t)page * _pageSize;
+uint32_t to   = from + _pageSize;
+uint16_t lead = _base % _pageSize;
+
+	from	= (from > lead) ? from - lead : 0;
+	to	= min(to - lead, (uint32_t)_size);
+	*offset	= from;
+	*length	= to - from;
+}
+
+uint32_t I2C_eepromShadow::_pageCRC(const uint16_t page) {
+uint16_t off, len;
+
+	_page(page, &off, &len);
+	return I2C_eeprom::crc32Update(0, _ram + off, len);
+}
@@ -0,0 +1,64 @@
+#ifndef I2C_EEPROM_SHADOW_H
+#define I2C_EEPROM_SHADOW_H
+//
+//    FILE: I2C_eepromShadow.h
+// PURPOSE: RAM mirror of a PROM region, synced page by page without read back
+// VERSION: see I2C_EEPROM_VERSION
+//
+// The application works on a RAM copy (i.e. a settings struct). For each PROM
+// page of the region a CRC-32 of the RAM content taken at the last sync is kept;
+// sync() writes the pages whose CRC changed and nothing else. No PROM reads,
+// so a save costs the write cycles of the changed pages only.
+//
+// CRC-32 catches any change within 32 bits (one field) for sure and others
+// with 1:2^32 odds of a miss; touch() forces pages out regardless.
+//
+//	struct Settings	cfg;
+//	I2C_eepromShadow shadow(ee, 0x100, (uint8_t*)&cfg, sizeof(cfg));
+//
+//	shadow.begin();			// load cfg from the PROM once
+//	cfg.volume = 7;
+//	shadow.sync();			// writes the one page holding volume
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+
+class I2C_eepromShadow {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromShadow(I2C_eeprom& ee, const uint16_t base, uint8_t* ram, const uint16_t size);
+    ~I2C_eepromShadow();
+
+    int		begin(const bool load = true);	// load: RAM from PROM; else RAM is taken as in sync
+    int		sync(void);			// 0 = OK otherwise error
+    bool	dirty(void);			// any page to write?
+    void	touch(const uint16_t offset, const uint16_t length);	// write these bytes next sync()
+
+    uint16_t	get_pages(void);		// PROM pages the region touches
+    uint16_t	get_written(void);		// pages written by the last sync()
+    uint32_t	get_syncs(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint8_t*	_ram;
+    uint16_t	_size;
+    uint16_t	_pageSize;
+    uint16_t	_pages;
+    uint32_t*	_crc;			// per page, at last sync
+    uint16_t	_written;
+    uint32_t	_syncs;
+
+    void	_page(const uint16_t page, uint16_t* offset, uint16_t* length);
+    uint32_t	_pageCRC(const uint16_t page);
+};
+#endif
@@ -0,0 +1,361 @@
+//
+//    FILE:	I2C_eepromSim.cpp
+// PURPOSE:	In-memory I2C bus with 24xx PROMs for I2C_eepromV2
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromSim.h>
+#include <I2C_eepromThread.h>
+
+//
+// Definitions ... local
+//
+#define SIM_START	1	// bit times for START (or repeated START)
+#define SIM_STOP	1
+#define SIM_BYTE	9	// 8 bits + ACK
+#define SIM_POLL	1	// us a look at a background transfer costs (busy waits end)
+
+
+//
+// Constructor ...
+//
+I2C_eepromSim::I2C_eepromSim(const uint16_t bufferSize) {
+	this->_devices		= 0;
+	this->_faults		= 0;
+	this->_bufferSize	= bufferSize;
+	this->_speed		= 100;
+	this->_tx		= (uint8_t*)malloc(bufferSize);
+	this->_txLen		= 0;
+	this->_txOverflow	= false;
+	this->_rxDev		= NULL;
+	this->_rxLeft		= 0;
+	this->_background	= false;
+	this->_ahead		= false;
+	this->_pending		= NULL;
+	resetStats();
+}
+
+I2C_eepromSim::~I2C_eepromSim() {
+	free(_tx);
+}
+
+
+//
+// Put a PROM of <size> bytes @ <memory> on the bus
+//
+bool I2C_eepromSim::attach(const uint8_t address, uint8_t* memory, const uint32_t size, const uint8_t addrWords, const uint16_t pageSize, const uint16_t writeCycle) {
+I2C_eepromSimDev* dev;
+
+	if (_devices == I2C_EEPROM_SIM_DEVICES || get_device(address) != NULL) return false;
+
+	dev = &_dev[_devices++];
+	dev->address	= address;
+	dev->memory	= memory;
+	dev->size	= size;
+	dev->addrWords	= addrWords;
+	dev->pageSize	= pageSize;
+	dev->writeCycle	= writeCycle;
+	dev->busy	= false;
+	dev->pointer	= 0;
+	return true;
+}
+
+//
+// One address word and more than 256 bytes (24xx04/08/16): the chip answers
+// on one device address per 256 byte block, A8..A10 in its low bits
+//
+I2C_eepromSimDev* I2C_eepromSim::get_device(const uint8_t address) {
+	for (uint8_t i=0; i<_devices; i++)
+		if ((uint8_t)(address - _dev[i].address) < _blocks(&_dev[i])) return &_dev[i];
+	return NULL;
+}
+
+bool I2C_eepromSim::stuck(const uint8_t address, const uint32_t memoryAddress, const uint8_t mask) {
+	if (_faults == I2C_EEPROM_SIM_FAULTS) return false;
+
+	_fault[_faults].address		= address;
+	_fault[_faults].memoryAddress	= memoryAddress;
+	_fault[_faults].mask		= mask;
+	_faults++;
+	return true;
+}
+
+
+//
+// Model time ... one clock for all simulators, and so for the tasks of
+// several buses (I2C_eepromGroup)
+//
+bool		I2C_eepromSim::_virtual = false;
+uint64_t	I2C_eepromSim::_clockNs = 0;
+
+#ifdef I2C_EEPROM_THREADS
+static I2C_eepromMutex	_clockLock;
+#define CLOCK_LOCK()	_clockLock.lock()
+#define CLOCK_UNLOCK()	_clockLock.unlock()
+#else
+#define CLOCK_LOCK()
+#define CLOCK_UNLOCK()
+#endif
+
+#ifndef ARDUINO
+static const I2C_eepromClock_t _simClock = { I2C_eepromSim::now, I2C_eepromSim::advance };
+
+void I2C_eepromSim::useVirtualClock() {
+	_virtual = true;
+	I2C_eepromHost_setClock(&_simClock);
+}
+#endif
+
+uint32_t I2C_eepromSim::now() {
+uint64_t ns;
+
+	if (!_virtual) return micros();
+	CLOCK_LOCK();
+	ns = _clockNs;
+	CLOCK_UNLOCK();
+	return (uint32_t)(ns / 1000);
+}
+
+void I2C_eepromSim::advance(const uint32_t us) {
+	CLOCK_LOCK();
+	_clockNs += us * 1000ULL;
+	CLOCK_UNLOCK();
+}
+
+
+void I2C_eepromSim::setBackground(const bool on) {
+	_settle();
+	_background = on;
+}
+
+
+//
+// Statistics
+//
+void I2C_eepromSim::resetStats() {
+	_busNs		= 0;
+	_transactions	= 0;
+	_nacks		= 0;
+	_writeCycles	= 0;
+	_bytesWritten	= 0;
+	_bytesRead	= 0;
+}
+
+uint32_t	I2C_eepromSim::get_transactions()	{ return _transactions;		}
+uint32_t	I2C_eepromSim::get_nacks()		{ return _nacks;		}
+uint32_t	I2C_eepromSim::get_writeCycles()	{ return _writeCycles;		}
+uint32_t	I2C_eepromSim::get_bytesWritten()	{ return _bytesWritten;		}
+uint32_t	I2C_eepromSim::get_bytesRead()		{ return _bytesRead;		}
+uint32_t	I2C_eepromSim::get_busMicros()		{ return (uint32_t)(_busNs / 1000); }
+uint16_t	I2C_eepromSim::get_bufferSize()		{ return _bufferSize;		}
+
+
+//
+// I2C_eepromBus
+//
+void I2C_eepromSim::begin(int speed) {
+	_speed = (speed > 0) ? speed : 100;
+}
+
+void I2C_eepromSim::beginTransmission(uint8_t address) {
+	_settle();
+	_txAddress	= address;
+	_txLen		= 0;
+	_txOverflow	= false;
+}
+
+size_t I2C_eepromSim::write(const uint8_t* buffer, size_t length) {
+size_t n = min(length, (size_t)(_bufferSize - _txLen));
+
+	memcpy(_tx + _txLen, buffer, n);
+	_txLen += n;
+	if (n < length) _txOverflow = true;
+	return n;
+}
+
+
+//
+// Address words set the counter; data bytes go into the page latch, each
+// moving the counter on within the page, and are programmed on STOP. A
+// repeated START in place of the STOP drops them: nothing is programmed,
+// but the counter stays where the latched bytes left it.
+//
+uint8_t I2C_eepromSim::endTransmission(bool stop) {
+I2C_eepromSimDev* dev = get_device(_txAddress);
+
+	_transactions++;
+	if (_txOverflow) return 1;
+
+	if (dev == NULL || _busy(dev)) {
+		_nacks++;
+		_bits(SIM_START + SIM_BYTE + SIM_STOP);
+		return 2;
+	}
+	_bits(SIM_START + SIM_BYTE + _txLen * SIM_BYTE + (stop ? SIM_STOP : 0));
+
+	if (_txLen < dev->addrWords) return 0;
+
+	uint32_t addr = _txAddress - dev->address;	// block
+	for (uint8_t i=0; i<dev->addrWords; i++)
+		addr = (addr << 8) | _tx[i];
+	addr %= dev->size;
+	dev->pointer = addr;
+
+	uint16_t n = _txLen - dev->addrWords;
+	if (n == 0) return 0;
+
+	dev->pointer = _latch(dev, addr, n);
+	if (!stop) return 0;
+
+	for (uint16_t i=0; i<n; i++) {
+		uint32_t a = _latch(dev, addr, i);
+		dev->memory[a] = _tx[dev->addrWords + i];
+		for (uint8_t f=0; f<_faults; f++)
+			if (_fault[f].address == dev->address && _fault[f].memoryAddress == a)
+				dev->memory[a] &= ~_fault[f].mask;
+	}
+	_bytesWritten += n;
+
+	if (dev->writeCycle > 0) {
+		_writeCycles++;
+		dev->busy	= true;
+		dev->busyUntil	= _stop() + dev->writeCycle;
+	}
+	return 0;
+}
+
+
+uint16_t I2C_eepromSim::requestFrom(uint8_t address, uint16_t length) {
+I2C_eepromSimDev* dev = get_device(address);
+
+	_settle();
+	_transactions++;
+	_rxLeft = 0;
+
+	if (dev == NULL || _busy(dev)) {
+		_nacks++;
+		_bits(SIM_START + SIM_BYTE + SIM_STOP);
+		return 0;
+	}
+
+	_rxDev	= dev;
+	_rxLeft	= min(length, _bufferSize);
+	_bits(SIM_START + SIM_BYTE + _rxLeft * SIM_BYTE + SIM_STOP);
+	return _rxLeft;
+}
+
+//
+// Background: the transaction runs now, its bus time from now on
+//
+void I2C_eepromSim::startTransfer(uint8_t address, const uint8_t* tx, uint16_t txLen, uint8_t* rx, uint16_t rxLen, volatile uint8_t* status) {
+	if (!_background) {
+		I2C_eepromBus::startTransfer(address, tx, txLen, rx, rxLen, status);
+		return;
+	}
+	_settle();
+
+	_ahead	 = true;
+	_aheadNs = 0;
+	I2C_eepromBus::startTransfer(address, tx, txLen, rx, rxLen, &_pendingRv);
+	_doneAt	 = _stop();
+	_ahead	 = false;
+
+	_pending = status;
+	*status	 = I2C_EEPROM_BUS_PENDING;
+}
+
+void I2C_eepromSim::pollTransfer() {
+	if (_pending == NULL) return;
+
+	if ((int32_t)(now() - _doneAt) >= 0) {
+		*_pending = _pendingRv;
+		_pending  = NULL;
+	} else if (_virtual) {
+		advance(SIM_POLL);
+	}
+}
+
+bool I2C_eepromSim::get_background() {
+	return _background;
+}
+
+
+int I2C_eepromSim::available() {
+	return _rxLeft;
+}
+
+int I2C_eepromSim::read() {
+	if (_rxLeft == 0) return -1;
+
+	uint8_t b = _rxDev->memory[_rxDev->pointer];
+	_rxDev->pointer = (_rxDev->pointer + 1) % _rxDev->size;
+	_rxLeft--;
+	_bytesRead++;
+	return b;
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// Bus occupied for <bits> bit times; model time runs on
+//
+void I2C_eepromSim::_bits(const uint32_t bits) {
+uint32_t ns = (uint64_t)bits * 1000000UL / _speed;
+
+	_busNs += ns;
+	if (_ahead)
+		_aheadNs += ns;
+	else if (_virtual) {
+		CLOCK_LOCK();
+		_clockNs += ns;
+		CLOCK_UNLOCK();
+	}
+}
+
+uint32_t I2C_eepromSim::_stop() {
+	return now() + (_ahead ? (uint32_t)(_aheadNs / 1000) : 0);
+}
+
+//
+// Wait for the background transfer ... model time skips there
+//
+void I2C_eepromSim::_settle() {
+	if (_pending == NULL) return;
+
+	int32_t left = (int32_t)(_doneAt - now());
+	if (left > 0) {
+		if (_virtual)
+			advance(left);
+		else
+			while ((int32_t)(_doneAt - now()) > 0) ;
+	}
+	pollTransfer();
+}
+
+//
+// Address of latched byte <i> of a write @ <addr> ... the counter wraps
+// within the page (FRAM: at the end)
+//
+uint32_t I2C_eepromSim::_latch(I2C_eepromSimDev* dev, const uint32_t addr, const uint16_t i) {
+	if (dev->pageSize > 0)
+		return addr - addr % dev->pageSize + (addr % dev->pageSize + i) % dev->pageSize;
+	return (addr + i) % dev->size;
+}
+
+uint8_t I2C_eepromSim::_blocks(I2C_eepromSimDev* dev) {
+	return (dev->addrWords == 1 && dev->size > 256) ? dev->size >> 8 : 1;
+}
+
+bool I2C_eepromSim::_busy(I2C_eepromSimDev* dev) {
+	if (dev->busy && (int32_t)(now() - dev->busyUntil) >= 0)
+		dev->busy = false;
+	return dev->busy;
+}
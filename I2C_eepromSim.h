@@ -0,0 +1,159 @@
+#ifndef I2C_EEPROM_SIM_H
+#define I2C_EEPROM_SIM_H
+//
+//    FILE: I2C_eepromSim.h
+// PURPOSE: In-memory I2C bus with 24xx PROMs for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Each attached PROM lives in a RAM buffer and behaves like the real thing:
+// address words set the internal address counter, data bytes move it on and
+// wrap within a page, a write starts a write cycle during which the PROM
+// NACKs, sequential reads run on (and roll over at the end). A write ended by
+// a repeated START programs nothing but leaves the counter moved on, as a
+// 24xx01/02 does with the 2nd byte of a two word address. A pageSize and write cycle of 0 make it an FRAM. A 24xx04/08/16
+// (one address word, 512..2048 bytes) answers on 2..8 device addresses.
+//
+// Bus time is modelled from the bits on the wire at the begin() speed and the
+// write cycles; on a host useVirtualClock() makes micros() follow that model,
+// so simulated runs are fast and repeatable. With setBackground() a
+// startTransfer() returns at once and its bus time passes alongside the
+// caller's, as with an interrupt driven controller:
+//
+//	static uint8_t	mem[32768];
+//	I2C_eepromSim	sim;
+//	I2C_eeprom	ee(sim, 0x50, 256);
+//
+//	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+//	sim.useVirtualClock();
+//	ee.begin(400);
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromBus.h>
+
+#define I2C_EEPROM_SIM_DEVICES	8
+#define I2C_EEPROM_SIM_TWR	5000	// default write cycle [us]
+#define I2C_EEPROM_SIM_FAULTS	8	// worn cells
+
+
+typedef struct {
+	uint8_t		address;
+	uint8_t*	memory;
+	uint32_t	size;
+	uint8_t		addrWords;
+	uint16_t	pageSize;	// 0 = no page (FRAM)
+	uint16_t	writeCycle;	// us; 0 = none (FRAM)
+	bool		busy;		// in write cycle ...
+	uint32_t	busyUntil;	// ... until
+	uint32_t	pointer;	// internal address counter
+} I2C_eepromSimDev;
+
+
+class I2C_eepromSim : public I2C_eepromBus {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromSim(const uint16_t bufferSize = 32);	// as Wire; larger for i2c-dev alikes
+    ~I2C_eepromSim();
+
+    bool	attach(		const uint8_t	address,
+				      uint8_t*	memory,
+				const uint32_t	size,
+				const uint8_t	addrWords,
+				const uint16_t	pageSize,
+				const uint16_t	writeCycle = I2C_EEPROM_SIM_TWR);
+
+    I2C_eepromSimDev* get_device(const uint8_t address);
+
+    // Worn cell: bits in <mask> of byte <memoryAddress> stay 0 whatever is written
+    bool	stuck(const uint8_t address, const uint32_t memoryAddress, const uint8_t mask);
+
+#ifndef ARDUINO
+    static void	useVirtualClock(void);		// micros()/delay() follow the model
+#endif
+    static uint32_t now(void);			// model time [us] ... shared by all simulators
+    static void	advance(const uint32_t us);	// let model time pass
+
+    void	setBackground(const bool on);	// startTransfer() as interrupt driven
+
+    // Statistics since resetStats()
+    void	resetStats(void);
+    uint32_t	get_transactions(void);
+    uint32_t	get_nacks(void);		// address NACKs; write cycle polls
+    uint32_t	get_writeCycles(void);
+    uint32_t	get_bytesWritten(void);
+    uint32_t	get_bytesRead(void);
+    uint32_t	get_busMicros(void);		// bus occupied
+
+    // I2C_eepromBus
+    void	begin(int speed);
+    void	beginTransmission(uint8_t address);
+    size_t	write(const uint8_t* buffer, size_t length);
+    uint8_t	endTransmission(bool stop = true);
+    uint16_t	requestFrom(uint8_t address, uint16_t length);
+    int		available(void);
+    int		read(void);
+    uint16_t	get_bufferSize(void);
+
+    void	startTransfer(	uint8_t			address,
+				const uint8_t*		tx,
+				uint16_t		txLen,
+				uint8_t*		rx,
+				uint16_t		rxLen,
+				volatile uint8_t*	status);
+    void	pollTransfer(void);
+    bool	get_background(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eepromSimDev _dev[I2C_EEPROM_SIM_DEVICES];
+    uint8_t	_devices;
+
+    struct {
+	uint8_t		address;
+	uint32_t	memoryAddress;
+	uint8_t		mask;
+    } _fault[I2C_EEPROM_SIM_FAULTS];
+    uint8_t	_faults;
+    uint16_t	_bufferSize;
+    uint16_t	_speed;			// Khz
+
+    uint8_t	_txAddress;
+    uint8_t*	_tx;
+    uint16_t	_txLen;
+    bool	_txOverflow;
+
+    I2C_eepromSimDev* _rxDev;
+    uint16_t	_rxLeft;
+
+    // Background transfer ... done, status and all, at its start; reported
+    // when model time reaches its end
+    bool	_background;
+    bool	_ahead;			// bits go to _aheadNs, not the clock
+    uint64_t	_aheadNs;
+    volatile uint8_t* _pending;
+    volatile uint8_t _pendingRv;
+    uint32_t	_doneAt;
+
+    static bool	_virtual;
+    static uint64_t _clockNs;		// model time; under a lock where there are tasks
+    uint64_t	_busNs;
+    uint32_t	_transactions;
+    uint32_t	_nacks;
+    uint32_t	_writeCycles;
+    uint32_t	_bytesWritten;
+    uint32_t	_bytesRead;
+
+    void	_bits(const uint32_t bits);
+    uint32_t	_stop(void);			// model time at the STOP
+    void	_settle(void);			// background transfer over
+    uint32_t	_latch(I2C_eepromSimDev* dev, const uint32_t addr, const uint16_t i);
+    uint8_t	_blocks(I2C_eepromSimDev* dev);
+    bool	_busy(I2C_eepromSimDev* dev);
+};
+#endif
@@ -0,0 +1,291 @@
+//
+//    FILE:	I2C_eepromTS.cpp
+// PURPOSE:	Time indexed sample store in PROM pages for I2C_eepromV2
+//
+// The written blocks are _full blocks from _first on (ring order); the
+// current one follows them and lives in RAM until it is full. Its index
+// entry is written with its first flush. begin() finds the newest block as
+// the last one before the times in the index go down (or end erased).
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromTS.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromTS::I2C_eepromTS(I2C_eeprom& ee, const uint16_t base, const uint16_t pages, const uint8_t dataSize) {
+	this->_ee	  = &ee;
+	this->_base	  = base;
+	this->_pageSize	  = ee.get_pageSize();
+	this->_dataSize	  = dataSize;
+	this->_pageReads  = 0;
+
+	// Index and blocks share the pages
+	this->_blocks	  = (uint32_t)pages * _pageSize / (_pageSize + 4);
+	this->_indexPages = ((uint32_t)_blocks * 4 + _pageSize - 1) / _pageSize;
+	if (_indexPages + _blocks > pages) _blocks--;
+
+	this->_first	  = 0;
+	this->_full	  = 0;
+	this->_cur	  = 0;
+	this->_fill	  = 0;
+	this->_indexed	  = false;
+	this->_last	  = 0;
+	this->_rb	  = 0;
+	this->_rs	  = 0;
+	this->_from	  = 0;
+	this->_loaded	  = false;
+}
+
+
+//
+// returns 0 = OK otherwise error
+//
+int I2C_eepromTS::begin() {
+uint8_t		buf[I2C_TWIBUFFERSIZE - 2];
+uint32_t	t, top = 0;
+int32_t		newest = -1;
+
+	if (_pageSize > I2C_EEPROM_PAGEMAX || get_perBlock() == 0 || _blocks < 2) return I2C_EEPROM_ERR_RANGE;
+	if (_blockAddr(_blocks) > (uint32_t)_ee->get_pages() * _pageSize) return I2C_EEPROM_ERR_RANGE;
+
+	// Index read on sequentially, chunk by chunk
+	for (uint16_t b=0; b<_blocks; b++) {
+		uint8_t at = (b * 4) % sizeof(buf);
+
+		if (at == 0) {
+			uint16_t n = min((uint32_t)sizeof(buf), ((uint32_t)_blocks - b) * 4);
+			if (_ee->readBlock(_base + b * 4, buf, n) != n) return I2C_EEPROM_ERR_READ;
+		}
+		memcpy(&t, buf + at, 4);
+		if (t == I2C_EEPROM_TS_NONE || (newest >= 0 && t < top)) break;
+		newest = b;
+		top    = t;
+	}
+
+	_fill	 = 0;
+	_indexed = false;
+	_last	 = 0;
+	_loaded	 = false;
+	_rb	 = 0;
+	_rs	 = 0;
+	if (newest < 0) {
+		_first = _full = _cur = 0;
+		return 0;
+	}
+
+	// Newest block: full ... or the one to go on with
+	if (_ee->readBlock(_blockAddr(newest), _wbuf, _pageSize) != _pageSize) return I2C_EEPROM_ERR_READ;
+	while (_fill < get_perBlock() && _time(_wbuf + _fill * _sampleSize()) != I2C_EEPROM_TS_NONE)
+		_last = _time(_wbuf + _fill++ * _sampleSize());
+
+	if (_fill == get_perBlock()) {
+		_cur	= (newest + 1) % _blocks;
+		_fill	= 0;
+	} else {
+		_cur	 = newest;
+		_indexed = true;
+	}
+
+	// Wrapped: the ring is all written, the oldest block follows the current
+	if (_indexTime((_cur + 1) % _blocks) != I2C_EEPROM_TS_NONE) {
+		_first	= (_cur + 1) % _blocks;
+		_full	= _blocks - 1;
+	} else {
+		_first	= 0;
+		_full	= _cur;
+	}
+	return 0;
+}
+
+
+//
+// returns 0 = OK otherwise error
+//
+int I2C_eepromTS::format() {
+int rv;
+
+	if (_blocks < 2) return I2C_EEPROM_ERR_RANGE;
+
+	rv = _ee->setBlock(_base, 0xFF, _blocks * 4);
+	if (rv != 0) return rv;
+
+	_first	 = _full = _cur = 0;
+	_fill	 = 0;
+	_indexed = false;
+	_last	 = 0;
+	_rb	 = 0;
+	_rs	 = 0;
+	_loaded	 = false;
+	return 0;
+}
+
+
+//
+// Sample to RAM; a full block goes to the PROM
+// returns 0 = OK, I2C_EEPROM_ERR_RANGE (time went down) otherwise error
+//
+int I2C_eepromTS::append(const uint32_t time, const uint8_t* data) {
+uint8_t*	s = _wbuf + _fill * _sampleSize();
+int		rv;
+
+	if (time == I2C_EEPROM_TS_NONE || time < _last) return I2C_EEPROM_ERR_RANGE;
+
+	memcpy(s, &time, 4);
+	memcpy(s + 4, data, _dataSize);
+	_fill++;
+	_last = time;
+
+	if (_fill < get_perBlock()) return 0;
+
+	rv = flush();
+	if (rv != 0) return rv;
+
+	// Sealed ... the ring drops the oldest when the next would catch up
+	if (_full + 1 == _blocks) _first = (_first + 1) % _blocks;
+	else _full++;
+	_cur	 = (_first + _full) % _blocks;
+	_fill	 = 0;
+	_indexed = false;
+	return 0;
+}
+
+
+//
+// Current block to the PROM (rest erased), its index entry the first time
+// returns 0 = OK otherwise error
+//
+int I2C_eepromTS::flush() {
+uint16_t	n = _fill * _sampleSize();
+int		rv;
+
+	if (_fill == 0) return 0;
+
+	memset(_wbuf + n, 0xFF, _pageSize - n);
+	rv = _ee->writeBlock(_blockAddr(_cur), _wbuf, _pageSize);
+	if (rv != 0 || _indexed) return rv;
+
+	rv = _ee->writeBlock(_base + _cur * 4, _wbuf, 4);
+	if (rv == 0) _indexed = true;
+	return rv;
+}
+
+
+//
+// Binary search of the index for the last block starting before <from>
+// returns false = no sample >= <from>
+//
+bool I2C_eepromTS::seek(const uint32_t from) {
+uint16_t	lo = 0, hi = _full;
+
+	_from	= from;
+	_rs	= 0;
+	_loaded	= false;
+
+	// In the current block (RAM) already? A block before may end on
+	// samples of the same time, so only if it starts before <from>
+	if (_fill > 0 && _time(_wbuf) < from) {
+		_rb = _full;
+		return _last >= from;
+	}
+
+	// Blocks [0, lo) start before <from>: the last of them may hold
+	// samples at <from> too
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) / 2;
+
+		if (_indexTime((_first + mid) % _blocks) < from) lo = mid + 1;
+		else hi = mid;
+	}
+	_rb = (lo > 0) ? lo - 1 : 0;
+	return (_full > 0 || _fill > 0) && _last >= from;
+}
+
+
+//
+// Sample at the cursor (>= the seek() time), cursor on
+// returns false = no more samples
+//
+bool I2C_eepromTS::next(uint32_t* time, uint8_t* data) {
+	for (;;) {
+		const uint8_t*	buf;
+		uint8_t		n;
+
+		if (_rb > _full) return false;
+
+		if (_rb == _full) {
+			buf = _wbuf;
+			n   = _fill;
+		} else {
+			if (!_loaded) {
+				_pageReads++;
+				if (_ee->readBlock(_blockAddr((_first + _rb) % _blocks), _rbuf, _pageSize) != _pageSize)
+					return false;
+				_loaded = true;
+			}
+			buf = _rbuf;
+			n   = get_perBlock();
+		}
+
+		while (_rs < n) {
+			const uint8_t*	s = buf + _rs++ * _sampleSize();
+			uint32_t	t = _time(s);
+
+			if (t == I2C_EEPROM_TS_NONE) break;
+			if (t < _from) continue;
+
+			*time = t;
+			memcpy(data, s + 4, _dataSize);
+			return true;
+		}
+		if (_rb == _full) return false;
+
+		_rb++;
+		_rs	= 0;
+		_loaded	= false;
+	}
+}
+
+
+//
+// Utility functions
+//
+uint16_t	I2C_eepromTS::get_blocks()	{ return _blocks;				}
+uint16_t	I2C_eepromTS::get_blocksUsed()	{ return _full + (_fill > 0 ? 1 : 0);		}
+uint8_t		I2C_eepromTS::get_perBlock()	{ return _pageSize / _sampleSize();		}
+uint32_t	I2C_eepromTS::get_pageReads()	{ return _pageReads;				}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+uint8_t I2C_eepromTS::_sampleSize() {
+	return 4 + _dataSize;
+}
+
+uint32_t I2C_eepromTS::_blockAddr(const uint16_t block) {
+	return _base + (uint32_t)(_indexPages + block) * _pageSize;
+}
+
+uint32_t I2C_eepromTS::_indexTime(const uint16_t block) {
+uint32_t t;
+
+	_pageReads++;
+	if (_ee->readBlock(_base + block * 4, (uint8_t*)&t, 4) != 4) return I2C_EEPROM_TS_NONE;
+	return t;
+}
+
+uint32_t I2C_eepromTS::_time(const uint8_t* sample) {
+uint32_t t;
+
+	memcpy(&t, sample, 4);
+	return t;
+}
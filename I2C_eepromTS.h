@@ -0,0 +1,95 @@
+#ifndef I2C_EEPROM_TS_H
+#define I2C_EEPROM_TS_H
+//
+//    FILE: I2C_eepromTS.h
+// PURPOSE: Time indexed sample store in PROM pages for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Samples (time, data) of a fixed size are collected in RAM and written a
+// page - a block - at a time into a ring of blocks. The time of the first
+// sample of every block goes to an index in front of the blocks:
+//
+//	| index: 4 bytes per block | block 0 | block 1 | ... |
+//	block:	| time data | time data | ... | 0xFF ... |
+//
+// seek(from) searches the index binary (one 4 byte read per step, about 9
+// for 512 blocks) for the last block starting before <from>, as the one
+// before a block starting at <from> may end on that time; next() then reads
+// that block and the following ones sequentially. The ring drops
+// the oldest block when it is full.
+//
+// Times must not go down; 0xFFFFFFFF is taken (erased). flush() writes the
+// samples in RAM, i.e. before sleeping; a full block is written by itself.
+//
+//	I2C_eepromTS	ts(ee, 0, 512, 4);		// 4 data bytes per sample
+//	ts.begin();
+//	ts.append(now, (uint8_t*)&reading);
+//
+//	ts.seek(t1);
+//	while (ts.next(&t, buf) && t <= t2) ...
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_TS_NONE	0xFFFFFFFFUL	// erased time
+
+
+class I2C_eepromTS {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <pages> PROM pages from <base> (page aligned) on; samples of 4 + <dataSize> bytes
+     */
+    I2C_eepromTS(I2C_eeprom& ee, const uint16_t base, const uint16_t pages, const uint8_t dataSize);
+
+    int		begin(void);		// find the newest block from the index
+    int		format(void);		// empty store: index erased
+
+    int		append(const uint32_t time, const uint8_t* data);
+    int		flush(void);
+
+    bool	seek(const uint32_t from);	// cursor to the first sample >= <from>
+    bool	next(uint32_t* time, uint8_t* data);
+
+    uint16_t	get_blocks(void);		// in the ring
+    uint16_t	get_blocksUsed(void);		// holding samples, the one in RAM included
+    uint8_t	get_perBlock(void);		// samples
+    uint32_t	get_pageReads(void);		// by seek()/next(), index reads included
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pageSize;
+    uint8_t	_dataSize;
+    uint16_t	_blocks;		// in the ring
+    uint16_t	_indexPages;
+    uint32_t	_pageReads;
+
+    uint16_t	_first;			// oldest written block
+    uint16_t	_full;			// written blocks before the current one
+    uint16_t	_cur;			// block filled in RAM
+    uint8_t	_fill;			// samples in _wbuf
+    bool	_indexed;		// _cur has its index entry
+    uint32_t	_last;			// time of the newest sample
+    uint8_t	_wbuf[I2C_EEPROM_PAGEMAX];
+
+    uint16_t	_rb;			// cursor: block (0 = _first .. _full = current) ...
+    uint8_t	_rs;			// ... sample
+    uint32_t	_from;
+    bool	_loaded;
+    uint8_t	_rbuf[I2C_EEPROM_PAGEMAX];
+
+    uint8_t	_sampleSize(void);
+    uint32_t	_blockAddr(const uint16_t block);
+    uint32_t	_indexTime(const uint16_t block);
+    uint32_t	_time(const uint8_t* sample);
+};
+#endif
@@ -0,0 +1,235 @@
+//
+//    FILE:	I2C_eepromTWI.cpp
+// PURPOSE:	Interrupt driven AVR TWI transport for I2C_eepromV2
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromV2.h>
+
+#if defined(__AVR__) && defined(I2C_EEPROM_TWI)
+
+#include <I2C_eepromTWI.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+
+//
+// Definitions ... local
+//
+#define TWI_GO		(_BV(TWEN) | _BV(TWIE) | _BV(TWINT))	// next step, interrupt when done
+
+volatile bool			I2C_eepromTWI::_busy	= false;
+uint8_t				I2C_eepromTWI::_sla;
+const uint8_t* volatile		I2C_eepromTWI::_txp;
+volatile uint16_t		I2C_eepromTWI::_txLeft;
+uint8_t* volatile		I2C_eepromTWI::_rxp;
+volatile uint16_t		I2C_eepromTWI::_rxLeft;
+volatile uint8_t*		I2C_eepromTWI::_result;
+
+ISR(TWI_vect) {
+	I2C_eepromTWI::_isr();
+}
+
+
+//
+// Constructor ...
+//
+I2C_eepromTWI::I2C_eepromTWI() {
+	this->_txLen		= 0;
+	this->_txOverflow	= false;
+	this->_txPending	= false;
+	this->_rxLen		= 0;
+	this->_rxPos		= 0;
+}
+
+
+//
+// Clock from F_CPU (prescaler 1), internal pull-ups on as Wire does
+//
+void I2C_eepromTWI::begin(int speed) {
+uint32_t div = F_CPU / ((speed > 0 ? speed : 100) * 1000UL);
+
+	digitalWrite(SDA, HIGH);
+	digitalWrite(SCL, HIGH);
+
+	TWSR = 0;
+	TWBR = (div > 16) ? min((div - 16) / 2, 255UL) : 0;
+	TWCR = _BV(TWEN);
+}
+
+
+//
+// Wire-style calls ... a transaction each, waited for
+//
+void I2C_eepromTWI::beginTransmission(uint8_t address) {
+	_txAddress	= address;
+	_txLen		= 0;
+	_txOverflow	= false;
+	_txPending	= false;
+}
+
+size_t I2C_eepromTWI::write(const uint8_t* buffer, size_t length) {
+size_t n = min(length, (size_t)(I2C_EEPROM_TWI_BUFFER - _txLen));
+
+	memcpy(_tx + _txLen, buffer, n);
+	_txLen += n;
+	if (n < length) _txOverflow = true;
+	return n;
+}
+
+//
+// Without STOP the address phase waits for requestFrom() (repeated START)
+//
+uint8_t I2C_eepromTWI::endTransmission(bool stop) {
+	if (_txOverflow) return 1;
+
+	if (!stop) {
+		_txPending = true;
+		return 0;
+	}
+	startTransfer(_txAddress, _tx, _txLen, NULL, 0, &_status);
+	return _wait(&_status);
+}
+
+uint16_t I2C_eepromTWI::requestFrom(uint8_t address, uint16_t length) {
+uint8_t	txLen = (_txPending && _txAddress == address) ? _txLen : 0;
+
+	_txPending = false;
+	length = min(length, (uint16_t)I2C_EEPROM_TWI_BUFFER);
+
+	startTransfer(address, _tx, txLen, _rx, length, &_status);
+	_rxPos = 0;
+	_rxLen = (_wait(&_status) == 0) ? length : 0;
+	return _rxLen;
+}
+
+int I2C_eepromTWI::available() {
+	return _rxLen - _rxPos;
+}
+
+int I2C_eepromTWI::read() {
+	return (_rxPos < _rxLen) ? _rx[_rxPos++] : -1;
+}
+
+uint16_t	I2C_eepromTWI::get_bufferSize()	{ return I2C_EEPROM_TWI_BUFFER;	}
+bool		I2C_eepromTWI::get_background()	{ return true;			}
+
+
+//
+// Hand a transaction to the interrupt ... returns with the START on its way
+//
+void I2C_eepromTWI::startTransfer(uint8_t address, const uint8_t* tx, uint16_t txLen, uint8_t* rx, uint16_t rxLen, volatile uint8_t* status) {
+	if (_busy) _wait(_result);
+	while (TWCR & _BV(TWSTO)) ;		// STOP of the former one still going out
+
+	_sla	= (address << 1) | ((txLen == 0 && rxLen > 0) ? TW_READ : TW_WRITE);
+	_txp	= tx;
+	_txLeft	= txLen;
+	_rxp	= rx;
+	_rxLeft	= rxLen;
+	_result	= status;
+	*status	= I2C_EEPROM_BUS_PENDING;
+	_busy	= true;
+
+	TWCR = TWI_GO | _BV(TWSTA);
+}
+
+
+//
+// One step of the transaction in flight; codes as Wire's endTransmission()
+//
+void I2C_eepromTWI::_isr() {
+	switch (TW_STATUS) {
+		case TW_START:
+		case TW_REP_START:
+			TWDR = _sla;
+			TWCR = TWI_GO;
+			break;
+
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if (_txLeft > 0) {
+				TWDR = *_txp++;
+				_txLeft--;
+				TWCR = TWI_GO;
+			} else if (_rxLeft > 0) {
+				_sla |= TW_READ;
+				TWCR = TWI_GO | _BV(TWSTA);
+			} else {
+				_stop(0);
+			}
+			break;
+
+		case TW_MR_DATA_ACK:
+			*_rxp++ = TWDR;
+			_rxLeft--;
+			// fall through
+		case TW_MR_SLA_ACK:
+			TWCR = TWI_GO | ((_rxLeft > 1) ? _BV(TWEA) : 0);	// NACK the last byte
+			break;
+
+		case TW_MR_DATA_NACK:
+			*_rxp++ = TWDR;
+			_rxLeft--;
+			_stop(0);
+			break;
+
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			_stop(2);
+			break;
+
+		case TW_MT_DATA_NACK:
+			_stop(3);
+			break;
+
+		case TW_MT_ARB_LOST:			// = TW_MR_ARB_LOST: the bus is released
+			TWCR = _BV(TWEN);
+			*_result = 4;
+			_busy	 = false;
+			break;
+
+		default:				// bus error
+			_stop(4);
+	}
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+void I2C_eepromTWI::_stop(const uint8_t rv) {
+	TWCR	 = _BV(TWEN) | _BV(TWINT) | _BV(TWSTO);
+	*_result = rv;
+	_busy	 = false;
+}
+
+
+//
+// Until <status> is set ... a bus that hangs longer is reset
+//
+uint8_t I2C_eepromTWI::_wait(volatile uint8_t* status) {
+uint32_t start = millis();
+
+	while (*status == I2C_EEPROM_BUS_PENDING) {
+		if ((millis() - start) < I2C_EEPROM_TIMEOUT) continue;
+
+		uint8_t sreg = SREG;
+		cli();
+		if (*status == I2C_EEPROM_BUS_PENDING) {
+			TWCR	= 0;
+			TWCR	= _BV(TWEN);
+			*status	= 4;
+			_busy	= false;
+		}
+		SREG = sreg;
+	}
+	return *status;
+}
+
+#endif
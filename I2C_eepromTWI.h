@@ -0,0 +1,88 @@
+#ifndef I2C_EEPROM_TWI_H
+#define I2C_EEPROM_TWI_H
+//
+//    FILE: I2C_eepromTWI.h
+// PURPOSE: Interrupt driven AVR TWI transport for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// The TWI interrupt moves every byte; startTransfer() returns as soon as the
+// START is on its way and <status> is set from the interrupt when the STOP
+// goes out. An I2C_eepromAsync job thus costs the CPU a few microseconds per
+// transaction instead of the whole transaction.
+//
+// It owns TWI_vect, as Wire does: define I2C_EEPROM_TWI in I2C_eepromBus.h
+// and the library uses it in place of Wire (the default bus included); a
+// sketch must then not use Wire itself.
+//
+//	I2C_eeprom	ee(0x50, 256);		// on the TWI
+//	I2C_eepromAsync	job(ee);
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromBus.h>
+
+#if defined(__AVR__) && defined(I2C_EEPROM_TWI)
+
+#define I2C_EEPROM_TWI_BUFFER	32	// bytes per transaction, as Wire
+
+
+class I2C_eepromTWI : public I2C_eepromBus {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromTWI();
+
+    // I2C_eepromBus
+    void	begin(int speed);
+    void	beginTransmission(uint8_t address);
+    size_t	write(const uint8_t* buffer, size_t length);
+    uint8_t	endTransmission(bool stop = true);
+    uint16_t	requestFrom(uint8_t address, uint16_t length);
+    int		available(void);
+    int		read(void);
+    uint16_t	get_bufferSize(void);
+
+    void	startTransfer(	uint8_t			address,
+				const uint8_t*		tx,
+				uint16_t		txLen,
+				uint8_t*		rx,
+				uint16_t		rxLen,
+				volatile uint8_t*	status);
+    bool	get_background(void);
+
+    static void	_isr(void);		// from TWI_vect
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    uint8_t	_txAddress;
+    uint8_t	_tx[I2C_EEPROM_TWI_BUFFER];
+    uint8_t	_txLen;
+    bool	_txOverflow;
+    bool	_txPending;		// address phase waiting for requestFrom()
+
+    uint8_t	_rx[I2C_EEPROM_TWI_BUFFER];
+    uint8_t	_rxLen;
+    uint8_t	_rxPos;
+
+    volatile uint8_t _status;		// of the Wire-style calls
+
+    // The transaction on the bus ... set up by startTransfer(), moved on by _isr()
+    static volatile bool		_busy;
+    static uint8_t			_sla;
+    static const uint8_t* volatile	_txp;
+    static volatile uint16_t		_txLeft;
+    static uint8_t* volatile		_rxp;
+    static volatile uint16_t		_rxLeft;
+    static volatile uint8_t*		_result;
+
+    static void	_stop(const uint8_t rv);
+    static uint8_t _wait(volatile uint8_t* status);
+};
+
+#endif
+#endif
@@ -0,0 +1,56 @@
+#ifndef I2C_EEPROM_THREAD_H
+#define I2C_EEPROM_THREAD_H
+//
+//    FILE: I2C_eepromThread.h
+// PURPOSE: Mutex and yield for I2C_eepromV2 on platforms with threads
+// VERSION: see I2C_EEPROM_VERSION
+//
+// FreeRTOS on the ESP32, pthreads on a Linux host. Elsewhere nothing is
+// defined and I2C_EEPROM_THREADS stays undefined.
+//
+// Released to the public domain
+//
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#define I2C_EEPROM_THREADS
+#define I2C_EEPROM_FREERTOS
+#elif defined(__linux__) && !defined(ARDUINO)
+#include <pthread.h>
+#include <sched.h>
+#define I2C_EEPROM_THREADS
+#define I2C_EEPROM_PTHREAD
+#endif
+
+
+#ifdef I2C_EEPROM_THREADS
+class I2C_eepromMutex {
+public:
+#ifdef I2C_EEPROM_FREERTOS
+    I2C_eepromMutex()		{ _m = xSemaphoreCreateMutex();		}
+    ~I2C_eepromMutex()		{ vSemaphoreDelete(_m);			}
+    void	lock(void)	{ xSemaphoreTake(_m, portMAX_DELAY);	}
+    void	unlock(void)	{ xSemaphoreGive(_m);			}
+private:
+    SemaphoreHandle_t _m;
+#else
+    I2C_eepromMutex()		{ pthread_mutex_init(&_m, NULL);	}
+    ~I2C_eepromMutex()		{ pthread_mutex_destroy(&_m);		}
+    void	lock(void)	{ pthread_mutex_lock(&_m);		}
+    void	unlock(void)	{ pthread_mutex_unlock(&_m);		}
+private:
+    pthread_mutex_t _m;
+#endif
+};
+
+// Give up the CPU to other ready tasks ... busy waits
+#ifdef I2C_EEPROM_FREERTOS
+inline void	I2C_eepromYield(void)	{ taskYIELD();				}
+#else
+inline void	I2C_eepromYield(void)	{ sched_yield();			}
+#endif
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+//
+//    FILE:	I2C_eepromTrace.cpp
+// PURPOSE:	Bus transaction trace for I2C_eepromV2
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromBus.h>
+#include <I2C_eepromTrace.h>
+
+#ifdef I2C_EEPROM_TRACE
+
+I2C_eepromTraceRec	I2C_eepromTrace::_ring[I2C_EEPROM_TRACE_SIZE];
+uint16_t		I2C_eepromTrace::_next	= 0;
+uint16_t		I2C_eepromTrace::_count	= 0;
+uint32_t		I2C_eepromTrace::_total	= 0;
+volatile bool		I2C_eepromTrace::_on	= true;
+
+#ifdef I2C_EEPROM_THREADSAFE
+static I2C_eepromMutex	_traceMutex;		// records come from more than one bus
+#define TRACE_LOCK()	_traceMutex.lock()
+#define TRACE_UNLOCK()	_traceMutex.unlock()
+#else
+#define TRACE_LOCK()
+#define TRACE_UNLOCK()
+#endif
+
+
+//
+// One transaction ended now
+//
+void I2C_eepromTrace::record(const uint8_t type, const uint8_t device, const uint16_t address, const uint16_t length, const uint32_t start, const int result) {
+uint32_t		end = micros();
+I2C_eepromTraceRec*	r;
+
+	if (!_on) return;
+
+	// Filled before the slot is let go: get() and dump() see whole records
+	TRACE_LOCK();
+	r = &_ring[_next];
+	r->type	   = type;
+	r->device  = device;
+	r->result  = (result > 255) ? 255 : result;
+	r->address = address;
+	r->length  = length;
+	r->start   = start;
+	r->end	   = end;
+	_next = (_next + 1) % I2C_EEPROM_TRACE_SIZE;
+	if (_count < I2C_EEPROM_TRACE_SIZE) _count++;
+	_total++;
+	TRACE_UNLOCK();
+}
+
+
+void I2C_eepromTrace::enable(const bool on) {
+	_on = on;
+}
+
+void I2C_eepromTrace::clear() {
+	TRACE_LOCK();
+	_next  = 0;
+	_count = 0;
+	_total = 0;
+	TRACE_UNLOCK();
+}
+
+uint16_t I2C_eepromTrace::get_count() {
+	return _count;
+}
+
+uint32_t I2C_eepromTrace::get_total() {
+	return _total;
+}
+
+bool I2C_eepromTrace::get(const uint16_t i, I2C_eepromTraceRec* rec) {
+uint16_t n;
+
+	TRACE_LOCK();
+	n = get_count();
+	if (i < n) *rec = _ring[(_next + I2C_EEPROM_TRACE_SIZE - n + i) % I2C_EEPROM_TRACE_SIZE];
+	TRACE_UNLOCK();
+	return i < n;
+}
+
+
+//
+// Binary form ... see I2C_eepromTrace.h
+//
+static void _put(Print& out, uint32_t v, uint8_t bytes) {
+	while (bytes--) {
+		out.write((uint8_t)v);
+		v >>= 8;
+	}
+}
+
+void I2C_eepromTrace::dump(Print& out) {
+I2C_eepromTraceRec	r;
+uint16_t		n, first;
+uint32_t		total;
+
+	// The records there now ... each copied out under the lock, the
+	// ring may go on while it is written out
+	TRACE_LOCK();
+	n     = get_count();
+	total = _total;
+	first = (_next + I2C_EEPROM_TRACE_SIZE - n) % I2C_EEPROM_TRACE_SIZE;
+	TRACE_UNLOCK();
+
+	out.write((const uint8_t*)"I2CT", 4);
+	_put(out, 1, 1);
+	_put(out, I2C_EEPROM_TRACE_RECORD, 1);
+	_put(out, n, 2);
+	_put(out, total, 4);
+
+	for (uint16_t i=0; i<n; i++) {
+		TRACE_LOCK();
+		r = _ring[(first + i) % I2C_EEPROM_TRACE_SIZE];
+		TRACE_UNLOCK();
+		_put(out, r.type,    1);
+		_put(out, r.device,  1);
+		_put(out, r.result,  1);
+		_put(out, r.address, 2);
+		_put(out, r.length,  2);
+		_put(out, r.start,   4);
+		_put(out, r.end,     4);
+	}
+}
+
+
+#ifndef ARDUINO
+static bool _get(Stream& in, uint32_t* v, uint8_t bytes) {
+	*v = 0;
+	for (uint8_t i=0; i<bytes; i++) {
+		int c = in.read();
+
+		if (c < 0) return false;
+		*v |= (uint32_t)c << (8 * i);
+	}
+	return true;
+}
+
+bool I2C_eepromTrace::load(Stream& in) {
+uint32_t	magic, version, size, n, total;
+uint32_t	v[7];
+
+	if (!_get(in, &magic, 4) || magic != 0x54433249UL) return false;	// "I2CT"
+	if (!_get(in, &version, 1) || version != 1) return false;
+	if (!_get(in, &size, 1) || size != I2C_EEPROM_TRACE_RECORD) return false;
+	if (!_get(in, &n, 2) || !_get(in, &total, 4)) return false;
+
+	clear();
+	for (uint32_t i=0; i<n; i++) {
+		static const uint8_t width[7] = { 1, 1, 1, 2, 2, 4, 4 };
+
+		for (uint8_t f=0; f<7; f++)
+			if (!_get(in, &v[f], width[f])) return false;
+
+		I2C_eepromTraceRec* r = &_ring[_next];
+		r->type	   = v[0];
+		r->device  = v[1];
+		r->result  = v[2];
+		r->address = v[3];
+		r->length  = v[4];
+		r->start   = v[5];
+		r->end	   = v[6];
+		_next = (_next + 1) % I2C_EEPROM_TRACE_SIZE;
+		if (_count < I2C_EEPROM_TRACE_SIZE) _count++;
+	}
+	_total = total;			// of the session: more than the ring may hold
+	return true;
+}
+
+
+//
+// Chrome trace JSON: complete events ("X"), a thread per device
+//
+void I2C_eepromTrace::chrome(Print& out) {
+static const char*	name[5] = { "?", "write", "read", "compare", "wait" };
+I2C_eepromTraceRec	r;
+char			line[160];
+
+	out.print("{\"traceEvents\":[\n");
+	for (uint16_t i=0; i<get_count(); i++) {
+		get(i, &r);
+		snprintf(line, sizeof(line),
+			"%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lu,\"dur\":%lu,"
+			"\"args\":{\"addr\":%u,\"len\":%u,\"result\":%u}}\n",
+			i ? "," : "", name[r.type <= 4 ? r.type : 0], r.device,
+			(unsigned long)r.start, (unsigned long)(r.end - r.start),
+			r.address, r.length, r.result);
+		out.print(line);
+	}
+	out.print("],\"displayTimeUnit\":\"ms\"}\n");
+}
+#endif
+
+#endif
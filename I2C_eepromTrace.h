@@ -0,0 +1,102 @@
+#ifndef I2C_EEPROM_TRACE_H
+#define I2C_EEPROM_TRACE_H
+//
+//    FILE: I2C_eepromTrace.h
+// PURPOSE: Bus transaction trace for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// With I2C_EEPROM_TRACE defined (here or in the build flags) every bus
+// transaction of every I2C_eeprom goes into a ring of the last
+// I2C_EEPROM_TRACE_SIZE records: type, device, address, length, start and
+// end [us], result. A wait for the end of a write cycle is one record, its
+// length the number of polls. Without the define nothing of it is built.
+//
+// On the unit dump() sends the ring in a compact binary form:
+//
+//	I2C_eepromTrace::enable(false);		// freeze after the stall
+//	I2C_eepromTrace::dump(Serial);
+//
+// On a host (simulator or a saved dump, see load()) chrome() writes the
+// Chrome trace JSON for chrome://tracing or ui.perfetto.dev, a track per
+// device.
+//
+// Binary form (little endian):
+//	"I2CT", version (1), record size (15), records (2), recorded in all (4)
+//	record:	type, device, result, address (2), length (2), start (4), end (4)
+//
+// Released to the public domain
+//
+
+//#define I2C_EEPROM_TRACE
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#elif defined(ARDUINO)
+#include "WProgram.h"
+#else
+#include "I2C_eepromHost.h"
+#endif
+
+#ifndef I2C_EEPROM_TRACE_SIZE
+#define I2C_EEPROM_TRACE_SIZE	64	// records kept (15 bytes each)
+#endif
+
+#define I2C_EEPROM_TRACE_WRITE		1
+#define I2C_EEPROM_TRACE_READ		2
+#define I2C_EEPROM_TRACE_COMPARE	3	// read compared on the fly (update*)
+#define I2C_EEPROM_TRACE_WAIT		4	// write cycle ACK polling
+#define I2C_EEPROM_TRACE_RECORD		15	// bytes per record in dump()
+
+
+#ifdef I2C_EEPROM_TRACE
+
+typedef struct {
+	uint8_t		type;
+	uint8_t		device;
+	uint8_t		result;		// 0 = OK otherwise error
+	uint16_t	address;
+	uint16_t	length;		// bytes; polls for I2C_EEPROM_TRACE_WAIT
+	uint32_t	start;		// micros()
+	uint32_t	end;
+} I2C_eepromTraceRec;
+
+
+class I2C_eepromTrace {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    static void		record(	const uint8_t	type,
+				const uint8_t	device,
+				const uint16_t	address,
+				const uint16_t	length,
+				const uint32_t	start,
+				const int	result);
+
+    static void		enable(const bool on);		// default on
+    static void		clear(void);
+    static uint16_t	get_count(void);		// records in the ring
+    static uint32_t	get_total(void);		// recorded since clear()
+    static bool		get(const uint16_t i, I2C_eepromTraceRec* rec);	// 0 = oldest
+
+    static void		dump(Print& out);
+
+#ifndef ARDUINO
+    static bool		load(Stream& in);		// a dump() back into the ring
+    static void		chrome(Print& out);
+#endif
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    static I2C_eepromTraceRec _ring[I2C_EEPROM_TRACE_SIZE];
+    static uint16_t	_next;
+    static uint16_t	_count;			// records in the ring
+    static uint32_t	_total;
+    static volatile bool _on;
+};
+
+#endif
+#endif
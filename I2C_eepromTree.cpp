@@ -0,0 +1,326 @@
+//
+//    FILE:	I2C_eepromTree.cpp
+// PURPOSE:	Static B+tree of sorted records in PROM pages for I2C_eepromV2
+//
+// build() writes the leaves in one pass over the source, then each level
+// above from the first keys of the one below (read back, keySize bytes per
+// child). Descending, a node leads to the last child whose first key is
+// less than the key looked for; equal keys may end one leaf and start the
+// next, the leaf search runs on into that one.
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromTree.h>
+
+
+//
+// Constructor ...
+//
+I2C_eepromTree::I2C_eepromTree(I2C_eeprom& ee, const uint16_t base, const uint16_t pages) {
+	this->_ee	 = &ee;
+	this->_base	 = base;
+	this->_pages	 = pages;
+	this->_pageSize	 = ee.get_pageSize();
+	this->_keySize	 = 0;
+	this->_valueSize = 0;
+	this->_entries	 = 0;
+	this->_levels	 = 0;
+	this->_pageReads = 0;
+	this->_leafNo	 = 0;
+	this->_slot	 = 0;
+	this->_leaf[0]	 = 0;
+}
+
+
+//
+// returns 0 = OK, I2C_EEPROM_ERR_VERIFY (no tree) otherwise error
+//
+int I2C_eepromTree::begin() {
+uint8_t		hdr[I2C_EEPROM_TREE_HEADER];
+uint32_t	crc;
+
+	if (_ee->readBlock(_base, hdr, sizeof(hdr)) != sizeof(hdr)) return I2C_EEPROM_ERR_READ;
+
+	memcpy(&crc, hdr + 12, sizeof(crc));
+	if (hdr[0] + (hdr[1] << 8) != I2C_EEPROM_TREE_MAGIC
+	 || crc != I2C_eeprom::crc32Update(0, hdr, 12))
+		return I2C_EEPROM_ERR_VERIFY;
+
+	_keySize   = hdr[2];
+	_valueSize = hdr[3];
+	memcpy(&_entries, hdr + 4, sizeof(_entries));
+
+	if (!_shape()) {
+		_levels = 0;
+		return I2C_EEPROM_ERR_VERIFY;
+	}
+	_leaf[0] = 0;
+	return 0;
+}
+
+
+//
+// Write a tree of <count> records from <source>, ascending keys
+// returns 0 = OK, I2C_EEPROM_ERR_RANGE (does not fit, not sorted) otherwise error
+//
+int I2C_eepromTree::build(const uint8_t keySize, const uint8_t valueSize, const uint32_t count, I2C_eepromTreeSource source, void* ctx) {
+uint8_t		page[I2C_EEPROM_PAGEMAX];
+uint8_t		last[I2C_EEPROM_PAGEMAX];
+uint16_t	recSize = keySize + valueSize;
+uint32_t	i = 0;
+int		rv;
+
+	_keySize   = keySize;
+	_valueSize = valueSize;
+	_entries   = count;
+	_levels	   = 0;
+	if (_pageSize > I2C_EEPROM_PAGEMAX || keySize == 0 || !_shape()) {
+		_levels = 0;
+		return I2C_EEPROM_ERR_RANGE;
+	}
+
+	// Old header away first: a torn build leaves no tree
+	rv = _ee->setBlock(_base, 0xFF, I2C_EEPROM_TREE_HEADER);
+	if (rv != 0) return rv;
+
+	// Leaves
+	for (uint16_t n=0; n<_count[_levels - 1]; n++) {
+		memset(page, 0xFF, _pageSize);
+		page[0] = 0;
+		while (page[0] < _leafSlots() && i < count) {
+			uint8_t* rec = page + 1 + page[0] * recSize;
+
+			source(ctx, i, rec);
+			if (i > 0 && memcmp(rec, last, keySize) < 0) return I2C_EEPROM_ERR_RANGE;
+			memcpy(last, rec, keySize);
+			page[0]++;
+			i++;
+		}
+		rv = _ee->writeBlock(_node(_start[_levels - 1] + n), page, _pageSize);
+		if (rv != 0) return rv;
+	}
+
+	// Levels above, bottom up
+	for (int8_t l=_levels - 2; l>=0; l--) {
+		uint16_t child = 0;
+
+		for (uint16_t n=0; n<_count[l]; n++) {
+			memset(page, 0xFF, _pageSize);
+			page[0] = 0;
+			while (page[0] < _fanout() && child < _count[l + 1]) {
+				uint8_t* key = page + 1 + page[0] * keySize;
+
+				if (_ee->readBlock(_node(_start[l + 1] + child) + 1, key, keySize) != keySize)
+					return I2C_EEPROM_ERR_READ;
+				page[0]++;
+				child++;
+			}
+			rv = _ee->writeBlock(_node(_start[l] + n), page, _pageSize);
+			if (rv != 0) return rv;
+		}
+	}
+	_leaf[0] = 0;
+
+	return _writeHeader();
+}
+
+
+//
+// Look <key> up; its value goes to <value> if not NULL
+// returns true = found
+//
+bool I2C_eepromTree::find(const uint8_t* key, uint8_t* value) {
+uint8_t rec[I2C_EEPROM_PAGEMAX];
+
+	if (!_seek(key, true) || !next(rec) || memcmp(rec, key, _keySize) != 0) return false;
+	if (value != NULL) memcpy(value, rec + _keySize, _valueSize);
+	return true;
+}
+
+
+//
+// Cursor to the first record >= <key>: one page read per level
+// returns false = all records are less (or no tree)
+//
+bool I2C_eepromTree::seek(const uint8_t* key) {
+	return _seek(key, false);
+}
+
+//
+// Record at the cursor to <record>, cursor on; the next leaf is read when needed
+// returns false = no more records
+//
+bool I2C_eepromTree::next(uint8_t* record) {
+uint16_t recSize = _keySize + _valueSize;
+
+	if (_levels == 0) return false;
+
+	if (_slot >= _leaf[0]) {
+		if (_leaf[0] == 0 || _leafNo + 1 >= _count[_levels - 1]) return false;
+
+		_leafNo++;
+		_slot = 0;
+		if (!_readNode(_start[_levels - 1] + _leafNo, _leaf) || _leaf[0] == 0) {
+			_leaf[0] = 0;
+			return false;
+		}
+	}
+
+	memcpy(record, _leaf + 1 + _slot * recSize, recSize);
+	_slot++;
+	return true;
+}
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromTree::get_entries()	{ return _entries;	}
+uint8_t		I2C_eepromTree::get_levels()	{ return _levels;	}
+uint32_t	I2C_eepromTree::get_pageReads()	{ return _pageReads;	}
+
+uint16_t I2C_eepromTree::get_nodes() {
+	return (_levels == 0) ? 0 : _start[_levels - 1] + _count[_levels - 1];
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+//
+// <equal>: also a child starting with <key> itself is taken ... right
+// for find(), too late for the first of equal keys ending the child before
+//
+bool I2C_eepromTree::_seek(const uint8_t* key, const bool equal) {
+uint8_t		page[I2C_EEPROM_PAGEMAX];
+uint16_t	recSize = _keySize + _valueSize;
+uint16_t	n = 0;
+uint16_t	lo, hi;
+
+	if (_levels == 0 || _entries == 0) return false;
+
+	for (uint8_t l=0; l<_levels - 1; l++) {
+		if (!_readNode(_start[l] + n, page)) return false;
+
+		// Children with a first key < <key> (<= if <equal>)
+		lo = 0;
+		hi = page[0];
+		while (lo < hi) {
+			uint16_t mid = (lo + hi) / 2;
+			int	 c   = memcmp(page + 1 + mid * _keySize, key, _keySize);
+
+			if (c < 0 || (equal && c == 0)) lo = mid + 1;
+			else hi = mid;
+		}
+		n = n * _fanout() + (lo > 0 ? lo - 1 : 0);
+	}
+
+	_leafNo = n;
+	if (!_readNode(_start[_levels - 1] + n, _leaf)) {
+		_leaf[0] = 0;
+		return false;
+	}
+
+	lo = 0;
+	hi = _leaf[0];
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) / 2;
+
+		if (memcmp(_leaf + 1 + mid * recSize, key, _keySize) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	_slot = lo;
+
+	// All less ... the first of the next leaf then
+	if (_slot == _leaf[0]) {
+		if (_leafNo + 1 >= _count[_levels - 1]) {
+			_leaf[0] = 0;
+			return false;
+		}
+		_leafNo++;
+		_slot = 0;
+		if (!_readNode(_start[_levels - 1] + _leafNo, _leaf)) {
+			_leaf[0] = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+uint8_t I2C_eepromTree::_leafSlots() {
+	return (_pageSize - 1) / (_keySize + _valueSize);
+}
+
+uint8_t I2C_eepromTree::_fanout() {
+	return (_pageSize - 1) / _keySize;
+}
+
+
+//
+// Levels and their place from _entries and the record layout
+// returns false = does not fit
+//
+bool I2C_eepromTree::_shape() {
+uint16_t	count[I2C_EEPROM_TREE_LEVELS];
+uint32_t	n;
+uint8_t		levels = 0;
+uint16_t	start = 0;
+
+	if (_keySize == 0 || _pageSize > I2C_EEPROM_PAGEMAX) return false;
+	if (_leafSlots() == 0 || _fanout() < 2) return false;
+
+	// Bottom up: leaves first
+	n = (_entries + _leafSlots() - 1) / _leafSlots();
+	if (n == 0) n = 1;
+	for (;;) {
+		if (levels == I2C_EEPROM_TREE_LEVELS || n + 1 > _pages) return false;
+		count[levels++] = n;
+		if (n == 1) break;
+		n = (n + _fanout() - 1) / _fanout();
+	}
+
+	// Stored top down
+	for (uint8_t l=0; l<levels; l++) {
+		_count[l] = count[levels - 1 - l];
+		_start[l] = start;
+		start	 += _count[l];
+	}
+	if (start + 1 > _pages) return false;
+	if (_base + (uint32_t)(start + 1) * _pageSize > (uint32_t)_ee->get_pages() * _pageSize)
+		return false;
+
+	_levels = levels;
+	return true;
+}
+
+
+bool I2C_eepromTree::_readNode(const uint16_t page, uint8_t* buffer) {
+	_pageReads++;
+	return _ee->readBlock(_node(page), buffer, _pageSize) == _pageSize;
+}
+
+uint32_t I2C_eepromTree::_node(const uint16_t page) {
+	return _base + (uint32_t)(page + 1) * _pageSize;
+}
+
+
+int I2C_eepromTree::_writeHeader() {
+uint8_t		hdr[I2C_EEPROM_TREE_HEADER];
+uint32_t	crc;
+
+	memset(hdr, 0, sizeof(hdr));
+	hdr[0] = I2C_EEPROM_TREE_MAGIC & 0xFF;	hdr[1] = I2C_EEPROM_TREE_MAGIC >> 8;
+	hdr[2] = _keySize;			hdr[3] = _valueSize;
+	memcpy(hdr + 4, &_entries, sizeof(_entries));
+	crc = I2C_eeprom::crc32Update(0, hdr, 12);
+	memcpy(hdr + 12, &crc, sizeof(crc));
+
+	return _ee->writeBlock(_base, hdr, sizeof(hdr));
+}
@@ -0,0 +1,103 @@
+#ifndef I2C_EEPROM_TREE_H
+#define I2C_EEPROM_TREE_H
+//
+//    FILE: I2C_eepromTree.h
+// PURPOSE: Static B+tree of sorted records in PROM pages for I2C_eepromV2
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Fixed size records (key, value), sorted by key, one node per page:
+//
+//	| header | root | level 1 ... | leaf 0 | leaf 1 | ... |
+//	leaf:	| count | key value | key value | ... |
+//	node:	| count | first key of child 0 | of child 1 | ... |
+//
+// Nodes of a level are contiguous, so a child is found by its number and
+// a node holds keys only: with 128 byte pages and 4 byte keys a node has
+// 31 children. A 24x512 full of 8 byte records is a three level tree ...
+// three page reads per lookup. The leaves follow each other in key order,
+// a range scan reads on sequentially.
+//
+// Keys compare as unsigned bytes (memcmp): store numbers big endian, add
+// 0x80.. to signed ones. build() takes the records from a callback in
+// ascending order:
+//
+//	void cal(void* ctx, uint32_t i, uint8_t* rec) {
+//		memcpy_P(rec, &curve[i], 4);	// int16 temperature (BE, + 0x8000), uint16 value
+//	}
+//
+//	I2C_eepromTree	t(ee, 0, 512);
+//	t.build(2, 2, points, cal, NULL);
+//	t.seek(from);				// first record >= from
+//	while (t.next(rec) && memcmp(rec, to, 2) <= 0) ...
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+
+#define I2C_EEPROM_TREE_MAGIC	0x5442		// "BT"
+#define I2C_EEPROM_TREE_HEADER	16
+#define I2C_EEPROM_TREE_LEVELS	6		// leaves included
+
+
+typedef void (*I2C_eepromTreeSource)(void* ctx, const uint32_t i, uint8_t* record);
+
+
+class I2C_eepromTree {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    /**
+     * <pages> PROM pages from <base> (page aligned) on: the header page and the nodes
+     */
+    I2C_eepromTree(I2C_eeprom& ee, const uint16_t base, const uint16_t pages);
+
+    int		begin(void);		// load the header; I2C_EEPROM_ERR_VERIFY: no tree
+
+    int		build(		const uint8_t	keySize,
+				const uint8_t	valueSize,
+				const uint32_t	count,
+				I2C_eepromTreeSource source,
+				void*		ctx);
+
+    bool	find(const uint8_t* key, uint8_t* value = NULL);
+
+    bool	seek(const uint8_t* key);	// to the first record >= <key>; false: none
+    bool	next(uint8_t* record);		// record at the cursor, cursor on
+
+    uint32_t	get_entries(void);
+    uint8_t	get_levels(void);
+    uint16_t	get_nodes(void);		// pages used, header not counted
+    uint32_t	get_pageReads(void);
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    uint16_t	_base;
+    uint16_t	_pages;
+    uint16_t	_pageSize;
+    uint8_t	_keySize;
+    uint8_t	_valueSize;
+    uint32_t	_entries;
+    uint8_t	_levels;
+    uint16_t	_start[I2C_EEPROM_TREE_LEVELS];	// first page of a level; 0 = root
+    uint16_t	_count[I2C_EEPROM_TREE_LEVELS];	// nodes of a level
+    uint32_t	_pageReads;
+
+    uint8_t	_leaf[I2C_EEPROM_PAGEMAX];	// leaf under the cursor
+    uint16_t	_leafNo;
+    uint8_t	_slot;
+
+    uint8_t	_leafSlots(void);
+    uint8_t	_fanout(void);
+    bool	_shape(void);
+    bool	_seek(const uint8_t* key, const bool equal);
+    bool	_readNode(const uint16_t page, uint8_t* buffer);
+    uint32_t	_node(const uint16_t page);
+    int		_writeHeader(void);
+};
+#endif
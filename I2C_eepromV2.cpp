@@ -70,20 +70,78 @@
 //			- Bugs?? Find them and keep 'em in a warm place ...
 //
 //
+// 2.1.0b - 2026-10-18  [ --------[ Extensions ] ---------------------------------------------
+//			- copyTo() copies between PROMs (or within one) chunk by chunk;
+//			  chunks that already match on the destination are not written.
+//			  Source reads run while the destination is in its write cycle.
+//			- setMirror()/syncMirror(): a backup PROM gets every write as well
+//			- writeStream() flashes an image from any Stream (i.e. Serial)
+//			  chunk by chunk while receiving; verified by CRC-32 read back.
+//			  crc32() over a PROM range; crc32Update() zlib compatible.
+//			- I2C_eepromLZ: compressed, page aligned frame log (LZSS)
+//			- I2C_eepromAsync: non-blocking transfers stepped by poll(),
+//			  write cycles are waited for without blocking. Transactions
+//			  by I2C_eepromBus::startTransfer(): interrupt driven on AVR
+//			  with I2C_EEPROM_TWI (I2C_eepromTWI replaces Wire)
+//			- Transport: I2C_eepromBus given at construction; backends for
+//			  Wire-alikes (I2C_eepromWireT), Linux i2c-dev (I2C_eepromLinux)
+//			  and an in-memory simulator (I2C_eepromSim). Builds on a host.
+//			- FRAM (FM24/MB85RC): pass I2C_EEPROM_FRAM|<Kbit> as type.
+//			  No ACK polling, no page splitting.
+//			- writeBlock_P(), updateBlock_P(): write straight from PROGMEM;
+//			  updateBlock() skips chunks the PROM already holds.
+//			  setBlock() needs no fill buffer any more.
+//			- I2C_eepromQueue: lock-free ring, push() in an ISR,
+//			  drain() in loop() writes page-sized batches
+//			- I2C_EEPROM_THREADSAFE: bus mutex held per transaction;
+//			  status(buffer, size); I2C_eepromWorker serves many tasks
+//			  from one and merges adjacent writes.
+//			- writev()/readv(): scatter-gather; parts in one page become
+//			  one page write, close reads one sequential read.
+//			- I2C_eepromShadow: RAM mirror of a region; sync() writes the
+//			  pages whose CRC changed, no read back
+//			- I2C_eepromRemap: logical pages, verified writes, bad pages
+//			  retired to spares, table kept twice; I2C_eepromSim can
+//			  model worn cells
+//			- I2C_eepromECC: 3 parity bytes per page; one bit error
+//			  corrected, two detected (I2C_EEPROM_ERR_ECC)
+//			- I2C_eepromCounter: unary bits over rotating pages; an
+//			  increment is a byte write, value() a RAM read
+//			- I2C_eepromHash: page sized buckets, one page read per
+//			  lookup; build() writes the table in full pages
+//			- I2C_eepromTree: static B+tree, node = page; seek()/next()
+//			  for range scans over the leaves in key order
+//			- I2C_eepromTS: page blocks of samples in a ring, time index;
+//			  seek() is a binary search of the index
+//			- I2C_eepromBD: block device for a filesystem, page = program
+//			  unit; I2C_eepromLFS.h hooks it up to LittleFS
+//			- setCipher(): ChaCha20 keystream by PROM address XORed in
+//			  on the bus, no buffer; random access reads keep working
+//			- I2C_EEPROM_TRACE: ring of bus transactions and write cycle
+//			  waits; binary dump(), Chrome trace JSON on a host
+//			- I2C_EEPROM_CAPTURE: call log of a sketch; I2C_eepromReplay
+//			  runs it on the simulator, latency percentiles per call
+//			- I2C_EEPROM_LEAN: geometry worked out from page size and size,
+//			  no status buffer; status(Print&). 24xx32 has 128 pages, not 256
+//			- I2C_EEPROM_PROFILE: READONLY drops write, poll and fill code,
+//			  READWRITE the snprintf() status(); FULL is the default
+//			- probe(), scan(), detect(): size and address words by address
+//			  wrap, reads only (one address word: sequential rollover
+//			  seen through current address reads). 24xx04/08/16: one
+//			  address word, A8..A10 in the device address
+//			- I2C_eepromGroup: PROMs striped into one address space, all
+//			  writing at once; one task per bus (Wire, Wire1, ...) or
+//			  background buses polled in turn
+//
 // --------------------------------------------------------------------------------------------
 // Released to the public domain
 // --------------------------------------------------------------------------------------------
 
 
 #include <I2C_eepromV2.h>
-
-#if defined(ARDUINO) && ARDUINO >= 100
-    #define WIRE_WRITE Wire.write
-    #define WIRE_READ  Wire.read
-#else
-    #define WIRE_WRITE Wire.send
-    #define WIRE_READ  Wire.receive
-#endif
+#include <I2C_eepromCipher.h>
+#include <I2C_eepromTrace.h>
+#include <I2C_eepromReplay.h>
 
 
 //
@@ -91,6 +149,30 @@
 //
 #define I2C_WRITEDELAY  5000	// uSecs to wait between writes
 
+#ifdef I2C_EEPROM_TRACE
+#define TRACE_NOW()			micros()
+#define TRACE(type, addr, len, start, rv) I2C_eepromTrace::record(type, _deviceAddress, addr, len, start, rv)
+#else
+#define TRACE_NOW()			0
+#define TRACE(type, addr, len, start, rv) ((void)(start))
+#endif
+
+#ifdef I2C_EEPROM_LEAN
+static_assert(sizeof(I2C_eeprom) <= I2C_EEPROM_LEAN_BUDGET, "I2C_EEPROM_LEAN: instance over budget");
+#endif
+
+#ifdef I2C_EEPROM_CAPTURE
+#define CAPTURE(c, addr, len)		I2C_eepromCapture::op(c, _deviceAddress, addr, len)
+#else
+#define CAPTURE(c, addr, len)
+#endif
+
+#if defined(ARDUINO) && defined(I2C_EEPROM_TWI)
+static I2C_eepromTWI	I2C_eepromDefaultBus;
+#elif defined(ARDUINO)
+static I2C_eepromWire	I2C_eepromDefaultBus(Wire);
+#endif
+
 
 //
 // Constructor ...
@@ -104,11 +186,30 @@
 //		For a 24LC128 	pass 128
 //		... a.s.o.
 //
+#ifdef ARDUINO
 I2C_eeprom::I2C_eeprom(const uint8_t deviceAddress, const unsigned int DEVtype) {
+	this->_bus = &I2C_eepromDefaultBus;
+	_setup(deviceAddress, DEVtype);
+}
+#endif
+
+I2C_eeprom::I2C_eeprom(I2C_eepromBus& bus, const uint8_t deviceAddress, const unsigned int DEVtype) {
+	this->_bus = &bus;
+	_setup(deviceAddress, DEVtype);
+}
+
+
+//
+// Geometry of the PROM by its type
+//
+void I2C_eeprom::_setup(const uint8_t deviceAddress, const unsigned int DEVtype) {
 
 	this->_deviceAddress	= deviceAddress;
-	this->_deviceSize	= DEVtype;
-	this->_Kbytes		= DEVtype/8;
+	this->_deviceSize	= DEVtype & ~I2C_EEPROM_FRAM;
+	this->_fram		= (DEVtype & I2C_EEPROM_FRAM) != 0;
+	this->_mirror		= NULL;
+	this->_cipher		= NULL;
+	this->_writing		= false;
 
 	//
 	// Setup for specific PROM ... determined by it's type
@@ -116,86 +217,83 @@ I2C_eeprom::I2C_eeprom(const uint8_t deviceAddress, const unsigned int DEVtype)
 	// 24xx01..512 	...	are supported
 	// 24xx1024 	...	needs code not yet implemented /hph Jan-2016
 	//
+	// The page size is all the table holds: pages, address bits and words
+	// follow from it and the size (see _geoPages() et al.)
+	//
 	switch (DEVtype) {  		// see also ATMEL's information
 		// -------------------- PS 8 -- 1 address word ----- 
-		case 1		:	this->_pages            = 16;
-					this->_pageSize		= 8;
-					this->_addrBits		= 7;
-					this->_addrWords        = 1;
-					break;
-
-		case 2		:	this->_pages            = 32;
-					this->_pageSize         = 8;
-                                        this->_addrBits		= 8;
-					this->_addrWords        = 1;
+		case 1		:
+		case 2		:	this->_pageSize		= 8;
 					break;
 
-		// -------------------- PS 16 & 2 address words ----- 
-		case 4		:	this->_pages            = 32;
-					this->_pageSize         = 16;
-					this->_addrBits		= 9;
-					this->_addrWords        = 2;
-					break;
-
-		case 8		:	this->_pages            = 64;
-                                        this->_pageSize         = 16;
-                                        this->_addrBits		= 10;
-					this->_addrWords        = 2;
-					break;
-
-		case 16		:	this->_pages		= 128;
-					this->_pageSize         = 16;
-					this->_addrBits		= 11;
-					this->_addrWords        = 2;
+		// -------------------- PS 16 -- 1 address word ----- 
+		// A8..A10 go in the device address: 2..8 of them
+		case 4		:
+		case 8		:
+		case 16		:	this->_pageSize		= 16;
 					break;
 	
 		// -------------------- PS 32 ------------------------ 
-		case 32		:	this->_pages            = 256;
-					this->_pageSize         = 32;
-					this->_addrBits		= 12;
-					this->_addrWords        = 2;
-					break;
-
-		case 64		:	this->_pages            = 256;
-					this->_pageSize		= 32;
-					this->_addrBits		= 13;
-					this->_addrWords        = 2;
+		case 32		:
+		case 64		:	this->_pageSize		= 32;
 					break;
 
 		// -------------------- PS 64 ------------------------ 
-		case 128	:	this->_pages		= 256;
-					this->_pageSize         = 64;
-					this->_addrBits		= 14;
-					this->_addrWords        = 2;
+		case 128	:
+		case 256	:	this->_pageSize		= 64;
 					break;
 
-		case 256	:	this->_pages		= 512;
-					this->_pageSize         = 64;
-					this->_addrBits		= 15;
-					this->_addrWords        = 2;
+		// -------------------- PS 128 ----------------------- 
+		case 512	:	this->_pageSize		= 128;
 					break;
 
-		// -------------------- PS 128 ----------------------- 
-		case 512	:	this->_pages		= 512;
-					this->_pageSize         = 128;
-					this->_addrBits		= 16;
-					this->_addrWords        = 2;
+		// -------------------- FRAM -------------------------
+		// No write cycle, no page: runs are written in one transaction.
+		// Page size is nominal ... for layouts built on top (I2C_eepromLZ et al.)
+		case I2C_EEPROM_FRAM|64	:			// FM24CL64, MB85RC64
+		case I2C_EEPROM_FRAM|128 :			// MB85RC128
+		case I2C_EEPROM_FRAM|256 :			// FM24W256, MB85RC256V
+		case I2C_EEPROM_FRAM|512 :			// MB85RC512T
+					this->_pageSize		= 128;
 					break;
 
 		// -------------------- PS 256 ----------------------- 
 		// This is still a curious thing	
-		// case 1024	:	this->_pages		= 512;
-		//			this->_pageSize         = 256;
-		//			this->_addrBits		= 17;	// 17 bit addressing ??
-		//			this->_addrWords        = 3;	// Actually this is "three-word" 
+		// case 1024	:	this->_pageSize         = 256;
+		//			17 bit addressing ?? Actually this is "three-word" 
 		//			break;
 
-		default		:	this->_pages            = 0;
-					this->_pageSize		= 0;
-					this->_addrBits		= 0;
-					this->_addrWords        = 0;
+		default		:	this->_pageSize		= 0;
 					break;	
 	}
+
+#ifndef I2C_EEPROM_LEAN
+	this->_Kbytes		= this->_deviceSize/8;
+	this->_pages		= _geoPages();
+	this->_addrBits		= _geoAddrBits();
+	this->_addrWords	= _geoAddrWords();
+#endif
+}
+
+
+//
+// Geometry from page size and size ... 0 for an unknown type
+//
+uint16_t I2C_eeprom::_geoPages() {
+	return (_pageSize == 0) ? 0 : ((uint32_t)_deviceSize << 7) / _pageSize;
+}
+
+uint8_t I2C_eeprom::_geoAddrBits() {
+uint8_t bits = 7;				// 24xx01: 128 bytes
+
+	if (_pageSize == 0) return 0;
+	while ((1UL << bits) < ((uint32_t)_deviceSize << 7)) bits++;
+	return bits;
+}
+
+uint8_t I2C_eeprom::_geoAddrWords() {
+	if (_pageSize == 0) return 0;
+	return (_deviceSize > 16) ? 2 : 1;
 }
 
 
@@ -204,54 +302,220 @@ I2C_eeprom::I2C_eeprom(const uint8_t deviceAddress, const unsigned int DEVtype)
 // Introducer
 //
 void I2C_eeprom::begin(int speed) {
-    Wire.begin();
     _lastWrite = 0;
-
-// TWBR is not available on Arduino Due
-#ifdef TWBR
-// TWBR = 72;  /* Sanity value */
-// 0=1000, 1=888, 2=800, 8=500, 12=400, 24=250, 32=200, 72=100, 152=50 [Khz]
-// F_CPU/16+(2*TWBR) // TWBR is a uint8_t
+    _writing   = false;
 
 	switch (speed) {
-		case  50:	TWBR=152;	this->_speed=50;	break;
-		case 100:	TWBR=72;	this->_speed=100;	break;
-		case 200:	TWBR=32;	this->_speed=200;	break;
-		case 250:	TWBR=24;	this->_speed=250;       break;
-		case 400:	TWBR=12;	this->_speed=400;       break;
-		case 500:	TWBR=8;		this->_speed=500;       break;
-		case 800:	TWBR=2;		this->_speed=800;       break;
-		case 888:	TWBR=1;		this->_speed=888;       break;
-		case 1000:	TWBR=0;		this->_speed=1000;      break;
-		default:	TWBR=72; 	this->_speed=100;
+		case  50:
+		case 100:
+		case 200:
+		case 250:
+		case 400:
+		case 500:
+		case 800:
+		case 888:
+		case 1000:	this->_speed=speed;	break;
+		default:	this->_speed=100;
 	}
-#endif
+
+	// The bus sets its clock accordingly ... TWBR on AVR, see I2C_eepromBus.h
+	_bus->begin(this->_speed);
 }
 
 
+#if I2C_EEPROM_PROFILE == I2C_EEPROM_FULL
 //
 // Return a pointer to msg buffer to get instantiation guts ... helps debugging
 //
+#ifndef I2C_EEPROM_LEAN
 char* I2C_eeprom::status() {
-	sprintf(_statbuf,"\n24x%d @ 0x%02x, %dKhz\nKBytes: %d, Pages: %d, Page size: %d\nAddrbits: %d, Addrwords: %d\n",
+	return status(_statbuf, sizeof(_statbuf));
+}
+#endif
+
+//
+// Same into the caller's <buffer> ... for tasks sharing an instance
+//
+char* I2C_eeprom::status(char* buffer, const size_t size) {
+	snprintf(buffer, size,"\n%s%d @ 0x%02x, %dKhz\nKBytes: %d, Pages: %d, Page size: %d\nAddrbits: %d, Addrwords: %d\n",
+		this->_fram ? "FRAM " : "24x",
 		this->_deviceSize, 	this->_deviceAddress,	this->_speed,
-		this->_Kbytes,		this->_pages, 		this->_pageSize,
-		this->_addrBits, 	this->_addrWords);
+		get_Kbytes(),		get_pages(), 		this->_pageSize,
+		get_addrBits(), 	get_addrWords());
+
+	return buffer;
+}
+#endif
+
+//
+// Same straight to <out> ... no buffer at all
+//
+void I2C_eeprom::status(Print& out) {
+	out.print('\n');
+	out.print(this->_fram ? "FRAM " : "24x");
+	out.print((unsigned int)this->_deviceSize);
+	out.print(" @ 0x");
+	if (this->_deviceAddress < 0x10) out.print('0');
+	out.print((unsigned int)this->_deviceAddress, HEX);
+	out.print(", ");
+	out.print((unsigned int)this->_speed);
+	out.print("Khz\nKBytes: ");
+	out.print(get_Kbytes());
+	out.print(", Pages: ");
+	out.print(get_pages());
+	out.print(", Page size: ");
+	out.print((unsigned int)this->_pageSize);
+	out.print("\nAddrbits: ");
+	out.print(get_addrBits());
+	out.print(", Addrwords: ");
+	out.print(get_addrWords());
+	out.print('\n');
+}
+
+
+//
+// What answers @ <deviceAddress>? Reads only ... nothing is written.
+//
+// Address words: no random read is made before they are known, since a PROM
+// given more address words than it takes latches the rest as write data
+// (moving its counter on) and a repeated START drops that write ... how the
+// counter ends up is not something to build on. Current address reads need
+// no address at all and a sequential read rolls over at the end of the PROM:
+// data repeating every 128..2048 bytes is a 24xx01..16 (one address word).
+// A period counts only when a whole one comes again (CRC-32 of each 128
+// bytes read), so records with equal headers don't make one; where the
+// counter starts doesn't matter. That costs up to 4 KB of reads (100 ms at
+// 400 kHz) for larger PROMs, about 2 KB on data that doesn't repeat.
+// Size of those: past its end a PROM wraps to 0. The first power of two that
+// reads as 0 does, in I2C_EEPROM_PROBE_WINDOWS windows spread unaligned over
+// the first 4 KB, is its size.
+// Data that really repeats (the same record all over the PROM) can't be told
+// from a wrap: it gives a smaller size, never a larger one. detect() keeps
+// the constructor's type on that doubt.
+// Page size follows from the size (see _setup()): standard parts assumed.
+// returns the type for the constructor, 0 = no answer,
+// I2C_EEPROM_BLANK = answers, but the bytes it reads are all alike
+//
+unsigned int I2C_eeprom::probe(I2C_eepromBus& bus, const uint8_t deviceAddress) {
+uint32_t	crc[2 * I2C_EEPROM_PROBE_SPAN / 128];	// per 128 bytes read
+uint8_t		window[I2C_EEPROM_PROBE_WINDOWS][I2C_EEPROM_PROBE_BYTES];
+uint8_t		buf[I2C_TWIBUFFERSIZE];
+uint8_t		chunk = min(sizeof(buf), bus.get_bufferSize());
+uint8_t		blocks = 0;
+uint8_t		pos = 0;
+uint8_t		first = 0;
+uint8_t		failed = 0;			// bit n: period of 128 << n bytes ruled out
+uint8_t		periods = 0;
+bool		alike = true;
+bool		ack;
+
+	for (uint16_t p=128; p<=I2C_EEPROM_PROBE_SPAN; p*=2) periods++;
+
+	bus.lock();
+	bus.beginTransmission(deviceAddress);
+	ack = bus.endTransmission() == 0;
+	bus.unlock();
+	if (!ack) return 0;
+
+	// Does each 128 bytes come again <period> bytes on, for a whole period?
+	crc[0] = 0;
+	while (failed != (1 << periods) - 1) {
+		if (!_probeRead(bus, deviceAddress, 0, 0, buf, chunk)) return 0;
+
+		for (uint8_t i=0; i<chunk; i++) {
+			if (blocks == 0 && pos == 0) first = buf[i];
+			alike = alike && buf[i] == first;
+			crc[blocks] = crc32Update(crc[blocks], buf + i, 1);
+			if (++pos < 128) continue;
+
+			// A block complete: against the one a period back
+			pos = 0;
+			blocks++;
+			for (uint8_t n=0; n<periods; n++) {
+				uint8_t p = 1 << n;
+
+				if ((failed & (1 << n)) || blocks <= p) continue;
+				if (crc[blocks - 1] != crc[blocks - 1 - p]) {
+					failed |= 1 << n;
+				} else if (blocks == 2 * p) {
+					return alike ? I2C_EEPROM_BLANK : p;
+				}
+			}
+			if (blocks == sizeof(crc) / sizeof(crc[0])) break;
+			crc[blocks] = 0;
+		}
+	}
 
-	return _statbuf;
+	// Two address words: windows at 0, 1021, 2042, .. and a size on
+	for (uint8_t w=0; w<I2C_EEPROM_PROBE_WINDOWS; w++)
+		if (!_probeRead(bus, deviceAddress, w * 1021, 2, window[w], I2C_EEPROM_PROBE_BYTES)) return 0;
+	for (unsigned int kbit=32; kbit<512; kbit*=2) {
+		uint8_t w;
+
+		for (w=0; w<I2C_EEPROM_PROBE_WINDOWS; w++) {
+			if (!_probeRead(bus, deviceAddress, (kbit << 7) + w * 1021, 2, buf, I2C_EEPROM_PROBE_BYTES)) return 0;
+			if (memcmp(buf, window[w], I2C_EEPROM_PROBE_BYTES) != 0) break;
+		}
+		if (w == I2C_EEPROM_PROBE_WINDOWS) return kbit;
+	}
+	return 512;
 }
 
+//
+// probe() I2C_EEPROM_PROBE_FIRST..LAST on a running <bus>
+// returns the number found; their addresses in <address>, types in <type>
+//
+uint8_t I2C_eeprom::scan(I2C_eepromBus& bus, uint8_t* address, unsigned int* type, const uint8_t max) {
+uint8_t	n = 0;
 
+	for (uint8_t a=I2C_EEPROM_PROBE_FIRST; a<=I2C_EEPROM_PROBE_LAST && n<max; a++) {
+		unsigned int t = probe(bus, a);
 
+		if (t == 0) continue;
+		address[n] = a;
+		if (type != NULL) type[n] = t;
+		n++;
+		if (t >= 4 && t <= 16) a += t / 2 - 1;		// 24xx04/08/16: its other blocks
+	}
+	return n;
+}
+
+//
+// Take the geometry probe() finds rather than the constructor's. FRAM stays
+// FRAM; an instance on a block address of a 24xx04/08/16 past the first one
+// keeps the constructor's type. One address word found where the constructor
+// said two rests on the data repeating, which it may do by itself: written
+// with one word, a two word PROM would take the data bytes as address, so
+// the constructor's type stays (construct with 1..16 to size such parts).
+// returns 0 = OK, I2C_EEPROM_ERR_READ = no answer,
+// I2C_EEPROM_ERR_VERIFY = blank or in doubt: the constructor's type stays
+//
+int I2C_eeprom::detect() {
+unsigned int		type = probe(*_bus, _deviceAddress);
+I2C_eeprom*		mirror = _mirror;
+I2C_eepromCipher*	cipher = _cipher;
+
+	if (type == 0) return I2C_EEPROM_ERR_READ;
+	if (type == I2C_EEPROM_BLANK) return I2C_EEPROM_ERR_VERIFY;
+	if (type <= 16 && get_addrWords() > 1) return I2C_EEPROM_ERR_VERIFY;
+	if (type >= 4 && type <= 16 && (_deviceAddress & (type / 2 - 1)) != 0) return 0;
+	if (_fram && type >= 64) type |= I2C_EEPROM_FRAM;
+
+	_setup(_deviceAddress, type);
+	this->_mirror = mirror;
+	this->_cipher = cipher;
+	return 0;
+}
+
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
 //
 // Fill a block with byte xx
 //
 int I2C_eeprom::setBlock(const uint16_t memoryAddress, const uint8_t data, const uint16_t length) {
-uint8_t buffer[I2C_TWIBUFFERSIZE];
-	
-	for (uint8_t i=0; i<I2C_TWIBUFFERSIZE; i++) buffer[i] = data;
-
-	return ( _pageBlock(memoryAddress, buffer, length, false) );
+	CAPTURE('S', memoryAddress, length);
+	return ( _pageBlock(memoryAddress, &data, length, I2C_EEPROM_SRC_FILL) );
 }
 
 
@@ -260,6 +524,7 @@ uint8_t buffer[I2C_TWIBUFFERSIZE];
 // Return number of bytes written; here always 1
 //
 int I2C_eeprom::writeByte(const uint16_t memoryAddress, const uint8_t data) {
+	CAPTURE('w', memoryAddress, 1);
 	return ( _WriteBlock(memoryAddress, &data, 1) );
 }
 
@@ -269,9 +534,62 @@ int I2C_eeprom::writeByte(const uint16_t memoryAddress, const uint8_t data) {
 // Return number of bytes written
 //
 int I2C_eeprom::writeBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length) {
-    return ( _pageBlock(memoryAddress, buffer, length, true) );
+    CAPTURE('W', memoryAddress, length);
+    return ( _pageBlock(memoryAddress, buffer, length, I2C_EEPROM_SRC_RAM) );
+}
+
+
+//
+// As writeBlock() but chunks the PROM already holds are not written ...
+// saves write cycles (time and wear) on mostly unchanged data
+// returns 0 = OK otherwise error
+//
+int I2C_eeprom::updateBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length) {
+    CAPTURE('U', memoryAddress, length);
+    return ( _pageBlock(memoryAddress, buffer, length, I2C_EEPROM_SRC_RAM, true) );
+}
+
+
+//
+// Write <length> bytes from flash @ <data> (PROGMEM) to PROM's <memoryAddress>
+// Bytes go from pgm_read_byte() to the bus one by one, no RAM buffer
+// returns 0 = OK otherwise error
+//
+int I2C_eeprom::writeBlock_P(const uint16_t memoryAddress, const uint8_t* data, const uint16_t length) {
+    CAPTURE('W', memoryAddress, length);
+    return ( _pageBlock(memoryAddress, data, length, I2C_EEPROM_SRC_PGM) );
+}
+
+int I2C_eeprom::updateBlock_P(const uint16_t memoryAddress, const uint8_t* data, const uint16_t length) {
+    CAPTURE('U', memoryAddress, length);
+    return ( _pageBlock(memoryAddress, data, length, I2C_EEPROM_SRC_PGM, true) );
+}
+#else
+//
+// Read-only profile ... the write calls stay for the layers on top; they
+// write nothing
+//
+int I2C_eeprom::setBlock(const uint16_t, const uint8_t, const uint16_t)		{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::writeByte(const uint16_t, const uint8_t)			{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::writeBlock(const uint16_t, const uint8_t*, const uint16_t)	{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::updateBlock(const uint16_t, const uint8_t*, const uint16_t)	{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::writeBlock_P(const uint16_t, const uint8_t*, const uint16_t)	{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::updateBlock_P(const uint16_t, const uint8_t*, const uint16_t)	{ return I2C_EEPROM_ERR_READONLY; }
+int I2C_eeprom::syncMirror(I2C_eepromCopyStat*)					{ return I2C_EEPROM_ERR_READONLY; }
+
+int I2C_eeprom::copyTo(I2C_eeprom&, const uint16_t, const uint16_t, const uint32_t, I2C_eepromCopyStat*) {
+	return I2C_EEPROM_ERR_READONLY;
 }
 
+int I2C_eeprom::writeStream(Stream&, const uint16_t, const uint32_t, const uint8_t, uint32_t*) {
+	return I2C_EEPROM_ERR_READONLY;
+}
+
+int I2C_eeprom::writev(I2C_eepromSeg* seg, const uint8_t count) {
+	for (uint8_t i=0; i<count; i++) seg[i].status = I2C_EEPROM_ERR_READONLY;
+	return count ? I2C_EEPROM_ERR_READONLY : 0;
+}
+#endif
 
 //
 // Read byte at PROM's <memoryAddress>
@@ -280,6 +598,7 @@ int I2C_eeprom::writeBlock(const uint16_t memoryAddress, const uint8_t* buffer,
 uint8_t I2C_eeprom::readByte(const uint16_t memoryAddress) {
 uint8_t rdata;
 
+	CAPTURE('r', memoryAddress, 1);
 	_ReadBlock(memoryAddress, &rdata, 1);
 	return rdata;
 }
@@ -293,10 +612,11 @@ uint16_t I2C_eeprom::readBlock(const uint16_t memoryAddress, uint8_t* buffer, co
 uint16_t addr 	= memoryAddress;
 uint16_t len 	= length;
 uint16_t rv 	= 0;
-uint8_t  cnt;
+uint16_t cnt;
 
+    CAPTURE('R', memoryAddress, length);
     while (len > 0) {
-        cnt	 = min(len, I2C_TWIBUFFERSIZE);
+        cnt	 = min(len, _chunk());
         rv	+= _ReadBlock(addr, buffer, cnt);
         addr	+= cnt;
         buffer	+= cnt;
@@ -306,17 +626,287 @@ uint8_t  cnt;
     return rv;
 }
 
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// Copy <length> bytes from this PROM @ <srcAddr> to PROM <dst> @ <dstAddr>
+//
+// Works in write chunks of the destination (page and bus buffer bound).
+// Each chunk is read from the source while the destination still runs the
+// write cycle of the previous one. It's then compared against the destination
+// and only written if it differs ... re-provisioning a unit costs reads only.
+// <dst> may be this PROM as long as the ranges do not overlap.
+// returns 0 = OK otherwise error
+//
+int I2C_eeprom::copyTo(I2C_eeprom& dst, const uint16_t srcAddr, const uint16_t dstAddr, const uint32_t length, I2C_eepromCopyStat* stat) {
+uint8_t		sbuf[I2C_EEPROM_PAGEMAX];
+uint8_t		dbuf[I2C_EEPROM_PAGEMAX];
+uint16_t	saddr	= srcAddr;
+uint16_t	daddr	= dstAddr;
+uint32_t	len	= length;
+uint32_t	start	= micros();
+uint16_t	written	= 0;
+uint16_t	skipped	= 0;
+int		rv	= 0;
+
+	if (srcAddr + length > this->_bytes() || dstAddr + length > dst._bytes())
+		return I2C_EEPROM_ERR_RANGE;
+
+	if (&dst == this && srcAddr < dstAddr + length && dstAddr < srcAddr + length)
+		return I2C_EEPROM_ERR_RANGE;
+
+	while (len > 0) {
+		uint16_t cnt = min(len, I2C_EEPROM_PAGEMAX);
+		cnt = min(cnt, dst._chainChunk(daddr));
+		cnt = min(cnt, _chunk());
+
+		if (_ReadBlock(saddr, sbuf, cnt) != cnt) {
+			rv = I2C_EEPROM_ERR_READ;
+			break;
+		}
+
+		if (dst._ReadBlock(daddr, dbuf, cnt) == cnt && memcmp(sbuf, dbuf, cnt) == 0) {
+			skipped++;
+		} else {
+			rv = dst._WriteBlock(daddr, sbuf, cnt);
+			if (rv != 0) break;
+			written++;
+		}
+
+		saddr	+= cnt;
+		daddr	+= cnt;
+		len	-= cnt;
+	}
+
+	if (stat != NULL) {
+		stat->bytes	= length - len;
+		stat->written	= written;
+		stat->skipped	= skipped;
+		stat->micros	= micros() - start;
+		stat->rate	= stat->micros ? (uint32_t)((uint64_t)stat->bytes * 1000000UL / stat->micros) : 0;
+	}
+	return rv;
+}
+#endif
+
+//
+// Mirroring ... every write to this PROM goes to <backup> as well, same address.
+// Both write cycles overlap, so a mirrored write costs little more than a plain one.
+// Reads are served by this PROM only. Call syncMirror() once to level both.
+// A backup whose chain leads back to this PROM would write forever: refused,
+// mirroring ends.
+//
+void I2C_eeprom::setMirror(I2C_eeprom* backup) {
+	for (I2C_eeprom* m = backup; m != NULL; m = m->_mirror)
+		if (m == this) {
+			backup = NULL;
+			break;
+		}
+	this->_mirror = backup;
+}
+
+I2C_eeprom* I2C_eeprom::get_mirror() {
+	return this->_mirror;
+}
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+int I2C_eeprom::syncMirror(I2C_eepromCopyStat* stat) {
+	if (this->_mirror == NULL) return 0;
+
+	return copyTo(*this->_mirror, 0, 0, min(this->_bytes(), this->_mirror->_bytes()), stat);
+}
+#endif
+
+//
+// Encryption at rest ... see I2C_eepromCipher.h
+//
+void I2C_eeprom::setCipher(I2C_eepromCipher* cipher) {
+	this->_cipher = cipher;
+}
+
+I2C_eepromCipher* I2C_eeprom::get_cipher() {
+	return this->_cipher;
+}
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// Flash <length> bytes from Stream <in> to PROM @ <memoryAddress>
+//
+// Bytes are collected into one write chunk (page and bus buffer bound) and sent
+// as soon as it is full; the next chunk is received during the write cycle.
+// With I2C_EEPROM_FLOW_ACK one I2C_EEPROM_ACK byte is sent back per chunk received;
+// a sender waiting for it never overruns the serial RX buffer.
+// The image CRC-32 is taken on the fly and checked against a read back at the end.
+// returns 0 = OK otherwise error; <crc> gets the image CRC-32 if not NULL
+//
+int I2C_eeprom::writeStream(Stream& in, const uint16_t memoryAddress, const uint32_t length, const uint8_t flow, uint32_t* crc) {
+uint8_t		buffer[I2C_EEPROM_PAGEMAX];
+uint16_t	addr	= memoryAddress;
+uint32_t	len	= length;
+uint32_t	sum	= 0;
+uint32_t	before;
+int		rv;
+
+	if (memoryAddress + length > this->_bytes())
+		return I2C_EEPROM_ERR_RANGE;
+
+	while (len > 0) {
+		uint16_t cnt = min(len, I2C_EEPROM_PAGEMAX);
+		cnt = min(cnt, _chainChunk(addr));
+
+		uint16_t got = 0;
+		before = millis();
+		while ((got < cnt) && ((millis() - before) < I2C_EEPROM_TIMEOUT)) {
+			int c = in.read();
+			if (c >= 0)
+				buffer[got++] = c;
+		}
+		if (got < cnt) return I2C_EEPROM_ERR_READ;
+
+		if (flow == I2C_EEPROM_FLOW_ACK)
+			in.write(I2C_EEPROM_ACK);
+
+		rv = _WriteBlock(addr, buffer, cnt);
+		if (rv != 0) return rv;
+
+		sum	 = crc32Update(sum, buffer, cnt);
+		addr	+= cnt;
+		len	-= cnt;
+	}
+
+	if (crc != NULL) *crc = sum;
+
+	if (crc32(memoryAddress, length) != sum)
+		return I2C_EEPROM_ERR_VERIFY;
+
+	return 0;
+}
+#endif
+
+
+//
+// CRC-32 (IEEE 802.3, as zlib's crc32()) of <length> bytes @ <memoryAddress>
+//
+uint32_t I2C_eeprom::crc32(const uint16_t memoryAddress, const uint32_t length) {
+uint8_t		buffer[I2C_EEPROM_PAGEMAX];
+uint16_t	addr	= memoryAddress;
+uint32_t	len	= length;
+uint32_t	sum	= 0;
+
+	while (len > 0) {
+		uint16_t cnt = min(len, I2C_EEPROM_PAGEMAX);
+		cnt = min(cnt, _chunk());
+
+		cnt	 = _ReadBlock(addr, buffer, cnt);
+		if (cnt == 0) break;
+
+		sum	 = crc32Update(sum, buffer, cnt);
+		addr	+= cnt;
+		len	-= cnt;
+	}
+	return sum;
+}
+
+
+//
+// Running CRC-32; start with crc = 0. Bitwise ... no table to keep flash small
+//
+uint32_t I2C_eeprom::crc32Update(uint32_t crc, const uint8_t* buffer, const uint16_t length) {
+	crc = ~crc;
+	for (uint16_t i=0; i<length; i++) {
+		crc ^= buffer[i];
+		for (uint8_t b=0; b<8; b++)
+			crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+	}
+	return ~crc;
+}
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// Scatter-gather write: <count> segments of (address, buffer, length)
+//
+// Segments are sorted by address; all parts falling into one page go out as
+// one page write (page and bus chunk bound as writeBlock()). Gaps between them
+// inside the page are read first and written back unchanged. Overlapping
+// segments are written one by one in the given order instead.
+// Sets each segment's status; returns 0 = all OK otherwise the first error
+//
+int I2C_eeprom::writev(I2C_eepromSeg* seg, const uint8_t count) {
+int	rv = 0;
+
+	for (uint8_t base=0; base<count; base+=I2C_EEPROM_SEGMAX) {
+		int r = _writev(seg + base, min(count - base, I2C_EEPROM_SEGMAX));
+		if (rv == 0) rv = r;
+	}
+	return rv;
+}
+#endif
+
+//
+// Scatter-gather read: sorted by address, segments closer than
+// I2C_EEPROM_READGAP bytes are read in one sequential run
+// Sets each segment's status; returns 0 = all OK otherwise the first error
+//
+int I2C_eeprom::readv(I2C_eepromSeg* seg, const uint8_t count) {
+int	rv = 0;
+
+	for (uint8_t base=0; base<count; base+=I2C_EEPROM_SEGMAX) {
+		int r = _readv(seg + base, min(count - base, I2C_EEPROM_SEGMAX));
+		if (rv == 0) rv = r;
+	}
+	return rv;
+}
+
+
 //
 // Utility functions
 //
 uint8_t		I2C_eeprom::get_deviceAddress() 	{ return _deviceAddress; 	}
 int		I2C_eeprom::get_deviceSize() 		{ return _deviceSize; 		}
-int 		I2C_eeprom::get_pages() 		{ return _pages; 		}
 int 		I2C_eeprom::get_pageSize()		{ return _pageSize;		}
+#ifdef I2C_EEPROM_LEAN
+int 		I2C_eeprom::get_pages() 		{ return _geoPages(); 		}
+int 		I2C_eeprom::get_Kbytes()		{ return _deviceSize/8;		}
+int 		I2C_eeprom::get_addrBits()		{ return _geoAddrBits();	}
+int 		I2C_eeprom::get_addrWords()		{ return _geoAddrWords();	}
+#else
+int 		I2C_eeprom::get_pages() 		{ return _pages; 		}
 int 		I2C_eeprom::get_Kbytes()		{ return _Kbytes;		}
 int 		I2C_eeprom::get_addrBits()		{ return _addrBits;		}
 int 		I2C_eeprom::get_addrWords()		{ return _addrWords;		}
+#endif
 int 		I2C_eeprom::get_speed()			{ return _speed;		}
+I2C_eepromBus*	I2C_eeprom::get_bus()			{ return _bus;			}
+
+uint32_t	I2C_eeprom::_bytes()			{ return (uint32_t)get_pages() * _pageSize; }
+uint16_t	I2C_eeprom::_chunk()			{ return _bus->get_bufferSize() - get_addrWords(); }
+bool		I2C_eeprom::isFRAM()			{ return _fram;			}
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// Bytes one write transaction may take @ <memoryAddress>: up to the page
+// boundary; FRAM knows no pages
+//
+uint16_t I2C_eeprom::_writeChunk(const uint16_t memoryAddress) {
+	if (this->_fram) return _chunk();
+
+	return min(_chunk(), (uint16_t)(this->_pageSize - memoryAddress % this->_pageSize));
+}
+
+//
+// Bytes one write may take @ <memoryAddress> on this PROM and every mirror
+// behind it: each gets the same chunk (_WriteBlock), none may wrap in its page
+//
+uint16_t I2C_eeprom::_chainChunk(const uint16_t memoryAddress) {
+uint16_t cnt = _writeChunk(memoryAddress);
+
+	for (I2C_eeprom* m = this->_mirror; m != NULL; m = m->_mirror)
+		cnt = min(cnt, m->_writeChunk(memoryAddress));
+	return cnt;
+}
+#endif
 
 
 
@@ -327,98 +917,471 @@ int 		I2C_eeprom::get_speed()			{ return _speed;		}
 //
 ////////////////////////////////////////////////////////////////////
 
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// One byte of a write source
+//
+static inline uint8_t _srcByte(const uint8_t* buffer, const uint16_t i, const uint8_t source) {
+	switch (source) {
+		case I2C_EEPROM_SRC_FILL:	return buffer[0];
+		case I2C_EEPROM_SRC_PGM:	return pgm_read_byte(buffer + i);
+		default:			return buffer[i];
+	}
+}
+
+
 //
 // _pageBlock aligns buffer to page boundaries for writing.
-// and to TWI buffer size
+// and to bus buffer size
+// <update>: chunks already in the PROM are skipped
 // returns 0 = OK otherwise error
-int I2C_eeprom::_pageBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, const bool incrBuffer) {
+int I2C_eeprom::_pageBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, const uint8_t source, const bool update) {
 uint16_t	 addr = memoryAddress;
 uint16_t	 len = length;
 int		 rv = 0;
 
     while (len > 0) {
-        uint8_t bytesUntilPageBoundary = this->_pageSize - addr % this->_pageSize;
-        uint8_t cnt = min(len, bytesUntilPageBoundary);
-        cnt = min(cnt, I2C_TWIBUFFERSIZE);
+        uint16_t cnt = min(len, _chainChunk(addr));
 
-        rv = _WriteBlock(addr, buffer, cnt);
-        if (rv != 0) return rv;
+        if (!update || !_sameBlock(addr, buffer, cnt, source)) {
+           rv = _WriteBlock(addr, buffer, cnt, source);
+           if (rv != 0) return rv;
+        }
 
         addr += cnt;
-        if (incrBuffer)
+        if (source != I2C_EEPROM_SRC_FILL)
 	   buffer += cnt;
 
         len -= cnt;
     }
     return rv;
 }
+#endif
 
+//
+// Device address for <memoryAddress> ... a 24xx04/08/16 takes A8..A10 in it
+//
+uint8_t I2C_eeprom::_devAddr(const uint16_t memoryAddress) {
+	if (_deviceSize <= 2 || get_addrWords() != 1) return _deviceAddress;
+
+	return _deviceAddress | ((memoryAddress >> 8) & (_deviceSize / 2 - 1));
+}
 
 //
 // Supports one and 2 bytes addresses
 //
 void I2C_eeprom::_beginTransmission(const uint16_t memoryAddress) {
-	Wire.beginTransmission(_deviceAddress);
+uint8_t	addr[2];
 
-	if (this->_addrWords > 1) 
-		WIRE_WRITE((memoryAddress >> 8));	// Address High Byte
+	_bus->beginTransmission(_devAddr(memoryAddress));
 
-	WIRE_WRITE((memoryAddress & 0xFF)); 		// Address Low Byte
+	addr[0] = memoryAddress >> 8;			// Address High Byte
+	addr[1] = memoryAddress & 0xFF; 		// Address Low Byte
 							// (or only byte for chips 16K or smaller
 							// that only have one-word addresses)
+	if (get_addrWords() > 1)
+		_bus->write(addr, 2);
+	else
+		_bus->write(addr + 1, 1);
 }
 
 
+//
+// Read for probe() ... <words> address words, repeated START; 0 words:
+// a current address read
+// returns true = <length> bytes read
+//
+bool I2C_eeprom::_probeRead(I2C_eepromBus& bus, const uint8_t deviceAddress, const uint16_t memoryAddress, const uint8_t words, uint8_t* buffer, const uint8_t length) {
+uint8_t	addr[2];
+uint8_t	cnt = 0;
+
+	addr[0] = memoryAddress >> 8;
+	addr[1] = memoryAddress & 0xFF;
+
+	bus.lock();
+	if (words > 0) {
+		bus.beginTransmission(deviceAddress);
+		bus.write(addr + 2 - words, words);
+	}
+	if ((words == 0 || bus.endTransmission(false) == 0) && bus.requestFrom(deviceAddress, length) == length)
+		while (cnt < length && bus.available()) buffer[cnt++] = bus.read();
+	bus.unlock();
+	return cnt == length;
+}
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
 //
 // Write a block to PROM @ <memory address> from buffer pointer with length 
 //
-// pre: length <= this->_pageSize  && length <= I2C_TWIBUFFERSIZE;
+// pre: length <= _chainChunk(memoryAddress)
 // returns 0 = OK otherwise error
-int I2C_eeprom::_WriteBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint8_t length) {
+int I2C_eeprom::_WriteBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, const uint8_t source) {
 int	rv;
 
     waitEEReady();
 
-    this->_beginTransmission(memoryAddress);
+    rv = _sendBlock(memoryAddress, buffer, length, source);
 
-    WIRE_WRITE(buffer, length);
+    // Backup gets the same chunk while this PROM is busy writing
+    if (this->_mirror != NULL && rv == 0)
+	rv = this->_mirror->_WriteBlock(memoryAddress, buffer, length, source);
 
-    rv = Wire.endTransmission();
-    _lastWrite = micros();
     return rv;
 }
 
 
+//
+// The write transaction itself ... no wait, no mirror
+//
+int I2C_eeprom::_sendBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, const uint8_t source) {
+int		rv;
+uint32_t	start;
+
+    _lockReady();			// another task's write may have come in between
+
+    start = TRACE_NOW();
+    this->_beginTransmission(memoryAddress);
+
+    if (this->_cipher != NULL) {
+	_cipher->seek(memoryAddress);
+	for (uint16_t i=0; i<length; i++)
+		_bus->write(_srcByte(buffer, i, source) ^ _cipher->next());
+    } else if (source == I2C_EEPROM_SRC_RAM)
+	_bus->write(buffer, length);
+    else
+	for (uint16_t i=0; i<length; i++)
+		_bus->write(_srcByte(buffer, i, source));
+
+    rv = _bus->endTransmission();
+    _lastWrite = micros();
+    _writing   = !this->_fram;
+    TRACE(I2C_EEPROM_TRACE_WRITE, memoryAddress, length, start, rv);
+
+    _bus->unlock();
+    return rv;
+}
+#endif
+
 // Pre: Buffer is large enough to hold length bytes
 // returns bytes read
-uint8_t I2C_eeprom::_ReadBlock(const uint16_t memoryAddress, uint8_t* buffer, const uint8_t length) {
+uint16_t I2C_eeprom::_ReadBlock(const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length) {
+
+    waitEEReady();
+
+    return _fetchBlock(memoryAddress, buffer, length);
+}
+
+
+//
+// The read transaction itself ... no wait
+//
+uint16_t I2C_eeprom::_fetchBlock(const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length) {
 int		rv;
-uint8_t 	cnt = 0;
+uint16_t 	cnt = 0;
 uint32_t	before = millis();
+uint32_t	start;
 
-    waitEEReady();
+    _lockReady();
 
+    start = TRACE_NOW();
     this->_beginTransmission(memoryAddress);
 
-    rv = Wire.endTransmission();
-    if (rv != 0) return 0;  // error
+    rv = _bus->endTransmission(false);	// repeated START: i2c-dev makes it one combined transfer
+    if (rv == 0) {
+	if (this->_cipher != NULL) _cipher->seek(memoryAddress);
+	rv = _bus->requestFrom(_devAddr(memoryAddress), length);
+	before = millis();
+	while ((cnt < rv) && ((millis() - before) < I2C_EEPROM_TIMEOUT)) {
+	    if (!_bus->available()) continue;
+
+	    buffer[cnt] = _bus->read();
+	    if (this->_cipher != NULL) buffer[cnt] ^= _cipher->next();
+	    cnt++;
+	}
+    }
+    TRACE(I2C_EEPROM_TRACE_READ, memoryAddress, length, start, (cnt == length) ? 0 : I2C_EEPROM_ERR_READ);
+
+    _bus->unlock();
+    return cnt;
+}
+
+//
+// Range check, then an index of the good segments sorted by address (stable)
+// returns the number of indices
+//
+uint8_t I2C_eeprom::_sortSegs(I2C_eepromSeg* seg, const uint8_t count, uint8_t* idx) {
+uint8_t	n = 0;
+
+	for (uint8_t i=0; i<count; i++) {
+		if (seg[i].addr + (uint32_t)seg[i].len > _bytes()) {
+			seg[i].status = I2C_EEPROM_ERR_RANGE;
+			continue;
+		}
+		seg[i].status = 0;
+		if (seg[i].len == 0) continue;
+
+		uint8_t j = n++;
+		while (j > 0 && seg[idx[j-1]].addr > seg[i].addr) {
+			idx[j] = idx[j-1];
+			j--;
+		}
+		idx[j] = i;
+	}
+	return n;
+}
+
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+int I2C_eeprom::_writev(I2C_eepromSeg* seg, const uint8_t count) {
+uint8_t		idx[I2C_EEPROM_SEGMAX];
+uint8_t		stage[I2C_EEPROM_PAGEMAX];
+uint8_t		n = _sortSegs(seg, count, idx);
+uint8_t		k, j;
+uint32_t	lo, hi, pageEnd;
+int		rv;
+
+	// Overlaps: no merging, the order given decides
+	for (k=1; k<n; k++)
+		if (seg[idx[k]].addr < seg[idx[k-1]].addr + (uint32_t)seg[idx[k-1]].len) {
+			for (uint8_t i=0; i<count; i++)
+				if (seg[i].status == 0 && seg[i].len > 0)
+					seg[i].status = writeBlock(seg[i].addr, seg[i].buf, seg[i].len);
+			goto done;
+		}
+
+	k  = 0;
+	lo = (n > 0) ? seg[idx[0]].addr : 0;
+	while (k < n) {
+		// Parts of segments k..j-1 in the page of <lo>
+		pageEnd = lo - lo % _pageSize + (uint32_t)_pageSize;
+		hi = lo;
+		for (j=k; j<n && seg[idx[j]].addr < pageEnd; j++)
+			hi = min(seg[idx[j]].addr + (uint32_t)seg[idx[j]].len, pageEnd);
+
+		if (j == k + 1) {
+			// One part ... straight from the caller's buffer
+			I2C_eepromSeg* s = &seg[idx[k]];
+			rv = _pageBlock(lo, s->buf + (lo - s->addr), hi - lo, I2C_EEPROM_SRC_RAM);
+		} else {
+			// Gaps in between are read back first
+			rv = 0;
+			for (uint8_t g=k+1; g<j; g++)
+				if (seg[idx[g]].addr != seg[idx[g-1]].addr + seg[idx[g-1]].len) {
+					if (readBlock(lo, stage, hi - lo) != hi - lo) rv = I2C_EEPROM_ERR_READ;
+					break;
+				}
+
+			for (uint8_t g=k; g<j; g++) {
+				I2C_eepromSeg* s = &seg[idx[g]];
+				uint32_t from = max((uint32_t)s->addr, lo);
+				uint32_t to   = min(s->addr + (uint32_t)s->len, hi);
+				memcpy(stage + (from - lo), s->buf + (from - s->addr), to - from);
+			}
+
+			if (rv == 0)
+				rv = _pageBlock(lo, stage, hi - lo, I2C_EEPROM_SRC_RAM);
+		}
+
+		for (uint8_t g=k; g<j; g++)
+			if (seg[idx[g]].status == 0) seg[idx[g]].status = rv;
+
+		// Next: rest of the last segment or the next one
+		k = j - 1;
+		if (seg[idx[k]].addr + (uint32_t)seg[idx[k]].len > pageEnd)
+			lo = pageEnd;
+		else if (++k < n)
+			lo = seg[idx[k]].addr;
+	}
+
+done:
+	for (uint8_t i=0; i<count; i++)
+		if (seg[i].status != 0) return seg[i].status;
+	return 0;
+}
+#endif
+
+int I2C_eeprom::_readv(I2C_eepromSeg* seg, const uint8_t count) {
+uint8_t		idx[I2C_EEPROM_SEGMAX];
+uint8_t		n = _sortSegs(seg, count, idx);
+uint8_t		k = 0, j;
+uint32_t	lo, hi;
+
+	while (k < n) {
+		// One run: segments k..j-1, gaps up to I2C_EEPROM_READGAP
+		lo = seg[idx[k]].addr;
+		hi = lo + seg[idx[k]].len;
+		for (j=k+1; j<n && seg[idx[j]].addr <= hi + I2C_EEPROM_READGAP; j++)
+			hi = max(hi, seg[idx[j]].addr + (uint32_t)seg[idx[j]].len);
+
+		for (uint32_t addr=lo; addr<hi; ) {
+			uint16_t cnt = min(hi - addr, (uint32_t)_chunk());
+
+			waitEEReady();
+			if (_fetchRun(addr, cnt, seg, idx + k, j - k) != cnt)
+				for (uint8_t g=k; g<j; g++)
+					if (seg[idx[g]].addr < addr + cnt && addr < seg[idx[g]].addr + (uint32_t)seg[idx[g]].len)
+						seg[idx[g]].status = I2C_EEPROM_ERR_READ;
+			addr += cnt;
+		}
+		k = j;
+	}
+
+	for (uint8_t i=0; i<count; i++)
+		if (seg[i].status != 0) return seg[i].status;
+	return 0;
+}
 
-    Wire.requestFrom(_deviceAddress, length);
-    cnt = 0;
-    before = millis();
-    while ((cnt < length) && ((millis() - before) < I2C_EEPROM_TIMEOUT)) {
-        if (Wire.available())
-		buffer[cnt++] = WIRE_READ();
+
+//
+// One read transaction @ <memoryAddress>; each byte goes to the segments
+// of <idx> (sorted) it belongs to, bytes in gaps are dropped
+// returns bytes read
+//
+uint16_t I2C_eeprom::_fetchRun(const uint16_t memoryAddress, const uint16_t length, I2C_eepromSeg* seg, const uint8_t* idx, const uint8_t n) {
+int		rv;
+uint16_t 	cnt = 0;
+uint8_t		first = 0;
+uint32_t	before;
+uint32_t	start;
+
+    _lockReady();
+
+    start = TRACE_NOW();
+    this->_beginTransmission(memoryAddress);
+    if (_bus->endTransmission(false) == 0) {
+	if (this->_cipher != NULL) _cipher->seek(memoryAddress);
+	rv = _bus->requestFrom(_devAddr(memoryAddress), length);
+	before = millis();
+	while ((cnt < rv) && ((millis() - before) < I2C_EEPROM_TIMEOUT)) {
+	    if (!_bus->available()) continue;
+
+	    uint8_t  b = _bus->read();
+	    if (this->_cipher != NULL) b ^= _cipher->next();
+	    uint32_t a = memoryAddress + cnt++;
+
+	    while (first < n && seg[idx[first]].addr + (uint32_t)seg[idx[first]].len <= a) first++;
+	    for (uint8_t g=first; g<n && seg[idx[g]].addr <= a; g++)
+		if (a < seg[idx[g]].addr + (uint32_t)seg[idx[g]].len)
+		    seg[idx[g]].buf[a - seg[idx[g]].addr] = b;
+	}
     }
+    TRACE(I2C_EEPROM_TRACE_READ, memoryAddress, length, start, (cnt == length) ? 0 : I2C_EEPROM_ERR_READ);
+
+    _bus->unlock();
     return cnt;
 }
 
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+//
+// Does the PROM hold <length> bytes of <source> @ <memoryAddress> already?
+// Compares while reading ... no buffer. A failing read counts as different.
+//
+bool I2C_eeprom::_sameBlock(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length, const uint8_t source) {
+uint16_t	rv;
+uint16_t 	cnt = 0;
+bool		same = true;
+uint32_t	before;
+uint32_t	start;
+
+    waitEEReady();
+
+    _lockReady();
+
+    start = TRACE_NOW();
+    this->_beginTransmission(memoryAddress);
+    if (_bus->endTransmission(false) == 0) {
+	if (this->_cipher != NULL) _cipher->seek(memoryAddress);
+	rv = _bus->requestFrom(_devAddr(memoryAddress), length);
+	before = millis();
+	while ((cnt < rv) && ((millis() - before) < I2C_EEPROM_TIMEOUT)) {
+	    if (_bus->available()) {
+		uint8_t b = _bus->read();
+
+		if (this->_cipher != NULL) b ^= _cipher->next();
+		if (b != _srcByte(buffer, cnt, source)) same = false;
+		cnt++;
+	    }
+	}
+    }
+    TRACE(I2C_EEPROM_TRACE_COMPARE, memoryAddress, length, start,
+	  (cnt != length) ? I2C_EEPROM_ERR_READ : (same ? 0 : I2C_EEPROM_ERR_VERIFY));
+
+    _bus->unlock();
+    return same && cnt == length;
+}
+
 void I2C_eeprom::waitEEReady() {
+uint32_t	start = TRACE_NOW();
+uint16_t	polls = 0;
 
     // Wait until EEPROM gives ACK again.
     // this is a bit faster than the hardcoded 5 milliSeconds
-    while ((micros() - _lastWrite) <= I2C_WRITEDELAY) {
-        Wire.beginTransmission(_deviceAddress);
-        if ( Wire.endTransmission() == 0 ) break;
+    while (!_isReady()) {
+	polls++;
+#ifdef I2C_EEPROM_THREADSAFE
+	I2C_eepromYield();
+#endif
+    }
+
+    if (polls > 0) TRACE(I2C_EEPROM_TRACE_WAIT, 0, polls, start, 0);
+}
+
+
+//
+// One look at the PROM ... true when the write cycle is over (ACK) or must be
+//
+bool I2C_eeprom::_isReady() {
+bool	ready;
+
+    _bus->lock();
+    ready = _ready();
+    _bus->unlock();
+    return ready;
+}
+
+// Bus held by the caller
+bool I2C_eeprom::_ready() {
+
+    if (!_writing) return true;
+
+    if ((micros() - _lastWrite) <= I2C_WRITEDELAY) {
+	_bus->beginTransmission(_deviceAddress);
+	if (_bus->endTransmission() != 0) return false;
     }
+    _writing = false;
+    return true;
 }
+
+//
+// Take the bus with this PROM out of its write cycle ... while it is in
+// one, other tasks get the bus and the CPU between ACK probes
+//
+void I2C_eeprom::_lockReady() {
+
+    _bus->lock();
+    while (!_ready()) {
+#ifdef I2C_EEPROM_THREADSAFE
+	_bus->unlock();
+	I2C_eepromYield();
+	_bus->lock();
+#endif
+    }
+}
+
+bool I2C_eeprom::_cycling() {
+
+    if (_writing && (micros() - _lastWrite) > I2C_WRITEDELAY) _writing = false;
+    return _writing;
+}
+#else
+//
+// Read-only profile ... nothing writes, nothing to wait for
+//
+void I2C_eeprom::waitEEReady()	{ }
+bool I2C_eeprom::_isReady()	{ return true; }
+bool I2C_eeprom::_ready()	{ return true; }
+bool I2C_eeprom::_cycling()	{ return false; }
+void I2C_eeprom::_lockReady()	{ _bus->lock(); }
+#endif
@@ -11,27 +11,120 @@
 // Released to the public domain
 //
 
-#include <Wire.h>
-
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
-#else
+#elif defined(ARDUINO)
 #include "WProgram.h"
 #include "Wstring.h"
 #include "Wiring.h"
 #endif
 
-#define I2C_EEPROM_VERSION "2.0.0b"
+//
+// With I2C_EEPROM_LEAN defined (here or in the build flags) an instance keeps
+// no status() buffer and no geometry beyond the page size; get_pages() et al.
+// work it out on each call. status() without a buffer is gone, status(Serial)
+// prints straight away. An instance then stays within I2C_EEPROM_LEAN_BUDGET
+// bytes: 22 on AVR, 28 on 32 bit parts, 40 on a 64 bit host (checked at
+// compile time) ... against some 150 without.
+//
+//#define I2C_EEPROM_LEAN
+
+//
+// Build profile ... set I2C_EEPROM_PROFILE here or in the build flags
+//	I2C_EEPROM_READONLY	reads, readv(), crc32(), status(Print&); the write
+//				calls return I2C_EEPROM_ERR_READONLY; no write,
+//				poll or fill code
+//	I2C_EEPROM_READWRITE	all but status() and status(buffer, size) (snprintf)
+//	I2C_EEPROM_FULL		everything (default)
+//
+#define I2C_EEPROM_READONLY	1
+#define I2C_EEPROM_READWRITE	2
+#define I2C_EEPROM_FULL		3
+
+//#define I2C_EEPROM_PROFILE	I2C_EEPROM_READONLY
+
+#ifndef I2C_EEPROM_PROFILE
+#define I2C_EEPROM_PROFILE	I2C_EEPROM_FULL
+#endif
+
+#include <I2C_eepromBus.h>
+
+class I2C_eepromCipher;		// I2C_eepromCipher.h
+
+#define I2C_EEPROM_VERSION "2.1.0b"
 
 // TWI buffer needs max 2 bytes for eeprom address
 // 1 byte for eeprom register address is available in txbuffer
 #define I2C_TWIBUFFERSIZE	30
 
+// Where the bytes of a write come from (_pageBlock, _sendBlock)
+#define I2C_EEPROM_SRC_RAM	0
+#define I2C_EEPROM_SRC_FILL	1	// one byte, repeated
+#define I2C_EEPROM_SRC_PGM	2	// PROGMEM, read with pgm_read_byte()
+
+// Type flag for FRAM parts: I2C_eeprom fram(0x50, I2C_EEPROM_FRAM|256);
+// 64, 128, 256 and 512 [Kbit] are known
+#define I2C_EEPROM_FRAM		0x4000
+
+// probe() ... a PROM answers, but the bytes it reads are all alike
+// (blank?): no telling its size without writing
+#define I2C_EEPROM_BLANK	0x8000
+#define I2C_EEPROM_PROBE_BYTES	8	// bytes per window of the two address word size test
+#define I2C_EEPROM_PROBE_WINDOWS	4	// windows compared (unaligned, first 4 KB)
+#define I2C_EEPROM_PROBE_SPAN	2048	// one address word: rolls over within (24xx16)
+#define I2C_EEPROM_PROBE_FIRST	0x50	// scan()
+#define I2C_EEPROM_PROBE_LAST	0x57
+
 // to break blocking read/write after n millis()
 #define I2C_EEPROM_TIMEOUT	1000
 
+// Return codes beyond those of Wire.endTransmission() (1..4)
+#define I2C_EEPROM_ERR_RANGE	10	// address range exceeds the PROM (or overlaps)
+#define I2C_EEPROM_ERR_READ	11	// short read; bus or stream timeout
+#define I2C_EEPROM_ERR_VERIFY	12	// read back does not match what was written
+#define I2C_EEPROM_ERR_BUSY	13	// a transfer is still running
+#define I2C_EEPROM_ERR_ECC	14	// more bit errors than the ECC can correct
+#define I2C_EEPROM_ERR_READONLY	15	// write call in an I2C_EEPROM_READONLY build
+#define I2C_EEPROM_ERR_CRC	16	// stored structure (table) fails its check
+
+// Flow control for writeStream()
+#define I2C_EEPROM_FLOW_NONE	0	// sender paces itself
+#define I2C_EEPROM_FLOW_ACK	1	// one I2C_EEPROM_ACK per chunk received; sender waits for it
+#define I2C_EEPROM_ACK		0x06
+
+
+//
+// Outcome of a copyTo()/syncMirror() run ... pass NULL if not needed
+//
+typedef struct {
+	uint32_t	bytes;		// bytes handled
+	uint16_t	written;	// write transactions issued on the destination
+	uint16_t	skipped;	// write transactions saved (destination matched)
+	uint32_t	micros;		// elapsed time
+	uint32_t	rate;		// throughput in bytes/s
+} I2C_eepromCopyStat;
+
+//
+// One segment of a writev()/readv()
+//
+typedef struct {
+	uint16_t	addr;
+	uint8_t*	buf;
+	uint16_t	len;
+	int		status;		// 0 = OK otherwise error; set by writev()/readv()
+} I2C_eepromSeg;
+
+#define I2C_EEPROM_SEGMAX	16	// segments sorted at a time (stack)
+#define I2C_EEPROM_READGAP	4	// bytes read through rather than starting a new read
+#define I2C_EEPROM_PAGEMAX	128	// largest page size in the table
+
+#define I2C_EEPROM_LEAN_BUDGET	(3 * sizeof(void*) + 16)	// bytes per instance
+
 
 class I2C_eeprom {
+    friend class I2C_eepromAsync;
+    friend class I2C_eepromBD;
+
 //-------------------------------------
 //	Public space
 //-------------------------------------
@@ -48,7 +141,14 @@ public:
      * @param deviceAddress Byte address of the device.
      * @param deviceSize    Max size in bytes of the device (divide your device size in Kbits by 8)
      */
-    I2C_eeprom(const uint8_t deviceAddress, const unsigned int deviceSize);
+#ifdef ARDUINO
+    I2C_eeprom(const uint8_t deviceAddress, const unsigned int deviceSize);	// on Wire
+#endif
+
+    //
+    // Constructor	... the same on another bus: Wire1, SoftWire, i2c-dev, simulator
+    //
+    I2C_eeprom(I2C_eepromBus& bus, const uint8_t deviceAddress, const unsigned int deviceSize);
 
 
     //
@@ -62,10 +162,23 @@ public:
     int		get_addrBits(void);
     int		get_addrWords(void);
     int		get_speed(void);
+    I2C_eepromBus* get_bus(void);
+    bool	isFRAM(void);
 
     void	begin(int);			// Must supply a speed in Khz ... defaults to save 100[Khz]
 
+#if I2C_EEPROM_PROFILE == I2C_EEPROM_FULL
+#ifndef I2C_EEPROM_LEAN
     char*	status(void);
+#endif
+    char*	status(char* buffer, const size_t size);
+#endif
+    void	status(Print& out);
+
+    // Geometry by reading ... see probe() in I2C_eepromV2.cpp
+    static unsigned int probe(I2C_eepromBus& bus, const uint8_t deviceAddress);
+    static uint8_t scan(I2C_eepromBus& bus, uint8_t* address, unsigned int* type, const uint8_t max);
+    int		detect(void);			// after begin()
 
     int 	setBlock(	const uint16_t	memoryAddress,
 				const uint8_t	value,
@@ -78,32 +191,83 @@ public:
 				const uint8_t*	buffer,
 				const uint16_t	length);
 
+    int		updateBlock(	const uint16_t	memoryAddress,
+				const uint8_t*	buffer,
+				const uint16_t	length);
+
+    // <data> points to PROGMEM ... no RAM copy needed
+    int		writeBlock_P(	const uint16_t	memoryAddress,
+				const uint8_t*	data,
+				const uint16_t	length);
+
+    int		updateBlock_P(	const uint16_t	memoryAddress,
+				const uint8_t*	data,
+				const uint16_t	length);
+
     uint8_t	readByte(	const uint16_t	memoryAddress);
 
     uint16_t	readBlock(	const uint16_t	memoryAddress,
 				      uint8_t*	buffer,
 				const uint16_t	length);
 
+    int		copyTo(		I2C_eeprom&	dst,
+				const uint16_t	srcAddr,
+				const uint16_t	dstAddr,
+				const uint32_t	length,
+				I2C_eepromCopyStat* stat = NULL);
+
+    void	setMirror(I2C_eeprom* backup);	// NULL ends mirroring
+    I2C_eeprom*	get_mirror(void);
+    int		syncMirror(I2C_eepromCopyStat* stat = NULL);
+
+    void	setCipher(I2C_eepromCipher* cipher);	// NULL: plain
+    I2C_eepromCipher* get_cipher(void);
+
+    int		writeStream(	Stream&		in,
+				const uint16_t	memoryAddress,
+				const uint32_t	length,
+				const uint8_t	flow = I2C_EEPROM_FLOW_NONE,
+				uint32_t*	crc = NULL);
+
+    uint32_t	crc32(		const uint16_t	memoryAddress,
+				const uint32_t	length);
+
+    static uint32_t crc32Update(uint32_t crc, const uint8_t* buffer, const uint16_t length);
+
+    int		writev(I2C_eepromSeg* seg, const uint8_t count);
+    int		readv(I2C_eepromSeg* seg, const uint8_t count);
+
 
 //-------------------------------------
 //	Private
 //-------------------------------------
 private:
-    uint8_t	_deviceAddress;
+    // largest first ... no padding
+    I2C_eepromBus* _bus;
+    I2C_eeprom*	_mirror;	// backup PROM getting every write as well
+    I2C_eepromCipher* _cipher;	// keystream XORed in on the bus
+    uint32_t 	_lastWrite;     // for waitEEReady
     uint16_t	_deviceSize;
-    uint16_t	_Kbytes;
-    uint16_t	_pages;	
-    uint8_t	_pageSize;
-    uint16_t	_addrBits;
-    uint16_t	_addrWords;
     uint16_t	_speed=0;	// Sanity condition '0' for begin() not called
-    uint32_t 	_lastWrite;     // for waitEEReady
-    char	_statbuf[128];
+    uint8_t	_deviceAddress;
+    uint8_t	_pageSize;
+    bool	_writing;	// write cycle may be running
+    bool	_fram;		// no write cycle, no pages
 
     // for some smaller chips that use one-word addresses
     //bool _isAddressSizeTwoWords;
     bool	_TwoWordAddr;	// What about C1024 ??
 
+#ifndef I2C_EEPROM_LEAN
+    uint16_t	_Kbytes;
+    uint16_t	_pages;	
+    uint16_t	_addrBits;
+    uint16_t	_addrWords;
+#if I2C_EEPROM_PROFILE == I2C_EEPROM_FULL
+    char	_statbuf[128];
+#endif
+#endif
+
 
     //
     // Prototypes
@@ -114,19 +278,68 @@ private:
      * @param memoryAddress Address to write/read
      */
     void	_beginTransmission(const uint16_t memoryAddress);
+    uint8_t	_devAddr(const uint16_t memoryAddress);
+
+    static bool	_probeRead(	I2C_eepromBus&	bus,
+				const uint8_t	deviceAddress,
+				const uint16_t	memoryAddress,
+				const uint8_t	words,
+				      uint8_t*	buffer,
+				const uint8_t	length);
+
+    void	_setup(const uint8_t deviceAddress, const unsigned int DEVtype);
+
+    uint16_t	_geoPages(void);
+    uint8_t	_geoAddrBits(void);
+    uint8_t	_geoAddrWords(void);
 
     int		_pageBlock(	const uint16_t	memoryAddress,
 				const uint8_t*	buffer,
 				const uint16_t	length,
-				const bool	incrBuffer);
+				const uint8_t	source,
+				const bool	update = false);
 
     int		_WriteBlock(	const uint16_t	memoryAddress,
 				const uint8_t*	buffer,
-				const uint8_t	length);
+				const uint16_t	length,
+				const uint8_t	source = I2C_EEPROM_SRC_RAM);
 
-    uint8_t	_ReadBlock(	const uint16_t	memoryAddress,
+    uint16_t	_ReadBlock(	const uint16_t	memoryAddress,
 				      uint8_t*	buffer,
-				const uint8_t	length);
+				const uint16_t	length);
+
+    int		_sendBlock(	const uint16_t	memoryAddress,
+				const uint8_t*	buffer,
+				const uint16_t	length,
+				const uint8_t	source = I2C_EEPROM_SRC_RAM);
+
+    bool	_sameBlock(	const uint16_t	memoryAddress,
+				const uint8_t*	buffer,
+				const uint16_t	length,
+				const uint8_t	source);
+
+    uint16_t	_fetchBlock(	const uint16_t	memoryAddress,
+				      uint8_t*	buffer,
+				const uint16_t	length);
+
+    uint8_t	_sortSegs(I2C_eepromSeg* seg, const uint8_t count, uint8_t* idx);
+    int		_writev(I2C_eepromSeg* seg, const uint8_t count);
+    int		_readv(I2C_eepromSeg* seg, const uint8_t count);
+    uint16_t	_fetchRun(	const uint16_t	memoryAddress,
+				const uint16_t	length,
+				I2C_eepromSeg*	seg,
+				const uint8_t*	idx,
+				const uint8_t	n);
+
+    bool	_isReady(void);
+    bool	_ready(void);		// bus held
+    void	_lockReady(void);	// bus taken, PROM out of its write cycle
+    bool	_cycling(void);		// write cycle may still run: ACK probe due
+
+    uint32_t	_bytes(void);		// capacity in bytes
+    uint16_t	_chunk(void);		// data bytes per bus transaction
+    uint16_t	_writeChunk(const uint16_t memoryAddress);
+    uint16_t	_chainChunk(const uint16_t memoryAddress);	// smallest over the mirror chain
 
     void	waitEEReady();
 };
@@ -0,0 +1,344 @@
+//
+//    FILE:	I2C_eepromWorker.cpp
+// PURPOSE:	One task serving PROM requests of many tasks
+//
+// --------------------------------------------------------------------------------------------
+// Released to the public domain
+// --------------------------------------------------------------------------------------------
+
+#include <I2C_eepromWorker.h>
+
+#ifdef I2C_EEPROM_THREADS
+
+//
+// Platform ... FreeRTOS or pthreads
+//
+#ifdef I2C_EEPROM_FREERTOS
+#define WORKER_LOCK()		xSemaphoreTake(_lock, portMAX_DELAY)
+#define WORKER_UNLOCK()		xSemaphoreGive(_lock)
+#else
+#define WORKER_LOCK()		pthread_mutex_lock(&_lock)
+#define WORKER_UNLOCK()		pthread_mutex_unlock(&_lock)
+#endif
+
+
+//
+// Constructor ...
+//
+I2C_eepromWorker::I2C_eepromWorker(I2C_eeprom& ee) {
+	this->_ee	= &ee;
+	this->_head	= NULL;
+	this->_tail	= NULL;
+	this->_running	= false;
+	this->_stop	= false;
+	this->_requests	= 0;
+	this->_batches	= 0;
+	this->_merged	= 0;
+
+#ifdef I2C_EEPROM_FREERTOS
+	this->_lock	= xSemaphoreCreateMutex();
+	this->_work	= xSemaphoreCreateCounting(0xFFFF, 0);
+	this->_ended	= xSemaphoreCreateBinary();
+#else
+	pthread_mutex_init(&_lock, NULL);
+	pthread_cond_init(&_work, NULL);
+	pthread_cond_init(&_done, NULL);
+#endif
+}
+
+I2C_eepromWorker::~I2C_eepromWorker() {
+	end();
+#ifdef I2C_EEPROM_FREERTOS
+	vSemaphoreDelete(_lock);
+	vSemaphoreDelete(_work);
+	vSemaphoreDelete(_ended);
+#else
+	pthread_mutex_destroy(&_lock);
+	pthread_cond_destroy(&_work);
+	pthread_cond_destroy(&_done);
+#endif
+}
+
+
+//
+// Start the worker task
+//
+bool I2C_eepromWorker::begin(const uint8_t priority) {
+bool rv;
+
+	WORKER_LOCK();
+	if (!_running) {
+		_stop = false;
+#ifdef I2C_EEPROM_FREERTOS
+		_running = xTaskCreate(_main, "I2C_eeprom", I2C_EEPROM_WORKER_STACK, this, priority, NULL) == pdPASS;
+#else
+		(void)priority;			// pthreads: the scheduler's default
+		_running = pthread_create(&_thread, NULL, _main, this) == 0;
+#endif
+	}
+	rv = _running;
+	WORKER_UNLOCK();
+	return rv;
+}
+
+
+//
+// Stop the worker task when the requests submitted so far are done
+//
+void I2C_eepromWorker::end() {
+	WORKER_LOCK();
+	if (!_running) {
+		WORKER_UNLOCK();
+		return;
+	}
+	_running = false;		// no more submissions
+	_stop	 = true;
+	WORKER_UNLOCK();
+
+#ifdef I2C_EEPROM_FREERTOS
+	xSemaphoreGive(_work);
+	xSemaphoreTake(_ended, portMAX_DELAY);
+#else
+	pthread_cond_signal(&_work);
+	pthread_join(_thread, NULL);
+#endif
+}
+
+
+//
+// Queue a request; <req> and <buffer> must stay valid until wait() returned
+// returns 0 = queued otherwise error
+//
+int I2C_eepromWorker::submit(I2C_eepromReq* req, const uint8_t op, const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length) {
+	req->op		= op;
+	req->addr	= memoryAddress;
+	req->buf	= buffer;
+	req->len	= length;
+	req->next	= NULL;
+	req->rv		= 0;
+	req->done	= false;
+#ifdef I2C_EEPROM_FREERTOS
+	req->sem	= xSemaphoreCreateBinaryStatic(&req->semBuf);
+#endif
+
+	if (memoryAddress + (uint32_t)length > (uint32_t)_ee->get_pages() * _ee->get_pageSize()) {
+		_finish(req, I2C_EEPROM_ERR_RANGE);
+		return I2C_EEPROM_ERR_RANGE;
+	}
+
+	WORKER_LOCK();
+	if (!_running) {
+		WORKER_UNLOCK();		// _finish() takes the lock itself
+		_finish(req, I2C_EEPROM_ERR_BUSY);
+		return I2C_EEPROM_ERR_BUSY;
+	}
+	if (_tail == NULL)
+		_head = req;
+	else
+		_tail->next = req;
+	_tail = req;
+	_requests++;
+	WORKER_UNLOCK();
+
+#ifdef I2C_EEPROM_FREERTOS
+	xSemaphoreGive(_work);
+#else
+	pthread_cond_signal(&_work);
+#endif
+	return 0;
+}
+
+
+//
+// Block the calling task until <req> is done; again returns at once
+//
+int I2C_eepromWorker::wait(I2C_eepromReq* req) {
+#ifdef I2C_EEPROM_FREERTOS
+	xSemaphoreTake(req->sem, portMAX_DELAY);
+	xSemaphoreGive(req->sem);
+#else
+	pthread_mutex_lock(&_lock);
+	while (!req->done)
+		pthread_cond_wait(&_done, &_lock);
+	pthread_mutex_unlock(&_lock);
+#endif
+	return req->rv;
+}
+
+
+int I2C_eepromWorker::write(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length) {
+I2C_eepromReq req;
+
+	if (submit(&req, I2C_EEPROM_REQ_WRITE, memoryAddress, (uint8_t*)buffer, length) != 0) return req.rv;
+	return wait(&req);
+}
+
+int I2C_eepromWorker::read(const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length) {
+I2C_eepromReq req;
+
+	if (submit(&req, I2C_EEPROM_REQ_READ, memoryAddress, buffer, length) != 0) return req.rv;
+	return wait(&req);
+}
+
+
+//
+// Utility functions
+//
+uint32_t	I2C_eepromWorker::get_requests()	{ return _requests;	}
+uint32_t	I2C_eepromWorker::get_batches()		{ return _batches;	}
+uint32_t	I2C_eepromWorker::get_merged()		{ return _merged;	}
+
+
+
+////////////////////////////////////////////////////////////////////
+//
+//	PRIVATE
+//
+////////////////////////////////////////////////////////////////////
+
+#ifdef I2C_EEPROM_FREERTOS
+void I2C_eepromWorker::_main(void* self) {
+I2C_eepromWorker* w = (I2C_eepromWorker*)self;
+
+	w->_serve();
+	xSemaphoreGive(w->_ended);
+	vTaskDelete(NULL);
+}
+#else
+void* I2C_eepromWorker::_main(void* self) {
+	((I2C_eepromWorker*)self)->_serve();
+	return NULL;
+}
+#endif
+
+
+void I2C_eepromWorker::_serve() {
+I2C_eepromReq* list;
+
+	while ((list = _take()) != NULL)
+		_batch(list);
+}
+
+
+//
+// All pending requests at once ... waits for some
+//
+I2C_eepromReq* I2C_eepromWorker::_take() {
+I2C_eepromReq* list;
+
+#ifdef I2C_EEPROM_FREERTOS
+	for (;;) {
+		xSemaphoreTake(_work, portMAX_DELAY);
+		WORKER_LOCK();
+		if (_head != NULL || _stop) break;
+		WORKER_UNLOCK();		// submission already taken with a former batch
+	}
+#else
+	WORKER_LOCK();
+	while (_head == NULL && !_stop)
+		pthread_cond_wait(&_work, &_lock);
+#endif
+
+	list  = _head;
+	_head = _tail = NULL;
+	if (list != NULL) _batches++;
+	WORKER_UNLOCK();
+	return list;
+}
+
+
+//
+// Serve a batch in order: each run of writes (or reads) goes out as one
+// writev() (readv()) ... parts in one page become one page write
+//
+void I2C_eepromWorker::_batch(I2C_eepromReq* list) {
+I2C_eepromSeg	seg[I2C_EEPROM_SEGMAX];
+I2C_eepromReq*	req = list;
+I2C_eepromReq*	r;
+I2C_eepromReq*	next;
+uint8_t		op, n;
+
+	while (req != NULL) {
+		op = req->op;
+		n  = 0;
+		for (r = req; r != NULL && r->op == op && n < I2C_EEPROM_SEGMAX; r = r->next) {
+			seg[n].addr = r->addr;
+			seg[n].buf  = r->buf;
+			seg[n].len  = r->len;
+			n++;
+		}
+
+		if (op == I2C_EEPROM_REQ_WRITE) {
+			_ee->writev(seg, n);
+			_merged += _saved(seg, n);
+		} else {
+			_ee->readv(seg, n);
+		}
+
+		// <next> first, _finish() may free a request
+		for (uint8_t i=0; i<n; i++) {
+			next = req->next;
+			_finish(req, seg[i].status);
+			req = next;
+		}
+	}
+}
+
+
+//
+// Page writes the writev() of <seg> saved over a writeBlock() per segment:
+// segments sharing a page ... none when they overlap, writev() then
+// writes them one by one
+//
+uint16_t I2C_eepromWorker::_saved(I2C_eepromSeg* seg, const uint8_t n) {
+uint32_t	lo[I2C_EEPROM_SEGMAX];
+uint32_t	hi[I2C_EEPROM_SEGMAX];
+uint16_t	ps = _ee->get_pageSize();
+uint32_t	own = 0, pages = 0, next = 0;
+uint8_t		m = 0;
+
+	if (ps == 0) return 0;
+
+	// Sorted by address, empty segments left out
+	for (uint8_t i=0; i<n; i++) {
+		if (seg[i].len == 0) continue;
+		uint8_t j = m++;
+		while (j > 0 && lo[j-1] > seg[i].addr) {
+			lo[j] = lo[j-1];
+			hi[j] = hi[j-1];
+			j--;
+		}
+		lo[j] = seg[i].addr;
+		hi[j] = seg[i].addr + (uint32_t)seg[i].len;
+		own  += (hi[j] - 1) / ps - lo[j] / ps + 1;
+	}
+
+	for (uint8_t i=0; i<m; i++) {
+		if (i > 0 && lo[i] < hi[i-1]) return 0;
+		uint32_t first = max(lo[i] / ps, next);
+		uint32_t last  = (hi[i] - 1) / ps;
+		if (last >= first) pages += last - first + 1;
+		next = last + 1;
+	}
+	return own - pages;
+}
+
+
+//
+// Hand the result back ... <req> may be gone right after
+//
+void I2C_eepromWorker::_finish(I2C_eepromReq* req, const int rv) {
+#ifdef I2C_EEPROM_FREERTOS
+	req->rv   = rv;
+	req->done = true;
+	xSemaphoreGive(req->sem);	// last: wait() returns after it
+#else
+	pthread_mutex_lock(&_lock);
+	req->rv   = rv;
+	req->done = true;
+	pthread_cond_broadcast(&_done);
+	pthread_mutex_unlock(&_lock);
+#endif
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef I2C_EEPROM_WORKER_H
+#define I2C_EEPROM_WORKER_H
+//
+//    FILE: I2C_eepromWorker.h
+// PURPOSE: One task serving PROM requests of many tasks (FreeRTOS, Linux)
+// VERSION: see I2C_EEPROM_VERSION
+//
+// Tasks hand requests to the worker and wait for them, or carry on and wait
+// later. The worker takes all requests pending at a time as one batch:
+// writes next to each other in the PROM go out together page by page, so a
+// page filled by several tasks costs one write cycle (or one per bus chunk).
+// Requests are served in order of submission, except that a run of writes
+// without overlaps is sorted by address. On FreeRTOS a request signals its
+// waiter through a semaphore of its own; task notifications are left to the
+// sketch. A request is free for reuse once wait() returned.
+//
+//	I2C_eepromWorker	worker(ee);
+//	worker.begin();
+//
+//	rv = worker.write(addr, buf, len);		// any task
+//
+//	I2C_eepromReq		req;			// or without waiting
+//	worker.submit(&req, I2C_EEPROM_REQ_WRITE, addr, buf, len);
+//	...
+//	rv = worker.wait(&req);
+//
+// Released to the public domain
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromThread.h>
+
+#ifdef I2C_EEPROM_THREADS
+
+#define I2C_EEPROM_REQ_WRITE	1
+#define I2C_EEPROM_REQ_READ	2
+
+#define I2C_EEPROM_WORKER_STACK	4096	// FreeRTOS task stack [bytes]
+#define I2C_EEPROM_WORKER_PRIO	5
+
+
+typedef struct I2C_eepromReq {
+	uint8_t		op;
+	uint16_t	addr;
+	uint8_t*	buf;
+	uint16_t	len;
+	volatile bool	done;
+	int		rv;		// 0 = OK otherwise error; valid when done
+	struct I2C_eepromReq* next;
+#ifdef I2C_EEPROM_FREERTOS
+	StaticSemaphore_t semBuf;	// given when done: the task's notifications stay its own
+	SemaphoreHandle_t sem;
+#endif
+} I2C_eepromReq;
+
+
+class I2C_eepromWorker {
+//-------------------------------------
+//	Public space
+//-------------------------------------
+public:
+    I2C_eepromWorker(I2C_eeprom& ee);
+    ~I2C_eepromWorker();
+
+    bool	begin(const uint8_t priority = I2C_EEPROM_WORKER_PRIO);
+    void	end(void);			// finishes pending requests first
+
+    int		submit(		I2C_eepromReq*	req,
+				const uint8_t	op,
+				const uint16_t	memoryAddress,
+				      uint8_t*	buffer,
+				const uint16_t	length);
+    int		wait(I2C_eepromReq* req);	// returns req->rv
+
+    int		write(const uint16_t memoryAddress, const uint8_t* buffer, const uint16_t length);
+    int		read(const uint16_t memoryAddress, uint8_t* buffer, const uint16_t length);
+
+    uint32_t	get_requests(void);
+    uint32_t	get_batches(void);
+    uint32_t	get_merged(void);		// page writes saved by writing requests together
+
+
+//-------------------------------------
+//	Private
+//-------------------------------------
+private:
+    I2C_eeprom*	_ee;
+    I2C_eepromReq* _head;		// pending, in order of submission
+    I2C_eepromReq* _tail;
+    bool	_running;
+    bool	_stop;
+    uint32_t	_requests;
+    uint32_t	_batches;
+    uint32_t	_merged;
+
+#ifdef I2C_EEPROM_FREERTOS
+    SemaphoreHandle_t _lock;		// guards the list, _running and _stop
+    SemaphoreHandle_t _work;		// counts submissions
+    SemaphoreHandle_t _ended;
+    static void	_main(void* self);
+#else
+    pthread_mutex_t _lock;
+    pthread_cond_t _work;
+    pthread_cond_t _done;
+    pthread_t	_thread;
+    static void* _main(void* self);
+#endif
+
+    void	_serve(void);
+    I2C_eepromReq* _take(void);		// blocks; NULL = stop
+    void	_batch(I2C_eepromReq* list);
+    uint16_t	_saved(I2C_eepromSeg* seg, const uint8_t n);
+    void	_finish(I2C_eepromReq* req, const int rv);
+};
+
+#endif
+#endif
@@ -0,0 +1,75 @@
+//
+//               FILE:  I2C_eeprom-bench.ino
+//            PURPOSE:  Throughput of writeBlock()/readBlock() with I2C_eepromV2, 24xx vs FRAM
+//           Platform:  ArduinoMega256
+//---------------------------------------------------------------------------------------------------------
+//
+// Put a 24xx and an FRAM on the bus (or one of both, set the other address to 0).
+// Each PROM is written and read in blocks of BLOCKsize; the sketch prints
+// bytes/s for both directions.
+//
+// !!! DESTRUCTIVE: the first BENCHbytes of each PROM are overwritten !!!
+//
+
+#include <Wire.h>
+#include <I2C_eepromV2.h>
+
+#define  EEPROMtype  256
+#define  EEPROMaddr  0x50
+#define  FRAMtype    (I2C_EEPROM_FRAM|256)
+#define  FRAMaddr    0x51
+
+#define  BENCHbytes  4096
+#define  BLOCKsize   256
+#define  SPEED       400
+
+I2C_eeprom eeprom(EEPROMaddr, EEPROMtype);
+I2C_eeprom fram  (FRAMaddr,   FRAMtype);
+
+uint8_t    block[BLOCKsize];
+
+
+void bench(const char* name, I2C_eeprom& ee) {
+uint32_t start;
+uint32_t wus, rus;
+uint16_t addr;
+bool     ok = true;
+
+        for (uint16_t i=0; i<BLOCKsize; i++) block[i] = i;
+
+        start = micros();
+        for (addr=0; addr<BENCHbytes; addr+=BLOCKsize)
+            ee.writeBlock(addr, block, BLOCKsize);
+        wus = micros() - start;
+
+        start = micros();
+        for (addr=0; addr<BENCHbytes; addr+=BLOCKsize) {
+            ee.readBlock(addr, block, BLOCKsize);
+            for (uint16_t i=0; i<BLOCKsize; i++)
+                if (block[i] != (uint8_t)i) ok = false;
+        }
+        rus = micros() - start;
+
+        Serial.print(ee.status());
+        Serial.print  (name);
+        Serial.print  (" write: ");
+        Serial.print  ((uint32_t)BENCHbytes * 1000000UL / wus);
+        Serial.print  (" B/s, read: ");
+        Serial.print  ((uint32_t)BENCHbytes * 1000000UL / rus);
+        Serial.print  (" B/s, verify: ");
+        Serial.println(ok ? "OK" : "FAILED");
+}
+
+
+void setup() {
+        Serial.begin(115200);
+
+        eeprom.begin(SPEED);
+        fram.begin(SPEED);
+
+        if (EEPROMaddr) bench("24xx", eeprom);
+        if (FRAMaddr)   bench("FRAM", fram);
+}
+
+void loop() {
+}
@@ -0,0 +1,71 @@
+//
+//               FILE:  I2C_eeprom-flash.ino
+//            PURPOSE:  Load an image over Serial into the PROM with I2C_eepromV2 writeStream()
+//           Platform:  ArduinoMega256
+//---------------------------------------------------------------------------------------------------------
+//
+// Protocol (host side):
+//      - send the image length as 8 hex digits followed by '\n'
+//      - send the image in chunks; after each chunk wait for one ACK (0x06)
+//      - the sketch answers "OK <crc32>" or "ERR <code>"
+//
+// Chunks follow the write chunks of the PROM. The sketch reports the page size
+// as "PAGE <n>"; the next chunk for image address <a> is
+//
+//      min(<n> - a % <n>, I2C_TWIBUFFERSIZE (30), bytes left)
+//
+// "PAGE 0" is an FRAM: no page boundary, chunks are min(30, bytes left)
+//
+
+#include <Wire.h>
+#include <I2C_eepromV2.h>
+
+#define  PROMtype    64
+#define  PROMaddr    0x50
+#define  IMAGEaddr   0
+
+I2C_eeprom ee(PROMaddr, PROMtype);
+
+
+uint32_t readLength() {
+char     hex[9];
+uint8_t  n = 0;
+
+        while (n < 8) {
+           int c = Serial.read();
+           if (c >= 0) hex[n++] = c;
+        }
+        hex[8] = 0;
+        while (Serial.read() != '\n') ;
+        return strtoul(hex, NULL, 16);
+}
+
+
+void setup() {
+uint32_t len;
+uint32_t crc;
+uint32_t start;
+int      rv;
+
+        Serial.begin(115200);
+        ee.begin(400);
+
+        Serial.print  ("PAGE ");
+        Serial.println(ee.isFRAM() ? 0 : ee.get_pageSize());
+
+        len   = readLength();
+        start = millis();
+        rv    = ee.writeStream(Serial, IMAGEaddr, len, I2C_EEPROM_FLOW_ACK, &crc);
+
+        if (rv == 0) {
+           Serial.print  ("OK ");
+           Serial.println(crc, HEX);
+        } else {
+           Serial.print  ("ERR ");
+           Serial.println(rv);
+        }
+        Serial.print  ("It took [ms]: ");
+        Serial.println(millis() - start);
+}
+
+void loop() {}
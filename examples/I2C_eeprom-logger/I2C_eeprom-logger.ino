@@ -0,0 +1,70 @@
+//
+//               FILE:  I2C_eeprom-logger.ino
+//            PURPOSE:  Sample in a timer ISR, log to the PROM through I2C_eepromQueue
+//           Platform:  ArduinoMega256
+//---------------------------------------------------------------------------------------------------------
+//
+// Timer1 fires at SAMPLErate; the ISR reads A0 and pushes a 4 byte record
+// (16 bit tick, 16 bit value). loop() drains the queue page by page and
+// prints the overruns once a second. The log region wraps.
+//
+
+#include <Wire.h>
+#include <I2C_eepromV2.h>
+#include <I2C_eepromQueue.h>
+
+#define  PROMtype    256
+#define  PROMaddr    0x50
+#define  LOGbase     0
+#define  LOGsize     32768UL
+#define  SAMPLErate  500            // Hz
+
+I2C_eeprom       ee(PROMaddr, PROMtype);
+
+uint8_t          ring[128];
+I2C_eepromQueue  queue(ring, sizeof(ring));
+
+volatile uint16_t tick;
+
+
+ISR(TIMER1_COMPA_vect) {
+uint16_t rec[2];
+
+        rec[0] = tick++;
+        rec[1] = analogRead(A0);
+        queue.push(rec, sizeof(rec));
+}
+
+
+void setup() {
+        Serial.begin(115200);
+        ee.begin(400);
+        queue.attach(ee, LOGbase, LOGsize);
+
+        TCCR1A = 0;
+        TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);        // CTC, F_CPU/64
+        OCR1A  = F_CPU / 64 / SAMPLErate - 1;
+        TIMSK1 = _BV(OCIE1A);
+}
+
+
+void loop() {
+static uint32_t last;
+int             rv;
+
+        rv = queue.drain();
+        if (rv != 0) {
+           Serial.print  ("drain error ");
+           Serial.println(rv);
+        }
+
+        if (millis() - last >= 1000) {
+           last = millis();
+           Serial.print  ("cursor ");
+           Serial.print  (queue.get_cursor());
+           Serial.print  (", peak ");
+           Serial.print  (queue.get_peak());
+           Serial.print  (", overruns ");
+           Serial.println(queue.get_overruns());
+        }
+}
@@ -0,0 +1,97 @@
+//
+//               FILE:  lfs_files.cpp
+//            PURPOSE:  LittleFS on I2C_eepromBD: file create/append/read, checked and timed
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz, 32 byte Wire buffer), littlefs 2.x
+//---------------------------------------------------------------------------------------------------------
+//
+//	make lfs LFS=<littlefs checkout>
+//
+// Times are model time of the simulator; each line gives the operations
+// per second and the payload rate.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromLFS.h>
+#include "test.h"
+
+#define FILES		16
+#define APPENDS		64		// records per file
+#define RECORD		24		// bytes per record
+
+static uint8_t	mem[65536];
+
+
+static void record(uint8_t* rec, const int file, const int n) {
+	for (int i=0; i<RECORD; i++) rec[i] = file * 31 + n * 7 + i;
+}
+
+static void report(const char* what, const uint32_t ops, const uint32_t bytes, const uint32_t us) {
+	printf("%-8s %5u ops in %8.1f ms: %7.1f ops/s, %5.2f KB/s\n", what, ops, us / 1000.0, ops * 1e6 / us, KBS((double)bytes, us));
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 512);
+	ee.begin(400);
+
+	I2C_eepromBD	bd(ee, 0, 0);
+	struct lfs_config cfg;
+	lfs_t		lfs;
+	lfs_file_t	file;
+	char		name[16];
+	uint8_t		rec[RECORD];
+	uint8_t		back[RECORD];
+	uint32_t	t;
+
+	I2C_eepromLFS_config(&cfg, bd);
+	CHECK(lfs_format(&lfs, &cfg) == 0);
+	CHECK(lfs_mount(&lfs, &cfg) == 0);
+
+	// Create: empty files
+	t = I2C_eepromSim::now();
+	for (int f=0; f<FILES; f++) {
+		snprintf(name, sizeof(name), "log%02d", f);
+		CHECK(lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL) == 0);
+		CHECK(lfs_file_close(&lfs, &file) == 0);
+	}
+	report("create", FILES, 0, I2C_eepromSim::now() - t);
+
+	// Append: one record per open/write/close, the files in turn (a logger)
+	sim.resetStats();
+	t = I2C_eepromSim::now();
+	for (int n=0; n<APPENDS; n++)
+		for (int f=0; f<FILES; f++) {
+			snprintf(name, sizeof(name), "log%02d", f);
+			record(rec, f, n);
+			CHECK(lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_APPEND) == 0);
+			CHECK(lfs_file_write(&lfs, &file, rec, RECORD) == RECORD);
+			CHECK(lfs_file_close(&lfs, &file) == 0);
+		}
+	report("append", FILES * APPENDS, FILES * APPENDS * RECORD, I2C_eepromSim::now() - t);
+	printf("         %u page writes, %u bytes written for %u bytes of records\n", bd.get_progs(), sim.get_bytesWritten(), FILES * APPENDS * RECORD);
+
+	// Read back after a remount, file by file
+	CHECK(lfs_unmount(&lfs) == 0);
+	CHECK(lfs_mount(&lfs, &cfg) == 0);
+	t = I2C_eepromSim::now();
+	for (int f=0; f<FILES; f++) {
+		snprintf(name, sizeof(name), "log%02d", f);
+		CHECK(lfs_file_open(&lfs, &file, name, LFS_O_RDONLY) == 0);
+		CHECK(lfs_file_size(&lfs, &file) == APPENDS * RECORD);
+		for (int n=0; n<APPENDS; n++) {
+			record(rec, f, n);
+			CHECK(lfs_file_read(&lfs, &file, back, RECORD) == RECORD);
+			CHECK(memcmp(rec, back, RECORD) == 0);
+		}
+		CHECK(lfs_file_close(&lfs, &file) == 0);
+	}
+	report("read", FILES, FILES * APPENDS * RECORD, I2C_eepromSim::now() - t);
+
+	CHECK(lfs_unmount(&lfs) == 0);
+	return TEST_DONE();
+}
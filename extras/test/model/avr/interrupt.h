@@ -0,0 +1,12 @@
+#ifndef I2C_EEPROM_MODEL_AVR_INTERRUPT_H
+#define I2C_EEPROM_MODEL_AVR_INTERRUPT_H
+//
+//    FILE: avr/interrupt.h
+// PURPOSE: Host model for test_twi ... see avr/io.h
+//
+// Released to the public domain
+//
+
+#include <avr/io.h>
+
+#endif
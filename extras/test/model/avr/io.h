@@ -0,0 +1,53 @@
+#ifndef I2C_EEPROM_MODEL_AVR_IO_H
+#define I2C_EEPROM_MODEL_AVR_IO_H
+//
+//    FILE: avr/io.h
+// PURPOSE: Host model of the ATmega TWI registers for test_twi
+//
+// Just what I2C_eepromTWI.cpp touches. TWCR is an object: a write hands the
+// step to the model (test_twi.cpp), a read gives TWINT while a step is done
+// and not yet taken in. The bits and ISR() are spelled as in avr-libc.
+//
+// Released to the public domain
+//
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU		16000000UL
+#endif
+
+#define _BV(bit)	(1 << (bit))
+
+// TWCR
+#define TWINT		7
+#define TWEA		6
+#define TWSTA		5
+#define TWSTO		4
+#define TWWC		3
+#define TWEN		2
+#define TWIE		0
+
+class I2C_eepromTWCR {
+public:
+    I2C_eepromTWCR&	operator=(const uint8_t v);	// in test_twi.cpp
+    operator		uint8_t() const;
+};
+
+extern I2C_eepromTWCR	TWCR;
+extern volatile uint8_t	TWDR, TWSR, TWBR, SREG;
+
+// Interrupts: the I bit of SREG
+#define cli()		(SREG &= (uint8_t)~0x80)
+#define sei()		(SREG |= 0x80)
+
+#define TWI_vect	__vector_24			// ATmega328P
+#define ISR(vector)	extern "C" void vector(void); void vector(void)
+
+// Of Arduino.h
+#define SDA		18
+#define SCL		19
+#define HIGH		1
+inline void digitalWrite(uint8_t, uint8_t)	{ }
+
+#endif
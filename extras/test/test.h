@@ -0,0 +1,22 @@
+#ifndef I2C_EEPROM_TEST_H
+#define I2C_EEPROM_TEST_H
+//
+//    FILE: test.h
+// PURPOSE: Checks for the host tests ... a failed one is printed and counted
+//
+// Released to the public domain
+//
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(cond)	do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); testFailures++; } } while (0)
+
+// exit code of main()
+#define TEST_DONE()	(printf("%s: %s\n", __FILE__, testFailures ? "FAILED" : "OK"), testFailures != 0)
+
+// bytes in <us> model microseconds as KB/s
+#define KBS(bytes, us)	((bytes) / 1.024 / ((us) / 1000.0))
+
+#endif
@@ -0,0 +1,121 @@
+//
+//               FILE:  test_async.cpp
+//            PURPOSE:  I2C_eepromAsync on a blocking and a background bus: time spent in poll(), mirror chains
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// loop() does 100 us of work between polls. On a blocking bus each poll()
+// waits for its transaction; in the background (setBackground(), as
+// I2C_eepromTWI) it only hands it over.
+//
+
+#include <I2C_eepromAsync.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromCipher.h>
+#include "test.h"
+
+#define WORK		100		// us of loop() between polls
+
+static uint8_t	m0[32768], m1[32768], m2[8192];
+static uint8_t	data[4096], back[4096];
+
+struct Run {
+	int	 rv;
+	uint32_t job;		// us, start to done
+	uint32_t inPoll;	// us
+};
+
+
+static Run run(I2C_eeprom& ee, const bool write) {
+	I2C_eepromAsync	job(ee);
+	Run		r;
+	uint32_t	t0 = I2C_eepromSim::now();
+
+	r.inPoll = 0;
+	if (write)
+		CHECK(job.startWrite(1000, data, sizeof(data)) == 0);
+	else
+		CHECK(job.startRead(1000, back, sizeof(back)) == 0);
+	CHECK(job.startRead(0, back, 1) == I2C_EEPROM_ERR_BUSY);
+
+	for (;;) {
+		uint32_t t = I2C_eepromSim::now();
+		bool busy = job.poll();
+		r.inPoll += I2C_eepromSim::now() - t;
+		if (!busy) break;
+		I2C_eepromSim::advance(WORK);
+	}
+	r.rv  = job.result();
+	r.job = I2C_eepromSim::now() - t0;
+	return r;
+}
+
+
+int main() {
+	I2C_eepromSim::useVirtualClock();
+	for (unsigned i=0; i<sizeof(data); i++) data[i] = i * 7 + 3;
+
+	Run	w[2], r[2];
+	for (int bg=0; bg<2; bg++) {
+		I2C_eepromSim	sim;
+		I2C_eeprom	ee(sim, 0x50, 256);
+		sim.attach(0x50, m0, sizeof(m0), 2, 64);
+		ee.begin(400);
+		sim.setBackground(bg);
+
+		memset(m0, 0xFF, sizeof(m0));
+		w[bg] = run(ee, true);
+		CHECK(w[bg].rv == 0);
+		CHECK(memcmp(m0 + 1000, data, sizeof(data)) == 0);
+
+		memset(back, 0, sizeof(back));
+		r[bg] = run(ee, false);
+		CHECK(r[bg].rv == 0);
+		CHECK(memcmp(back, data, sizeof(back)) == 0);
+
+		printf("%-10s write: job %6.1f ms, in poll() %6.1f ms; read: job %6.1f ms, in poll() %6.1f ms\n",
+			bg ? "background" : "blocking", w[bg].job / 1000.0, w[bg].inPoll / 1000.0, r[bg].job / 1000.0, r[bg].inPoll / 1000.0);
+	}
+
+	// Same job time, next to nothing of it in poll() in the background
+	CHECK(w[1].job * 10 < w[0].job * 11);
+	CHECK(w[1].inPoll * 50 < w[1].job);
+	CHECK(r[1].inPoll * 50 < r[1].job);
+	CHECK(r[0].inPoll * 2 > r[0].job);
+
+	// Mirror chain of three, the middle one enciphered, the last a 24xx64
+	// with 32 byte pages: chunks fit every PROM of the chain
+	{
+		I2C_eepromSim	sim;
+		I2C_eeprom	a(sim, 0x50, 256), b(sim, 0x51, 256), c(sim, 0x52, 64);
+		uint8_t		key[32] = { 1, 2, 3 }, nonce[12] = { 9 };
+		I2C_eepromChaCha20 cc(key, nonce);
+
+		sim.attach(0x50, m0, sizeof(m0), 2, 64);
+		sim.attach(0x51, m1, sizeof(m1), 2, 64);
+		sim.attach(0x52, m2, sizeof(m2), 2, 32);
+		sim.setBackground(true);
+		a.begin(400);
+		b.begin(400);
+		c.begin(400);
+		b.setCipher(&cc);
+		a.setMirror(&b);
+		b.setMirror(&c);
+
+		I2C_eepromAsync	job(a);
+		CHECK(job.startWrite(100, data, 3000) == 0);
+		CHECK(job.wait() == 0);
+		CHECK(memcmp(m0 + 100, data, 3000) == 0);
+		CHECK(memcmp(m1 + 100, data, 3000) != 0);
+		CHECK(memcmp(m2 + 100, data, 3000) == 0);
+
+		I2C_eepromAsync	rd(b);
+		memset(back, 0, sizeof(back));
+		CHECK(rd.startRead(100, back, 3000) == 0);
+		CHECK(rd.wait() == 0);
+		CHECK(memcmp(back, data, 3000) == 0);
+
+		CHECK(job.startWrite(32000, data, 1000) == I2C_EEPROM_ERR_RANGE);
+	}
+	return TEST_DONE();
+}
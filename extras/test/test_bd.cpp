@@ -0,0 +1,71 @@
+//
+//               FILE:  test_bd.cpp
+//            PURPOSE:  I2C_eepromBD geometry, checks and block level throughput
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// File level numbers (create/append/read through LittleFS): lfs_files.cpp.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromBD.h>
+#include "test.h"
+
+static uint8_t	mem[65536];
+static uint8_t	small[32768];
+static uint8_t	img[65536];
+static uint8_t	back[65536];
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	sim.attach(0x51, small, sizeof(small), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 512);
+	I2C_eeprom	ee256(sim, 0x51, 256);
+	ee.begin(400);
+
+	// <base> off a page boundary, past the end: no blocks instead of a wrapped count
+	I2C_eepromBD	odd(ee, 3, 0);
+	I2C_eepromBD	past(ee256, 40960, 0);
+	uint8_t		b;
+	CHECK(odd.get_blocks() == 0);
+	CHECK(past.get_blocks() == 0);
+	CHECK(odd.read(0, 0, &b, 1) == I2C_EEPROM_ERR_RANGE);
+	CHECK(past.prog(0, 0, img, 128) == I2C_EEPROM_ERR_RANGE);
+
+	I2C_eepromBD	tail(ee, 65536 - 4 * 128, 0);
+	CHECK(tail.get_blocks() == 4);
+
+	// Whole PROM: 128 byte blocks of one page
+	I2C_eepromBD	bd(ee, 0, 0);
+	CHECK(bd.get_blockSize() == 128);
+	CHECK(bd.get_blocks() == 512);
+	CHECK(bd.get_progSize() == 128);
+	CHECK(bd.prog(0, 3, img, 128) == I2C_EEPROM_ERR_RANGE);
+	CHECK(bd.prog(0, 0, img, 100) == I2C_EEPROM_ERR_RANGE);
+	CHECK(bd.read(511, 100, back, 29) == I2C_EEPROM_ERR_RANGE);
+	CHECK(bd.erase(512) == I2C_EEPROM_ERR_RANGE);
+
+	for (uint32_t i=0; i<sizeof(img); i++) img[i] = i * 13;
+
+	uint32_t t0 = I2C_eepromSim::now();
+	int	 rv = 0;
+	for (uint16_t blk=0; blk<bd.get_blocks(); blk++)
+		rv |= bd.prog(blk, 0, img + blk * 128, 128);
+	bd.sync();
+	uint32_t t1 = I2C_eepromSim::now();
+	for (uint16_t blk=0; blk<bd.get_blocks(); blk++)
+		rv |= bd.read(blk, 0, back + blk * 128, 128);
+	uint32_t t2 = I2C_eepromSim::now();
+
+	CHECK(rv == 0);
+	CHECK(memcmp(img, back, sizeof(img)) == 0);
+	CHECK(bd.get_progs() == 512);
+
+	printf("blocks %u x %u: prog %.1f KB/s, read %.1f KB/s\n", bd.get_blocks(), bd.get_blockSize(), KBS(65536.0, t1 - t0), KBS(65536.0, t2 - t1));
+	return TEST_DONE();
+}
@@ -0,0 +1,120 @@
+//
+//               FILE:  test_cipher.cpp
+//            PURPOSE:  I2C_eepromChaCha20 against RFC 7539, and every read/write path of an I2C_eeprom with a cipher set
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromCipher.h>
+#include "test.h"
+
+#define ADDR		100
+#define SIZE		8000
+
+static uint8_t	m0[32768], m1[32768];
+static uint8_t	img[SIZE], back[SIZE];
+
+
+int main() {
+	uint8_t	key[32];
+	for (int i=0; i<32; i++) key[i] = i;
+
+	// RFC 7539 2.3.2: block function, counter 1
+	{
+		static const uint8_t nonce[12]	= { 0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0 };
+		static const uint8_t ks[16]	= { 0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4 };
+		I2C_eepromChaCha20 c(key, nonce);
+		uint8_t	b[16];
+
+		c.seek(64);
+		for (int i=0; i<16; i++) b[i] = c.next();
+		CHECK(memcmp(b, ks, sizeof(ks)) == 0);
+	}
+
+	// RFC 7539 2.4.2: encryption from counter 1; back and forth by seek()
+	{
+		static const uint8_t nonce[12]	= { 0, 0, 0, 0, 0, 0, 0, 0x4a, 0, 0, 0, 0 };
+		static const char    plain[]	= "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+		static const uint8_t ct[32]	= { 0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80, 0x41, 0xba, 0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81,
+						    0xe9, 0x7e, 0x7a, 0xec, 0x1d, 0x43, 0x60, 0xc2, 0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f, 0xae, 0x0b };
+		I2C_eepromChaCha20 c(key, nonce);
+		uint8_t	b[32], tail;
+
+		c.seek(64 + 100);
+		tail = c.next() ^ plain[100];
+		c.seek(64);
+		for (int i=0; i<32; i++) b[i] = c.next() ^ plain[i];
+		CHECK(memcmp(b, ct, sizeof(ct)) == 0);
+		c.seek(64 + 100);
+		CHECK((c.next() ^ tail) == plain[100]);
+	}
+
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, m0, sizeof(m0), 2, 64);
+	sim.attach(0x51, m1, sizeof(m1), 2, 64);
+	sim.useVirtualClock();
+
+	static const uint8_t nonce[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+	I2C_eepromChaCha20 c(key, nonce);
+	I2C_eeprom	ee(sim, 0x50, 256), plain(sim, 0x51, 256);
+	ee.begin(400);
+	plain.begin(400);
+	for (int i=0; i<SIZE; i++) img[i] = i * 7 + 3;
+
+	// Same bus time with and without; only the cipher text on the PROM
+	uint32_t t = I2C_eepromSim::now();
+	CHECK(ee.writeBlock(ADDR, img, SIZE) == 0);
+	CHECK(ee.readBlock(ADDR, back, SIZE) == SIZE);
+	uint32_t bare = I2C_eepromSim::now() - t;
+
+	ee.setCipher(&c);
+	CHECK(ee.get_cipher() == &c);
+	t = I2C_eepromSim::now();
+	CHECK(ee.writeBlock(ADDR, img, SIZE) == 0);
+	CHECK(ee.readBlock(ADDR, back, SIZE) == SIZE);
+	uint32_t ciphered = I2C_eepromSim::now() - t;
+	CHECK(memcmp(back, img, SIZE) == 0);
+	CHECK(ciphered == bare);
+	int same = 0;
+	for (int i=0; i<SIZE; i++) same += m0[ADDR + i] == img[i];
+	CHECK(same < SIZE / 64);
+	printf("8000 bytes written and read: %.1f ms plain, %.1f ms ciphered; %d bytes alike on the PROM\n", bare / 1000.0, ciphered / 1000.0, same);
+
+	// Any address alone
+	int bad = 0;
+	for (int q=0; q<300; q++) {
+		int a = rand() % (SIZE - 10), n = 1 + rand() % 9;
+		uint8_t b[10];
+		ee.readBlock(ADDR + a, b, n);
+		bad += memcmp(b, img + a, n) != 0;
+		bad += ee.readByte(ADDR + a) != img[a];
+	}
+	CHECK(bad == 0);
+
+	// Compare, fill, gather, checksum, copy to a plain PROM
+	sim.resetStats();
+	CHECK(ee.updateBlock(ADDR, img, 500) == 0);
+	CHECK(sim.get_writeCycles() == 0);
+	CHECK(ee.setBlock(9000, 0x55, 300) == 0);
+	CHECK(ee.readBlock(9000, back, 300) == 300);
+	bad = 0;
+	for (int i=0; i<300; i++) bad += back[i] != 0x55;
+	CHECK(bad == 0);
+	CHECK(m0[9000] != 0x55 || m0[9001] != 0x55);
+
+	I2C_eepromSeg seg[2] = { { ADDR + 100, back, 50, 0 }, { ADDR + 2900, back + 50, 40, 0 } };
+	CHECK(ee.readv(seg, 2) == 0);
+	CHECK(memcmp(back, img + 100, 50) == 0 && memcmp(back + 50, img + 2900, 40) == 0);
+
+	CHECK(ee.copyTo(plain, ADDR, ADDR, SIZE) == 0);
+	CHECK(memcmp(m1 + ADDR, img, SIZE) == 0);
+	CHECK(ee.crc32(ADDR, SIZE) == plain.crc32(ADDR, SIZE));
+
+	// Off again: the cipher text as it is
+	ee.setCipher(NULL);
+	CHECK(ee.readBlock(ADDR, back, 100) == 100);
+	CHECK(memcmp(back, m0 + ADDR, 100) == 0 && memcmp(back, img, 100) != 0);
+	return TEST_DONE();
+}
@@ -0,0 +1,124 @@
+//
+//               FILE:  test_counter.cpp
+//            PURPOSE:  I2C_eepromCounter: counts and reloads, page changes cut by a power loss
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// PowerCut lets a given number of page writes through; those after it never
+// get programmed, as when the supply goes while the page change is on the bus.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromCounter.h>
+#include "test.h"
+
+#define BASE		0x7E00
+#define PAGES		8
+
+static uint8_t	mem[32768];
+static uint8_t	before[PAGES * 64];
+
+
+class PowerCut : public I2C_eepromSim {
+public:
+    PowerCut() : I2C_eepromSim(32), _left(-1), _len(0) {}
+
+    void	cutAfter(const int writes)	{ _left = writes; }
+
+    using I2C_eepromSim::write;
+    void	beginTransmission(uint8_t address) {
+	_len = 0;
+	I2C_eepromSim::beginTransmission(address);
+    }
+    size_t	write(const uint8_t* buffer, size_t length) {
+	_len += length;
+	return I2C_eepromSim::write(buffer, length);
+    }
+    uint8_t	endTransmission(bool stop = true) {
+	if (stop && _len > 2 && _left >= 0) {
+		if (_left == 0) return I2C_eepromSim::endTransmission(false) == 0 ? 0 : 4;	// nothing programmed
+		_left--;
+	}
+	return I2C_eepromSim::endTransmission(stop);
+    }
+
+private:
+    int		_left;			// page writes still programmed; -1 = all
+    size_t	_len;
+};
+
+
+static uint32_t reload(I2C_eeprom& ee) {
+	I2C_eepromCounter c(ee, BASE, PAGES);
+	CHECK(c.begin() == 0);
+	return c.value();
+}
+
+
+int main() {
+	PowerCut	sim;
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	// Blank: formats to 0; counts survive a reload
+	I2C_eepromCounter c(ee, BASE, PAGES);
+	CHECK(c.begin() == 0);
+	CHECK(c.value() == 0);
+	CHECK(c.get_perPage() == 448);
+
+	sim.resetStats();
+	int err = 0;
+	for (int i=0; i<10000; i++) {
+		err |= c.increment();
+		if (i % 997 == 0) CHECK(reload(ee) == c.value());
+	}
+	CHECK(err == 0);
+	CHECK(c.value() == 10000);
+	CHECK(reload(ee) == 10000);
+	printf("10000 counts: %u write cycles, %u bytes written, on page %u\n", sim.get_writeCycles(), sim.get_bytesWritten(), c.get_page());
+
+	// Round the ring once, then fill page 2 again: page 3 still holds
+	// the 0x00 unary bytes of its first lap under its old head
+	CHECK(c.format(0) == 0);
+	int	 laps = 0;
+	uint16_t last = 0;
+	while (!(laps == 1 && c.get_page() == 2)) {
+		c.increment();
+		if (c.get_page() != last) {
+			if (c.get_page() == 0) laps++;
+			last = c.get_page();
+		}
+	}
+	for (uint16_t i=0; i<c.get_perPage(); i++) c.increment();
+	uint32_t was = c.value();
+	CHECK(c.get_page() == 2);
+	memcpy(before, mem + BASE, sizeof(before));
+
+	// The page change with power lost after 0, 1, 2 of its page writes:
+	// the count reads as before or one on, never more
+	for (int k=0; k<=3; k++) {
+		memcpy(mem + BASE, before, sizeof(before));
+		I2C_eepromCounter r(ee, BASE, PAGES);
+		CHECK(r.begin() == 0 && r.value() == was);
+
+		sim.resetStats();
+		sim.cutAfter(k);
+		r.increment();
+		sim.cutAfter(-1);
+		if (k == 3) {
+			CHECK(sim.get_writeCycles() == 3);
+			CHECK(sim.get_bytesWritten() == 64);
+			CHECK(r.get_page() == 3);
+		}
+
+		uint32_t v = reload(ee);
+		CHECK(v == was || (v == was + 1 && k == 3));
+		printf("power lost after %d page write(s) of %d: count %u (was %u)\n", k, 3, v, was);
+	}
+	return TEST_DONE();
+}
@@ -0,0 +1,109 @@
+//
+//               FILE:  test_ecc.cpp
+//            PURPOSE:  I2C_eepromECC: the Hamming kernel bit by bit, the region with flipped bits, partial writes
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromECC.h>
+#include "test.h"
+
+#define BASE		1024
+#define PAGES		100
+#define DATA		61		// bytes per 64 byte page
+
+static uint8_t	mem[32768];
+static uint8_t	img[PAGES * DATA];
+static uint8_t	back[PAGES * DATA];
+
+
+//
+// Every single bit error in data and parity, and pairs of them, on <n> bytes
+//
+static void kernel(const int n) {
+	uint8_t	d[128], o[128], e[3], e2[3];
+	int	fails = 0;
+
+	for (int trial=0; trial<50; trial++) {
+		for (int i=0; i<n; i++) o[i] = rand();
+		I2C_eepromECC::encode(o, n, e);
+
+		for (int b=0; b<n*8; b++) {
+			memcpy(d, o, n);
+			d[b / 8] ^= 1 << (b % 8);
+			if (I2C_eepromECC::correct(d, n, e) != 1 || memcmp(d, o, n) != 0) fails++;
+		}
+		for (int b=0; b<24; b++) {
+			memcpy(e2, e, 3);
+			e2[b / 8] ^= 1 << (b % 8);
+			memcpy(d, o, n);
+			if (I2C_eepromECC::correct(d, n, e2) != 0 || memcmp(d, o, n) != 0) fails++;
+		}
+		for (int k=0; k<200; k++) {
+			int a = rand() % (n * 8), b;
+			do b = rand() % (n * 8); while (b == a);
+			memcpy(d, o, n);
+			d[a / 8] ^= 1 << (a % 8);
+			d[b / 8] ^= 1 << (b % 8);
+			if (I2C_eepromECC::correct(d, n, e) != -1) fails++;
+		}
+	}
+	CHECK(fails == 0);
+}
+
+
+int main() {
+	static const int lengths[] = { 5, 13, 29, 61, 125 };
+	for (unsigned i=0; i<sizeof(lengths)/sizeof(lengths[0]); i++) kernel(lengths[i]);
+
+	// Erased page reads as valid
+	uint8_t	ff[DATA], e[3];
+	memset(ff, 0xFF, sizeof(ff));
+	I2C_eepromECC::encode(ff, DATA, e);
+	CHECK(e[0] == 0xFF && e[1] == 0xFF && e[2] == 0xFF);
+
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+	I2C_eepromECC	ecc(ee, BASE, PAGES);
+	CHECK(ecc.get_size() == PAGES * DATA);
+
+	for (int i=0; i<PAGES * DATA; i++) img[i] = rand();
+	CHECK(ecc.write(0, img, sizeof(img)) == 0);
+
+	// One bit in page 7's data, one in page 9's parity, two in page 11
+	mem[BASE + 64 * 7 + 10]	^= 0x10;
+	mem[BASE + 64 * 9 + 61]	^= 0x01;
+	mem[BASE + 64 * 11 + 3]	^= 0x03;
+	CHECK(ecc.read(0, back, sizeof(back)) == I2C_EEPROM_ERR_ECC);
+	int diff = 0;
+	for (int i=0; i<PAGES * DATA; i++) diff += back[i] != img[i];
+	CHECK(diff == 1);
+	CHECK(ecc.get_corrected() == 1);
+	CHECK(ecc.get_uncorrectable() == 1);
+
+	CHECK(ecc.scrub() == I2C_EEPROM_ERR_ECC);
+	CHECK(mem[BASE + 64 * 7 + 10] == img[7 * DATA + 10]);
+
+	CHECK(ecc.write(5, img, 3) == 0);
+	CHECK(ecc.read(0, back, 10) == 0);
+	CHECK(back[5] == img[0] && back[4] == img[4]);
+
+	// A partial write doesn't bless an uncorrectable page; a whole one replaces it
+	uint32_t bad  = ecc.get_uncorrectable();
+	uint8_t	 keep = mem[BASE + 64 * 11 + 3];
+	CHECK(ecc.write(11 * DATA + 20, img, 4) == I2C_EEPROM_ERR_ECC);
+	CHECK(ecc.get_uncorrectable() == bad + 1);
+	CHECK(mem[BASE + 64 * 11 + 3] == keep);
+
+	CHECK(ecc.write(11 * DATA, img + 11 * DATA, DATA) == 0);
+	CHECK(ecc.read(11 * DATA, back, DATA) == 0);
+	CHECK(memcmp(back, img + 11 * DATA, DATA) == 0);
+	return TEST_DONE();
+}
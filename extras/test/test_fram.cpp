@@ -0,0 +1,84 @@
+//
+//               FILE:  test_fram.cpp
+//            PURPOSE:  FRAM against 24xx: 32 KB written and read in 4 KB blocks, write cycle polls, chunks across pages
+//           Platform:  Linux host, I2C_eepromSim (24LC256 and FM24C256, 400 kHz, 32 byte Wire and 4 KB i2c-dev buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+static uint8_t	m0[32768], m1[32768];
+static uint8_t	data[4096], back[4096];
+
+struct Run {
+	uint32_t write;		// us
+	uint32_t read;
+	uint32_t transactions;	// of the writes
+	uint32_t nacks;
+};
+
+
+static Run run(const uint16_t buffer, const bool fram) {
+	I2C_eepromSim	sim(buffer);
+	uint8_t*	mem = fram ? m1 : m0;
+	Run		r;
+
+	memset(mem, 0xFF, sizeof(m0));
+	if (fram)
+		sim.attach(0x50, mem, sizeof(m1), 2, 0, 0);
+	else
+		sim.attach(0x50, mem, sizeof(m0), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, fram ? (I2C_EEPROM_FRAM | 256) : 256);
+	ee.begin(400);
+	CHECK(ee.isFRAM() == fram);
+	CHECK(ee.get_pageSize() == (fram ? 128 : 64));
+
+	uint32_t t = I2C_eepromSim::now();
+	for (uint32_t a=0; a<sizeof(m0); a+=sizeof(data))
+		CHECK(ee.writeBlock(a, data, sizeof(data)) == 0);
+	r.write = I2C_eepromSim::now() - t;
+	r.transactions = sim.get_transactions();
+	r.nacks = sim.get_nacks();
+
+	int bad = 0;
+	t = I2C_eepromSim::now();
+	for (uint32_t a=0; a<sizeof(m0); a+=sizeof(back)) {
+		ee.readBlock(a, back, sizeof(back));
+		bad += memcmp(back, data, sizeof(back)) != 0;
+	}
+	r.read = I2C_eepromSim::now() - t;
+	CHECK(bad == 0);
+
+	// Odd addresses across the (nominal) pages
+	CHECK(ee.setBlock(100, 0x3C, 1000) == 0);
+	CHECK(ee.writeBlock(1201, data, 333) == 0);
+	CHECK(mem[99] == data[99] && mem[100] == 0x3C && mem[1099] == 0x3C && mem[1100] == data[1100]);
+	CHECK(memcmp(mem + 1201, data, 333) == 0);
+
+	printf("%-8s %4u byte buffer: write %5.1f KB/s, %6u transactions, %6u polls; read %5.1f KB/s\n",
+		fram ? "FM24C256" : "24LC256", buffer, KBS(sizeof(m0), r.write), r.transactions, r.nacks, KBS(sizeof(m0), r.read));
+	return r;
+}
+
+
+int main() {
+	for (uint32_t i=0; i<sizeof(data); i++) data[i] = i * 7;
+
+	static const uint16_t buffers[] = { 32, 4096 };
+	for (unsigned b=0; b<sizeof(buffers)/sizeof(buffers[0]); b++) {
+		Run prom = run(buffers[b], false);
+		Run fram = run(buffers[b], true);
+
+		// No write cycle to poll; chunks as long as the buffer allows
+		CHECK(fram.nacks == 0);
+		CHECK(prom.nacks > 0);
+		CHECK(fram.write * 4 < prom.write);
+		CHECK(fram.transactions < prom.transactions - prom.nacks);
+		CHECK(fram.read <= prom.read);
+	}
+	return TEST_DONE();
+}
@@ -0,0 +1,139 @@
+//
+//               FILE:  test_group.cpp
+//            PURPOSE:  I2C_eepromGroup: stripe layout, data, errors, and the rate on one and two buses
+//           Platform:  Linux host, I2C_eepromSim (24xx256 members, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+// Three ways to run the buses:
+//	wire	 one task, blocking transactions: the buses take turns (SAMD, AVR on Wire)
+//	bg	 one task, transactions in the background (I2C_eepromTWI alikes)
+//	tasks	 one task per bus, blocking transactions (ESP32)
+// The simulator's one model clock runs on with the bits of every bus, so
+// only "bg" shows buses overlapping; "tasks" checks data and the clock.
+//
+
+#include <I2C_eepromGroup.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+#define LENGTH		8192
+
+enum { WIRE, BG, TASKS };
+static const char* mode[] = { "wire", "bg", "tasks" };
+
+static uint8_t	mem[4][32768];
+static uint8_t	img[LENGTH], back[LENGTH];
+
+struct Run {
+	int	rv;
+	uint32_t write;		// us
+	uint32_t read;		// us
+	uint32_t bus;		// us of bus time, all buses, in the read
+};
+
+
+static Run run(const int members, const int buses, const int how, const uint32_t addr, const uint32_t len) {
+	I2C_eepromSim	sim[2];
+	I2C_eeprom*	ee[4];
+	I2C_eepromGroup	group;
+	Run		r;
+
+	memset(mem, 0xFF, sizeof(mem));
+	for (int m=0; m<members; m++) {
+		I2C_eepromSim& s = sim[m % buses];
+		s.attach(0x50 + m / buses, mem[m], sizeof(mem[m]), 2, 64);
+		s.setBackground(how == BG);
+		ee[m] = new I2C_eeprom(s, 0x50 + m / buses, 256);
+		ee[m]->begin(400);
+		CHECK(group.add(*ee[m]));
+	}
+	group.setTasks(how == TASKS);
+	CHECK(group.get_buses() == buses);
+	CHECK(group.get_size() == members * 32768UL);
+
+	for (uint32_t i=0; i<len; i++) img[i] = rand();
+	uint32_t t = I2C_eepromSim::now();
+	r.rv = group.write(addr, img, len);
+	r.write = I2C_eepromSim::now() - t;
+
+	sim[0].resetStats();
+	sim[1].resetStats();
+	memset(back, 0, len);
+	t = I2C_eepromSim::now();
+	r.rv |= group.read(addr, back, len);
+	r.read = I2C_eepromSim::now() - t;
+	r.bus = sim[0].get_busMicros() + sim[1].get_busMicros();
+
+	// Group byte L: stripe L/64 on member (L/64) % members
+	CHECK(memcmp(back, img, len) == 0);
+	for (uint32_t L=addr; L<addr+len; L++) {
+		uint32_t s = L / 64;
+		if (mem[s % members][(s / members) * 64 + L % 64] != img[L - addr]) {
+			CHECK(false);
+			break;
+		}
+	}
+	for (int m=0; m<members; m++) delete ee[m];
+	return r;
+}
+
+
+int main() {
+	I2C_eepromSim::useVirtualClock();
+	srand(1);
+
+	// Rates: one bus and two, 8 KB
+	static const int config[][2] = { { 1, 1 }, { 2, 1 }, { 2, 2 }, { 4, 2 } };
+	uint32_t	readTime[3][4];
+
+	for (int how=WIRE; how<=TASKS; how++)
+		for (int c=0; c<4; c++) {
+			Run r = run(config[c][0], config[c][1], how, 0, LENGTH);
+			CHECK(r.rv == 0);
+			readTime[how][c] = r.read;
+			printf("%-5s %d member(s) on %d bus(es): write %6.1f KB/s, read %5.1f KB/s\n", mode[how],
+				config[c][0], config[c][1], KBS(LENGTH, r.write), KBS(LENGTH, r.read));
+
+			// No tick of either bus lost on the shared clock
+			if (how == TASKS) CHECK(r.read + 2 >= r.bus);
+		}
+
+	// Write cycles overlap in every mode; bus time only with a background bus
+	CHECK(readTime[WIRE][2] * 10 > readTime[WIRE][0] * 9);
+	CHECK(readTime[BG][2] * 10 < readTime[BG][0] * 6);
+	CHECK(readTime[BG][3] * 10 < readTime[BG][1] * 6);
+
+	// Unaligned, a stripe count no power of 2
+	CHECK(run(4, 2, TASKS, 37, 5000).rv == 0);
+	CHECK(run(3, 1, BG, 100, 3000).rv == 0);
+
+	// Errors: out of range, no member, a member gone and back
+	{
+		I2C_eepromGroup	empty;
+		CHECK(empty.write(0, img, 1) == I2C_EEPROM_ERR_RANGE);
+
+		I2C_eepromSim	sim;
+		I2C_eeprom	ee0(sim, 0x50, 256), ee1(sim, 0x51, 256);
+		I2C_eepromGroup	group;
+		sim.attach(0x50, mem[0], 32768, 2, 64);
+		sim.attach(0x51, mem[1], 32768, 2, 64);
+		ee0.begin(400);
+		ee1.begin(400);
+		group.add(ee0);
+		group.add(ee1);
+		CHECK(group.read(65530, back, 10) == I2C_EEPROM_ERR_RANGE);
+
+		I2C_eepromSimDev* dev = sim.get_device(0x51);
+		dev->address = 0x58;
+		CHECK(group.read(0, back, 1024) == I2C_EEPROM_ERR_READ);
+		CHECK(group.write(0, img, 1024) != 0);
+
+		// Back again: the error was that transfer's, the next ones run
+		dev->address = 0x51;
+		CHECK(group.write(0, img, 1024) == 0);
+		CHECK(group.read(0, back, 1024) == 0);
+		CHECK(memcmp(back, img, 1024) == 0);
+		CHECK(group.write(2048, img, 100) == 0);
+	}
+	return TEST_DONE();
+}
@@ -0,0 +1,103 @@
+//
+//               FILE:  test_hash.cpp
+//            PURPOSE:  I2C_eepromHash: build, every key found with its value, page reads per hit and miss, a failed build
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// Records: 4 byte key from a multiplicative hash of <i>, 2 byte value <i>.
+// Keys from <i> beyond the count are misses.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromHash.h>
+#include "test.h"
+
+#define PAGES		512		// whole PROM
+
+static uint8_t	mem[65536];
+
+
+static void source(void* ctx, const uint32_t i, uint8_t* rec) {
+	uint32_t key = i * 2654435761UL + 7;
+	uint16_t val = i;
+
+	(void)ctx;
+	memcpy(rec, &key, 4);
+	memcpy(rec + 4, &val, 2);
+}
+
+
+//
+// All <n> keys and 2000 others looked up; values compared when <values>
+//
+static void lookups(I2C_eepromHash& ht, const uint32_t n, const bool values, double* hit, double* miss) {
+	uint8_t	rec[6], val[2];
+	int	bad = 0;
+
+	uint32_t reads = ht.get_pageReads();
+	for (uint32_t i=0; i<n; i++) {
+		source(NULL, i, rec);
+		if (!ht.find(rec, val) || (values && memcmp(val, rec + 4, 2) != 0)) bad++;
+	}
+	*hit  = (ht.get_pageReads() - reads) / (double)n;
+	reads = ht.get_pageReads();
+	for (uint32_t i=n; i<n+2000; i++) {
+		source(NULL, i, rec);
+		if (ht.find(rec)) bad++;
+	}
+	*miss = (ht.get_pageReads() - reads) / 2000.0;
+	CHECK(bad == 0);
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 512);
+	ee.begin(400);
+
+	I2C_eepromHash	ht(ee, 0, PAGES);
+	CHECK(ht.begin() == I2C_EEPROM_ERR_VERIFY);
+	CHECK(ht.build(0, 2, 10, source, NULL) == I2C_EEPROM_ERR_RANGE);
+
+	// Lightly and well filled: about one page read a lookup either way
+	static const uint32_t counts[] = { 1000, 8000 };
+	double hit, miss;
+	for (unsigned c=0; c<sizeof(counts)/sizeof(counts[0]); c++) {
+		uint32_t n = counts[c];
+		sim.resetStats();
+		CHECK(ht.build(4, 2, n, source, NULL) == 0);
+		CHECK(ht.get_buckets() == PAGES - 1 && ht.get_slots() == 21);
+		CHECK(sim.get_writeCycles() <= PAGES * 5UL);		// full pages: 30 + 30 + 30 + 30 + 8 bytes
+
+		I2C_eepromHash r(ee, 0, PAGES);
+		CHECK(r.begin() == 0);
+		CHECK(r.get_entries() == n);
+		lookups(r, n, true, &hit, &miss);
+		printf("%5u keys in %u x %u slots: %.3f page reads per hit, %.3f per miss\n", n, r.get_buckets(), r.get_slots(), hit, miss);
+		CHECK(hit < 1.1 && miss < 1.5);
+	}
+
+	// Beyond the spill area: no table left behind, not the old one either;
+	// nor in the instance
+	uint8_t rec[6];
+	source(NULL, 0, rec);
+	CHECK(ht.find(rec));
+	CHECK(ht.build(4, 2, 9800, source, NULL) == I2C_EEPROM_ERR_RANGE);
+	CHECK(ht.get_buckets() == 0 && !ht.find(rec));
+	I2C_eepromHash r(ee, 0, PAGES);
+	CHECK(r.begin() == I2C_EEPROM_ERR_VERIFY);
+
+	// Keys only, in a small table behind other data
+	memset(mem, 0x55, 128);
+	I2C_eepromHash	keys(ee, 128, 20);
+	CHECK(keys.build(4, 0, 200, source, NULL) == 0);
+	CHECK(keys.begin() == 0 && keys.get_slots() == 31);
+	lookups(keys, 200, false, &hit, &miss);
+	CHECK(mem[0] == 0x55 && mem[127] == 0x55);
+	return TEST_DONE();
+}
@@ -0,0 +1,79 @@
+//
+//               FILE:  test_lean.cpp
+//            PURPOSE:  I2C_EEPROM_LEAN: geometry worked out per call for every type, instance size, status(Print&)
+//           Platform:  Linux host, I2C_eepromSim (400 kHz); built with I2C_EEPROM_LEAN
+//---------------------------------------------------------------------------------------------------------
+//
+// The same table holds without I2C_EEPROM_LEAN; this build checks the
+// derivation that replaces the cached fields.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+#ifndef I2C_EEPROM_LEAN
+#error build with I2C_EEPROM_LEAN
+#endif
+
+struct Geometry {
+	unsigned type;
+	int	 pages, pageSize, Kbytes, addrBits, addrWords;
+};
+
+static const Geometry table[] = {
+	{ 1,				 16,   8,   0,  7, 1 },
+	{ 2,				 32,   8,   0,  8, 1 },
+	{ 4,				 32,  16,   0,  9, 1 },
+	{ 8,				 64,  16,   1, 10, 1 },
+	{ 16,				128,  16,   2, 11, 1 },
+	{ 32,				128,  32,   4, 12, 2 },
+	{ 64,				256,  32,   8, 13, 2 },
+	{ 128,				256,  64,  16, 14, 2 },
+	{ 256,				512,  64,  32, 15, 2 },
+	{ 512,				512, 128,  64, 16, 2 },
+	{ I2C_EEPROM_FRAM | 64,		 64, 128,   8, 13, 2 },
+	{ I2C_EEPROM_FRAM | 512,	512, 128,  64, 16, 2 },
+};
+
+// Print into a string
+class Text : public Print {
+public:
+    Text() : len(0)		{ buf[0] = 0; }
+    size_t	write(uint8_t c)	{ if (len < sizeof(buf) - 1) { buf[len++] = c; buf[len] = 0; } return 1; }
+
+    char	buf[256];
+    size_t	len;
+};
+
+
+int main() {
+	I2C_eepromSim	sim;
+	int		bad = 0;
+
+	for (unsigned i=0; i<sizeof(table)/sizeof(table[0]); i++) {
+		const Geometry& g = table[i];
+		I2C_eeprom ee(sim, 0x50, g.type);
+		ee.begin(400);
+		if (ee.get_pages() != g.pages || ee.get_pageSize() != g.pageSize || ee.get_Kbytes() != g.Kbytes
+		 || ee.get_addrBits() != g.addrBits || ee.get_addrWords() != g.addrWords) {
+			printf("type %x: %d pages of %d, %d KB, %d bits, %d words\n", g.type,
+				ee.get_pages(), ee.get_pageSize(), ee.get_Kbytes(), ee.get_addrBits(), ee.get_addrWords());
+			bad++;
+		}
+	}
+	CHECK(bad == 0);
+
+	// The instance within its budget; status() the same both ways
+	CHECK(sizeof(I2C_eeprom) <= I2C_EEPROM_LEAN_BUDGET);
+
+	I2C_eeprom	ee(sim, 0x57, 256);
+	Text		out;
+	char		buf[256];
+	ee.begin(400);
+	ee.status(out);
+	CHECK(strcmp(ee.status(buf, sizeof(buf)), out.buf) == 0);
+	CHECK(strstr(out.buf, "KBytes: 32, Pages: 512, Page size: 64") != NULL);
+	printf("instance %u bytes (budget %u)\n%s", (unsigned)sizeof(I2C_eeprom), (unsigned)I2C_EEPROM_LEAN_BUDGET, out.buf);
+	return TEST_DONE();
+}
@@ -0,0 +1,103 @@
+//
+//               FILE:  test_lz.cpp
+//            PURPOSE:  I2C_eepromLZ: frames back by index, ratio on log text, raw frames, full region, reopen
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// Frames: CSV log lines as a sketch would keep them; every 10th one random
+// bytes, which do not shrink and are stored as is.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromLZ.h>
+#include "test.h"
+
+#define BASE		0x1000
+#define SIZE		0x4000
+
+static uint8_t	mem[32768];
+static uint8_t	frame[1024], back[1024];
+
+
+static uint16_t make(const int n, uint8_t* buf) {
+	uint16_t len = 0;
+
+	srand(n);
+	if (n % 10 == 9) {
+		len = 100 + n % 200;
+		for (uint16_t i=0; i<len; i++) buf[i] = rand();
+		return len;
+	}
+	for (int line=0; line<12; line++)
+		len += sprintf((char*)buf + len, "%05d,%d.%02d,%d,OK\n", n * 12 + line, 20 + rand() % 3, rand() % 100, 1000 + rand() % 20);
+	return len;
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	I2C_eepromLZ	lz(ee, BASE, SIZE);
+	CHECK(lz.begin() == 0);
+	CHECK(lz.read(0, back, sizeof(back)) == 0);
+	CHECK(lz.append(frame, 0) == I2C_EEPROM_ERR_RANGE);
+
+	// Until the region is full
+	int	 n = 0, rv;
+	uint16_t len;
+	uint32_t text = 0, textStored = 0;
+	while (true) {
+		len = make(n, frame);
+		uint32_t was = lz.get_storedBytes();
+		if ((rv = lz.append(frame, len)) != 0) break;
+		if (n % 10 != 9) {
+			text	   += len;
+			textStored += lz.get_storedBytes() - was;
+		}
+		n++;
+	}
+	CHECK(rv == I2C_EEPROM_ERR_RANGE);
+	CHECK(lz.get_frames() == n);
+	CHECK(lz.get_storedBytes() + lz.get_free() == SIZE);
+	CHECK(lz.get_ratio() < 75 && textStored * 100 < text * 70);
+	printf("%d frames in %u bytes: %u raw, ratio %u%%; log text alone %u%%\n",
+		n, SIZE, lz.get_rawBytes(), lz.get_ratio(), (unsigned)(textStored * 100 / text));
+
+	// Every frame back, forward by the cursor and backward; a short buffer
+	int bad = 0;
+	for (int i=0; i<n; i++) {
+		len = make(i, frame);
+		if (lz.get_frameLength(i) != len || lz.read(i, back, sizeof(back)) != len || memcmp(back, frame, len) != 0) bad++;
+	}
+	for (int i=n-1; i>=0; i-=7) {
+		len = make(i, frame);
+		if (lz.read(i, back, 10) != 10 || memcmp(back, frame, 10) != 0) bad++;
+	}
+	CHECK(bad == 0);
+	CHECK(lz.read(n, back, sizeof(back)) == 0);
+
+	// Reopen: the same frames and counts; the region outside untouched
+	CHECK(mem[BASE - 1] == 0xFF && mem[BASE + SIZE] == 0xFF);
+	I2C_eepromLZ	r(ee, BASE, SIZE);
+	CHECK(r.begin() == n);
+	CHECK(r.get_rawBytes() == lz.get_rawBytes());
+	CHECK(r.get_storedBytes() == lz.get_storedBytes());
+	len = make(n / 2, frame);
+	CHECK(r.read(n / 2, back, sizeof(back)) == len && memcmp(back, frame, len) == 0);
+
+	// Format: empty, and stays empty after a reopen
+	CHECK(r.format() == 0);
+	CHECK(r.get_frames() == 0 && r.get_free() == SIZE);
+	CHECK(lz.begin() == 0);
+	len = make(0, frame);
+	CHECK(r.append(frame, len) == 0);
+	CHECK(lz.begin() == 1);
+	return TEST_DONE();
+}
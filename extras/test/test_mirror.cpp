@@ -0,0 +1,117 @@
+//
+//               FILE:  test_mirror.cpp
+//            PURPOSE:  copyTo() and setMirror()/syncMirror(): data, writes skipped, overlapping write cycles, page sizes
+//           Platform:  Linux host, I2C_eepromSim (24xx512, 24xx256 and 24xx64, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+static uint8_t	m0[32768], m1[32768], m2[8192], m3[65536];
+static uint8_t	img[4096];
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(m1, 0xFF, sizeof(m1));
+	memset(m2, 0xFF, sizeof(m2));
+	sim.attach(0x50, m0, sizeof(m0), 2, 64);
+	sim.attach(0x51, m1, sizeof(m1), 2, 64);
+	sim.attach(0x52, m2, sizeof(m2), 2, 32);
+	sim.useVirtualClock();
+
+	I2C_eeprom	a(sim, 0x50, 256), b(sim, 0x51, 256), c(sim, 0x52, 64);
+	I2C_eepromCopyStat st;
+	a.begin(400);
+	b.begin(400);
+	c.begin(400);
+
+	for (uint32_t i=0; i<sizeof(m0); i++) m0[i] = i * 13 + (i >> 8);
+
+	// Into smaller pages; within one PROM; ranges that don't fit or overlap
+	CHECK(a.copyTo(c, 100, 50, 8000) == 0);
+	CHECK(memcmp(m0 + 100, m2 + 50, 8000) == 0);
+	CHECK(a.copyTo(a, 0, 20000, 4000) == 0);
+	CHECK(memcmp(m0, m0 + 20000, 4000) == 0);
+	CHECK(a.copyTo(a, 0, 100, 4000) == I2C_EEPROM_ERR_RANGE);
+	CHECK(a.copyTo(c, 0, 4000, 5000) == I2C_EEPROM_ERR_RANGE);
+
+	// Whole PROM to a blank one, then again: the second costs reads only
+	CHECK(a.copyTo(b, 0, 0, sizeof(m0), &st) == 0);
+	CHECK(memcmp(m0, m1, sizeof(m0)) == 0);
+	CHECK(st.bytes == sizeof(m0) && st.skipped == 0);
+	printf("copy 32 KB:     %5u writes, %5u skipped, %7.1f ms, %6u bytes/s\n", st.written, st.skipped, st.micros / 1000.0, st.rate);
+	uint16_t first = st.written;
+
+	CHECK(a.copyTo(b, 0, 0, sizeof(m0), &st) == 0);
+	CHECK(st.written == 0 && st.skipped == first);
+	printf("copy unchanged: %5u writes, %5u skipped, %7.1f ms, %6u bytes/s\n", st.written, st.skipped, st.micros / 1000.0, st.rate);
+
+	// Mirror: every write to the backup too, the write cycles overlapping
+	for (uint32_t i=0; i<sizeof(img); i++) img[i] = rand();
+	uint32_t t = I2C_eepromSim::now();
+	CHECK(a.writeBlock(1000, img, sizeof(img)) == 0);
+	uint32_t single = I2C_eepromSim::now() - t;
+
+	a.setMirror(&b);
+	CHECK(a.get_mirror() == &b);
+	for (uint32_t i=0; i<sizeof(img); i++) img[i] = rand();
+	t = I2C_eepromSim::now();
+	CHECK(a.writeBlock(1000, img, sizeof(img)) == 0);
+	uint32_t mirrored = I2C_eepromSim::now() - t;
+	CHECK(memcmp(m0 + 1000, img, sizeof(img)) == 0);
+	CHECK(memcmp(m1 + 1000, img, sizeof(img)) == 0);
+	CHECK(mirrored * 10 < single * 13);
+	printf("write 4 KB:     %7.1f ms, with mirror %7.1f ms\n", single / 1000.0, mirrored / 1000.0);
+
+	// Backup off for a while: syncMirror() writes only what differs
+	a.setMirror(NULL);
+	CHECK(a.writeBlock(30000, img, 100) == 0);
+	a.setMirror(&b);
+	CHECK(a.syncMirror(&st) == 0);
+	CHECK(memcmp(m0, m1, sizeof(m0)) == 0);
+	CHECK(st.written <= 6);
+	a.setMirror(&a);
+	CHECK(a.get_mirror() == NULL);
+
+	// Cycles refused: the chain would write forever
+	a.setMirror(&b);
+	b.setMirror(&a);
+	CHECK(b.get_mirror() == NULL);
+	b.setMirror(&c);
+	c.setMirror(&a);
+	CHECK(c.get_mirror() == NULL);
+	b.setMirror(NULL);
+
+	// Mirrors with smaller pages: each chunk fits every page in the chain
+	{
+		I2C_eepromSim	big(4096);
+		memset(m3, 0xFF, sizeof(m3));
+		memset(m1, 0xFF, sizeof(m1));
+		memset(m2, 0xFF, sizeof(m2));
+		big.attach(0x50, m3, sizeof(m3), 2, 128);
+		big.attach(0x51, m1, sizeof(m1), 2, 64);
+		big.attach(0x52, m2, sizeof(m2), 2, 32);
+
+		I2C_eeprom	p(big, 0x50, 512), q(big, 0x51, 256), r(big, 0x52, 64);
+		p.begin(400);
+		q.begin(400);
+		r.begin(400);
+		p.setMirror(&q);
+		q.setMirror(&r);
+
+		CHECK(p.writeBlock(50, img, 100) == 0);
+		CHECK(memcmp(m3 + 50, img, 100) == 0);
+		CHECK(memcmp(m1 + 50, img, 100) == 0);
+		CHECK(memcmp(m2 + 50, img, 100) == 0);
+
+		CHECK(p.setBlock(1000, 0x77, 300) == 0);
+		CHECK(p.updateBlock(2000, img, 1000) == 0);
+		CHECK(a.copyTo(p, 4000, 3000, 500) == 0);
+		CHECK(memcmp(m3, m1, 8192) == 0 && memcmp(m3, m2, 8192) == 0);
+		CHECK(memcmp(m3 + 3000, m0 + 4000, 500) == 0);
+	}
+	return TEST_DONE();
+}
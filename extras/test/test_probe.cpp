@@ -0,0 +1,139 @@
+//
+//               FILE:  test_probe.cpp
+//            PURPOSE:  probe()/scan()/detect() on every 24xx size, blank parts, records with equal headers,
+//                      and the simulator's address counter on a write ended by a repeated START
+//           Platform:  Linux host, I2C_eepromSim
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+static uint8_t	mem[65536];
+
+static const struct {
+	unsigned int	type;
+	uint32_t	size;
+	uint8_t		words;
+	uint16_t	page;
+} parts[] = {
+	{   1,   128, 1,   8 },
+	{   2,   256, 1,   8 },
+	{   4,   512, 1,  16 },
+	{   8,  1024, 1,  16 },
+	{  16,  2048, 1,  16 },
+	{  32,  4096, 2,  32 },
+	{  64,  8192, 2,  32 },
+	{ 128, 16384, 2,  64 },
+	{ 256, 32768, 2,  64 },
+	{ 512, 65536, 2, 128 },
+};
+
+
+int main() {
+	srand(1);
+	for (uint32_t i=0; i<sizeof(mem); i++) mem[i] = rand();
+
+	// A 24xx01/02 takes the 2nd byte of a two word address as data: the
+	// counter moves on, the repeated START drops the write
+	{
+		I2C_eepromSim	sim;
+		uint8_t		addr[2] = { 0x00, 0x05 };
+		uint8_t		keep = mem[0];
+		sim.attach(0x50, mem, 256, 1, 8);
+
+		sim.beginTransmission(0x50);
+		sim.write(addr, 2);
+		CHECK(sim.endTransmission(false) == 0);
+		CHECK(sim.requestFrom(0x50, 1) == 1);
+		CHECK(sim.read() == mem[1]);
+		CHECK(mem[0] == keep);
+	}
+
+	// Every size, on an address of its own, with random data
+	for (uint8_t p=0; p<sizeof(parts)/sizeof(parts[0]); p++) {
+		I2C_eepromSim	sim;
+		uint8_t		at[8];
+		unsigned int	type[8];
+		uint8_t		base = (parts[p].type == 16) ? 0x50 : (parts[p].type >= 4 && parts[p].type <= 8) ? 0x54 : 0x53;
+
+		sim.useVirtualClock();
+		sim.begin(400);
+		sim.attach(base, mem, parts[p].size, parts[p].words, parts[p].page);
+
+		uint32_t t0 = I2C_eepromSim::now();
+		uint8_t  n  = I2C_eeprom::scan(sim, at, type, 8);
+		uint32_t us = I2C_eepromSim::now() - t0;
+
+		CHECK(n == 1 && at[0] == base && type[0] == parts[p].type);
+		printf("24xx%-3u scan %5lu us @ 400 kHz\n", parts[p].type, (unsigned long)us);
+
+		I2C_eeprom ee(sim, base, parts[p].words == 1 ? 1 : 64);
+		ee.begin(400);
+		CHECK(ee.detect() == 0);
+		CHECK(ee.get_deviceSize() == (int)parts[p].type);
+		CHECK(ee.get_addrWords() == parts[p].words);
+		CHECK(ee.get_pageSize() == parts[p].page);
+	}
+
+	// Blank: answers, no size; detect() keeps the constructor's type
+	{
+		static uint8_t	blank[32768];
+		I2C_eepromSim	sim;
+		memset(blank, 0xFF, sizeof(blank));
+		sim.attach(0x50, blank, 128, 1, 8);
+		sim.attach(0x51, blank, sizeof(blank), 2, 64);
+
+		CHECK(I2C_eeprom::probe(sim, 0x50) == I2C_EEPROM_BLANK);
+		CHECK(I2C_eeprom::probe(sim, 0x51) == I2C_EEPROM_BLANK);
+		CHECK(I2C_eeprom::probe(sim, 0x52) == 0);
+
+		I2C_eeprom ee(sim, 0x51, 64);
+		ee.begin(400);
+		CHECK(ee.detect() == I2C_EEPROM_ERR_VERIFY);
+		CHECK(ee.get_deviceSize() == 64);
+	}
+
+	// Records with equal headers every 128 bytes, the counter anywhere: no
+	// wrap unless a whole period comes again
+	for (uint8_t p=0; p<sizeof(parts)/sizeof(parts[0]); p++) {
+		static const uint16_t skip[] = { 0, 77, 128, 1000 };
+		uint32_t size = parts[p].size;
+		for (uint32_t i=0; i<size; i++) mem[i] = (i % 128 < 8) ? "REC:v1\0\x80"[i % 128] : (i / 128 * 131 + i / 32768 * 7 + i % 128) & 0xFF;
+
+		for (uint8_t k=0; k<sizeof(skip)/sizeof(skip[0]); k++) {
+			I2C_eepromSim	sim;
+			sim.attach(0x50, mem, size, parts[p].words, parts[p].page);
+			for (uint16_t n=skip[k]; n>0; n--) sim.requestFrom(0x50, 1), sim.read();
+			CHECK(I2C_eeprom::probe(sim, 0x50) == parts[p].type);
+		}
+	}
+
+	// The same record all over a 24xx256: that is a 24xx01 to reads; detect()
+	// doesn't take one address word for two
+	{
+		I2C_eepromSim	sim;
+		for (uint32_t i=0; i<32768; i++) mem[i] = (i % 128 < 8) ? "REC:v1\0\x80"[i % 128] : i % 128;
+		sim.attach(0x50, mem, 32768, 2, 64);
+
+		CHECK(I2C_eeprom::probe(sim, 0x50) == 1);
+		I2C_eeprom ee(sim, 0x50, 256);
+		ee.begin(400);
+		CHECK(ee.detect() == I2C_EEPROM_ERR_VERIFY);
+		CHECK(ee.get_deviceSize() == 256 && ee.get_addrWords() == 2 && ee.get_pageSize() == 64);
+	}
+
+	// A 24xx16 driven block by block as 24xx02s stays so
+	for (uint32_t i=0; i<2048; i++) mem[i] = rand();
+	{
+		I2C_eepromSim	sim;
+		sim.attach(0x50, mem, 2048, 1, 16);
+
+		I2C_eeprom ee(sim, 0x53, 2);
+		ee.begin(400);
+		CHECK(ee.detect() == 0);
+		CHECK(ee.get_deviceSize() == 2);
+	}
+	return TEST_DONE();
+}
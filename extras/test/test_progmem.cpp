@@ -0,0 +1,67 @@
+//
+//               FILE:  test_progmem.cpp
+//            PURPOSE:  writeBlock_P(), updateBlock_P(), updateBlock() and setBlock(): data, write cycles, page splits
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// On the host PROGMEM is plain memory; the _P calls still take the byte by
+// byte source path of an AVR.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+static uint8_t	mem[32768];
+static uint8_t	table[300] PROGMEM;
+static uint8_t	data[300];
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+	for (int i=0; i<300; i++) table[i] = i * 11 + 5;
+
+	// 300 bytes @ 10: 54 + 3 * 64 + 54 bytes in pages 0..4, 30 per chunk
+	CHECK(ee.writeBlock_P(10, table, sizeof(table)) == 0);
+	CHECK(memcmp(mem + 10, table, sizeof(table)) == 0);
+	CHECK(mem[9] == 0xFF && mem[310] == 0xFF);
+	CHECK(sim.get_writeCycles() == 2 + 3 * 3 + 2);
+	printf("writeBlock_P 300 bytes: %u write cycles\n", sim.get_writeCycles());
+
+	// The same again: all read, nothing written
+	sim.resetStats();
+	CHECK(ee.updateBlock_P(10, table, sizeof(table)) == 0);
+	CHECK(sim.get_writeCycles() == 0);
+
+	// One byte changed: one chunk written
+	memcpy(data, table, sizeof(data));
+	data[150] = 99;
+	sim.resetStats();
+	CHECK(ee.updateBlock(10, data, sizeof(data)) == 0);
+	CHECK(sim.get_writeCycles() == 1);
+	CHECK(sim.get_bytesWritten() <= 30);
+	CHECK(memcmp(mem + 10, data, sizeof(data)) == 0);
+
+	// Back to the table by updateBlock_P: again one chunk
+	sim.resetStats();
+	CHECK(ee.updateBlock_P(10, table, sizeof(table)) == 0);
+	CHECK(sim.get_writeCycles() == 1);
+	CHECK(memcmp(mem + 10, table, sizeof(table)) == 0);
+
+	// Fill: exactly the range, in full bus chunks
+	sim.resetStats();
+	CHECK(ee.setBlock(1000, 0xAB, 200) == 0);
+	int bad = 0;
+	for (int i=0; i<200; i++) bad += mem[1000 + i] != 0xAB;
+	CHECK(bad == 0);
+	CHECK(mem[999] == 0xFF && mem[1200] == 0xFF);
+	CHECK(sim.get_writeCycles() == 1 + 3 + 3 + 2);	// 24 + 64 + 64 + 48 bytes
+	CHECK(sim.get_bytesWritten() == 200);
+	return TEST_DONE();
+}
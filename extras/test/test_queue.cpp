@@ -0,0 +1,118 @@
+//
+//               FILE:  test_queue.cpp
+//            PURPOSE:  I2C_eepromQueue: records drained to a wrapping region, overruns, a producer thread as the ISR
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 130 byte buffer: a page per transaction)
+//---------------------------------------------------------------------------------------------------------
+//
+// Records are uint32_t counting up, so the region and pop() can be checked
+// against the stream position alone.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromQueue.h>
+#include <thread>
+#include "test.h"
+
+#define BASE		100
+#define REGION		1000
+#define RECORDS		200000UL
+
+static uint8_t	mem[32768];
+static uint8_t	ring[256];
+
+
+// Byte <k> of the record stream
+static uint8_t streamByte(const uint32_t k) {
+	uint32_t v = k / 4;
+	return ((uint8_t*)&v)[k % 4];
+}
+
+
+int main() {
+	I2C_eepromSim	sim(130);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	// Not a power of 2: rounded down; no PROM yet
+	I2C_eepromQueue	q(ring, 200);
+	CHECK(q.get_size() == 128);
+	CHECK(q.drain() == I2C_EEPROM_ERR_RANGE);
+
+	// Bursts of 5 records a round, drained in page batches round the region
+	q.attach(ee, BASE, REGION);
+	uint32_t v = 0;
+	for (int round=0; round<200; round++) {
+		for (int k=0; k<5; k++)
+			if (q.push(&v, 4)) v++;
+		CHECK(q.drain() == 0);
+	}
+	CHECK(q.drain(true) == 0);
+	CHECK(q.available() == 0);
+	CHECK(q.get_overruns() == 0);
+	CHECK(q.get_wrapped());
+
+	uint32_t total = v * 4;
+	CHECK(q.get_cursor() == total % REGION);
+	int bad = 0;
+	for (uint32_t p=0; p<REGION; p++) {
+		uint32_t k = (total - 1) - (total - 1 + REGION - p) % REGION;
+		bad += mem[BASE + p] != streamByte(k);
+	}
+	CHECK(bad == 0);
+	CHECK(mem[BASE - 1] == 0xFF && mem[BASE + REGION] == 0xFF);
+
+	// A write cycle per page filled, plus the splits at the region's ends
+	uint32_t pages = total / 64;
+	printf("%u bytes drained: %u write cycles for %u pages, ring peak %u\n", total, sim.get_writeCycles(), pages, q.get_peak());
+	CHECK(sim.get_writeCycles() <= pages + 2 * (total / REGION + 1) + 1);
+
+	// Full ring: a record is pushed whole or not at all
+	uint8_t b[128];
+	while (q.push(&v, 4)) v++;
+	CHECK(q.get_free() == 0 && q.get_overruns() == 1);
+	CHECK(q.pop(b, 2) == 2);
+	CHECK(!q.push(&v, 4));
+	CHECK(q.push((uint8_t)7) && q.push((uint8_t)8) && !q.push((uint8_t)9));
+	CHECK(q.get_overruns() == 3);
+	CHECK(q.pop(b, sizeof(b)) == 128 && b[126] == 7 && b[127] == 8);
+	CHECK(q.pop(b, sizeof(b)) == 0);
+
+	// A producer thread in place of the ISR, pop() and drain() as the consumer
+	{
+		I2C_eepromQueue	t(ring, 64);
+		uint32_t	expect = 0, x;
+		std::thread p([&] { for (uint32_t i=0; i<RECORDS; ) if (t.push(&i, 4)) i++; else std::this_thread::yield(); });
+		bad = 0;
+		while (expect < RECORDS) {
+			if (t.available() >= 4) {
+				t.pop((uint8_t*)&x, 4);
+				bad += x != expect++;
+			} else std::this_thread::yield();
+		}
+		p.join();
+		CHECK(bad == 0);
+	}
+	{
+		I2C_eepromQueue	t(ring, 256);
+		const uint32_t	n = 4000;
+		t.attach(ee, 0, n * 4);
+		std::thread p([&] { for (uint32_t i=0; i<n; ) if (t.push(&i, 4)) i++; else std::this_thread::yield(); });
+		while (t.get_cursor() < n * 4 - 64 && !t.get_wrapped()) {
+			CHECK(t.drain() == 0);
+			std::this_thread::yield();
+		}
+		p.join();
+		CHECK(t.drain(true) == 0);
+		CHECK(t.get_wrapped() && t.get_cursor() == 0);
+		bad = 0;
+		for (uint32_t k=0; k<n * 4; k++) bad += mem[k] != streamByte(k);
+		CHECK(bad == 0);
+		printf("%lu records popped, %u drained, from a producer thread\n", RECORDS, n);
+	}
+	return TEST_DONE();
+}
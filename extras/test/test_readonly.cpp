@@ -0,0 +1,70 @@
+//
+//               FILE:  test_readonly.cpp
+//            PURPOSE:  I2C_EEPROM_READONLY profile: every read path, every write call refused without touching the bus
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer); built read-only
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromAsync.h>
+#include "test.h"
+
+#if I2C_EEPROM_PROFILE != I2C_EEPROM_READONLY
+#error build with I2C_EEPROM_PROFILE=I2C_EEPROM_READONLY
+#endif
+
+static uint8_t	mem[32768], copy[32768], m1[4096];
+static uint8_t	back[4096];
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	for (uint32_t i=0; i<sizeof(mem); i++) mem[i] = i * 13 + (i >> 9);
+	memcpy(copy, mem, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.attach(0x51, m1, sizeof(m1), 2, 32);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256), other(sim, 0x51, 32);
+	ee.begin(400);
+	other.begin(400);
+
+	// Reads as in any profile
+	CHECK(ee.readBlock(1000, back, sizeof(back)) == sizeof(back));
+	CHECK(memcmp(back, mem + 1000, sizeof(back)) == 0);
+	CHECK(ee.readByte(31999) == mem[31999]);
+	I2C_eepromSeg rd[2] = { { 20000, back, 10, 0 }, { 100, back + 10, 300, 0 } };
+	CHECK(ee.readv(rd, 2) == 0);
+	CHECK(memcmp(back, mem + 20000, 10) == 0 && memcmp(back + 10, mem + 100, 300) == 0);
+	CHECK(ee.crc32(0, sizeof(mem)) == I2C_eeprom::crc32Update(0, mem, sizeof(mem)));
+
+	I2C_eepromAsync job(ee);
+	CHECK(job.startRead(5000, back, 500) == 0);
+	CHECK(job.wait() == 0);
+	CHECK(memcmp(back, mem + 5000, 500) == 0);
+
+	// Writes refused up front: nothing on the bus, nothing changed
+	I2C_eepromSeg wr[2] = { { 0, back, 10, 0 }, { 50, back, 10, 0 } };
+	I2C_eepromFile none(stdin);
+	sim.resetStats();
+	CHECK(ee.writeByte(0, 1)				== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.writeBlock(0, back, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.updateBlock(0, back, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.writeBlock_P(0, back, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.updateBlock_P(0, back, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.setBlock(0, 0, 100)				== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.copyTo(other, 0, 0, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.writeStream(none, 0, 100)			== I2C_EEPROM_ERR_READONLY);
+	CHECK(ee.writev(wr, 2) == I2C_EEPROM_ERR_READONLY && wr[0].status == I2C_EEPROM_ERR_READONLY && wr[1].status == I2C_EEPROM_ERR_READONLY);
+	CHECK(job.startWrite(0, back, 100)			== I2C_EEPROM_ERR_READONLY);
+	ee.setMirror(&other);
+	CHECK(ee.syncMirror()					== I2C_EEPROM_ERR_READONLY);
+	CHECK(sim.get_transactions() == 0);
+	CHECK(memcmp(mem, copy, sizeof(mem)) == 0);
+
+	// Status without snprintf()
+	I2C_eepromFile out(stdout);
+	ee.status(out);
+	return TEST_DONE();
+}
@@ -0,0 +1,134 @@
+//
+//               FILE:  test_remap.cpp
+//            PURPOSE:  I2C_eepromRemap: worn pages retired to spares, one-off NACKs not, the two table copies,
+//                      no silent format, nothing without a table
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromRemap.h>
+#include "test.h"
+
+#define PAGES		400
+#define SPARES		16
+
+static uint8_t	mem[32768];
+static uint8_t	img[PAGES * 64];
+static uint8_t	back[PAGES * 64];
+static uint8_t	tables[sizeof(mem)];		// both table copies
+
+
+// The simulator, NACKing the data of the next <nacks> writes: nothing programmed
+class Glitch : public I2C_eepromBus {
+public:
+    Glitch(I2C_eepromSim& sim) : nacks(0), _sim(&sim), _len(0) { }
+
+    void	begin(int speed)				{ _sim->begin(speed);				}
+    void	beginTransmission(uint8_t address)		{ _len = 0; _sim->beginTransmission(address);	}
+    size_t	write(const uint8_t* buffer, size_t length)	{ _len += length; return _sim->write(buffer, length); }
+    uint8_t	endTransmission(bool stop = true) {
+	if (stop && _len > 2 && nacks > 0) {
+		nacks--;
+		return 3;
+	}
+	return _sim->endTransmission(stop);
+    }
+    uint16_t	requestFrom(uint8_t address, uint16_t length)	{ return _sim->requestFrom(address, length);	}
+    int		available(void)					{ return _sim->available();			}
+    int		read(void)					{ return _sim->read();				}
+    uint16_t	get_bufferSize(void)				{ return _sim->get_bufferSize();		}
+
+    int		nacks;
+
+private:
+    I2C_eepromSim* _sim;
+    size_t	_len;
+};
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	// Blank PROM: no table, nothing formatted unasked, nothing written or read
+	I2C_eepromRemap	rm(ee, 0, PAGES, SPARES);
+	CHECK(rm.write(0, img, 10) == I2C_EEPROM_ERR_CRC && rm.read(0, back, 10) == 0);
+	CHECK(rm.begin() == I2C_EEPROM_ERR_CRC);
+	CHECK(rm.write(0, img, 10) == I2C_EEPROM_ERR_CRC && rm.save() == I2C_EEPROM_ERR_CRC);
+	CHECK(mem[0] == 0xFF);
+	CHECK(rm.format() == 0);
+	CHECK(rm.get_size() == PAGES * 64UL);
+
+	uint32_t table = rm.get_tablePages() / 2 * 64;		// bytes per copy
+	uint32_t data  = 2 * table;
+
+	// Worn cells in data page 5 and in the first spare: page 5 moves twice
+	for (uint32_t i=0; i<sizeof(img); i++) img[i] = i * 7 + 1;
+	sim.stuck(0x50, data + 5 * 64 + 10, 0xFF);
+	sim.stuck(0x50, data + PAGES * 64 + 3, 0xFF);
+	CHECK(rm.write(0, img, sizeof(img)) == 0);
+	CHECK(rm.get_retired() == 2);
+	CHECK(rm.get_sparesLeft() == SPARES - 2);
+	CHECK(rm.get_physical(5) == PAGES + 1);
+	CHECK(rm.read(0, back, sizeof(back)) == sizeof(back));
+	CHECK(memcmp(back, img, sizeof(img)) == 0);
+
+	// One NACK: written again, nothing retired; a page failing twice is
+	Glitch		glitch(sim);
+	I2C_eeprom	eg(glitch, 0x50, 256);
+	I2C_eepromRemap	rg(eg, 0, PAGES, SPARES);
+	eg.begin(400);
+	CHECK(rg.begin() == 0);
+	glitch.nacks = 1;
+	CHECK(rg.write(10 * 64 + 5, img, 20) == 0);
+	CHECK(glitch.nacks == 0 && rg.get_retired() == 2 && rg.get_physical(10) == 10);
+	glitch.nacks = I2C_EEPROM_REMAP_TRIES;
+	CHECK(rg.write(11 * 64 + 5, img, 20) == 0);
+	CHECK(rg.get_retired() == 3 && rg.get_physical(11) == PAGES + 2);
+	memcpy(img + 10 * 64 + 5, img, 20);
+	memcpy(img + 11 * 64 + 5, img, 20);
+	CHECK(rm.begin() == 0 && rm.read(0, back, sizeof(back)) == sizeof(back));
+	CHECK(memcmp(back, img, sizeof(img)) == 0);
+
+	// Copy A torn: B holds the table, and A is rewritten from it
+	mem[20] ^= 0x40;
+	{
+		I2C_eepromRemap	r(ee, 0, PAGES, SPARES);
+		CHECK(r.begin() == 0);
+		CHECK(r.get_physical(5) == PAGES + 1);
+		CHECK(r.read(0, back, sizeof(back)) == sizeof(back));
+		CHECK(memcmp(back, img, sizeof(img)) == 0);
+		CHECK(memcmp(mem, mem + table, table) == 0);
+	}
+
+	// Both torn: an error, the tables left as they are for the caller
+	mem[20] ^= 0x40;
+	mem[table + 20] ^= 0x40;
+	memcpy(tables, mem, data);
+	{
+		I2C_eepromRemap	r(ee, 0, PAGES, SPARES);
+		CHECK(r.begin() == I2C_EEPROM_ERR_CRC);
+	}
+	CHECK(memcmp(tables, mem, data) == 0);
+	mem[20] ^= 0x40;
+	mem[table + 20] ^= 0x40;
+
+	// Copy A worn: save() reports it, copy B still takes the counts
+	sim.stuck(0x50, 0, 0x01);
+	CHECK(rm.write(5 * 64 + 1, img, 20) == 0);
+	CHECK(rm.save() == I2C_EEPROM_ERR_VERIFY);
+	{
+		I2C_eepromRemap	r(ee, 0, PAGES, SPARES);
+		CHECK(r.begin() == 0);
+		CHECK(r.get_physical(5) == PAGES + 1);
+		CHECK(r.get_writes(5) == 2);
+	}
+	return TEST_DONE();
+}
@@ -0,0 +1,80 @@
+//
+//               FILE:  test_replay.cpp
+//            PURPOSE:  Call capture of a sketch and its replay on the simulator, timed and untimed
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz); built with I2C_EEPROM_CAPTURE
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromReplay.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+#define LOOPS		200
+
+static uint8_t	mem[32768];
+
+
+int main() {
+	I2C_eepromSim::useVirtualClock();
+	FILE*		f = tmpfile();
+	I2C_eepromFile	log(f), out(stdout);
+	uint32_t	cycles;
+
+	// The "sketch": its own output between the captured lines
+	{
+		I2C_eepromSim	sim;
+		I2C_eeprom	ee(sim, 0x50, 256);
+		uint8_t		b[100];
+
+		memset(b, 0x5A, sizeof(b));
+		sim.attach(0x50, mem, sizeof(mem), 2, 64);
+		ee.begin(400);
+
+		I2C_eepromCapture::begin(log);
+		log.print("sketch output\n");
+		for (int i=0; i<LOOPS; i++) {
+			ee.writeBlock((i * 37) % 30000, b, 1 + i % 100);
+			ee.readBlock((i * 91) % 30000, b, 50);
+			ee.readByte(i);
+			if (i % 10 == 0) ee.updateBlock(i * 64, b, 64);
+			delay(2);
+		}
+		log.print("#EE W 0x57 0 10 0\n");		// no PROM of the replay
+		I2C_eepromCapture::end();
+		cycles = sim.get_writeCycles();
+	}
+	fflush(f);
+
+	// Replay: every call again, the write cycles with it
+	uint32_t writeP99[2];
+	for (int timed=0; timed<2; timed++) {
+		static uint8_t	mem2[32768];
+		I2C_eepromSim	sim;
+		I2C_eeprom	ee(sim, 0x50, 256);
+		I2C_eepromReplay rp(sim);
+
+		rewind(f);
+		memset(mem2, 0xFF, sizeof(mem2));
+		sim.attach(0x50, mem2, sizeof(mem2), 2, 64);
+		ee.begin(400);
+		CHECK(rp.attach(ee));
+
+		CHECK(rp.run(log, timed) == 3 * LOOPS + LOOPS / 10);
+		CHECK(rp.get_calls('W') == LOOPS);
+		CHECK(rp.get_calls('R') == LOOPS);
+		CHECK(rp.get_calls('r') == LOOPS);
+		CHECK(rp.get_calls('U') == LOOPS / 10);
+		CHECK(rp.get_skipped() == 1);
+		CHECK(sim.get_writeCycles() == cycles);
+		CHECK(rp.get_latency('W', 50) <= rp.get_latency('W', 99));
+		writeP99[timed] = rp.get_latency('W', 99);
+
+		printf("%s:\n", timed ? "timed" : "untimed");
+		rp.report(out);
+	}
+
+	// Kept gaps: write cycles end in them, writes wait less
+	CHECK(writeP99[1] <= writeP99[0]);
+	fclose(f);
+	return TEST_DONE();
+}
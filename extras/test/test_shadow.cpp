@@ -0,0 +1,70 @@
+//
+//               FILE:  test_shadow.cpp
+//            PURPOSE:  I2C_eepromShadow: load, pages written per sync(), touch(), a PROM of unknown type
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromShadow.h>
+#include "test.h"
+
+static uint8_t	mem[32768];
+static uint8_t	cfg[1000];
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	// 1000 bytes @ 100: 17 pages of 64, the first and last in part
+	for (int i=0; i<1000; i++) mem[100 + i] = i * 3;
+	I2C_eepromShadow sh(ee, 100, cfg, sizeof(cfg));
+	CHECK(sh.begin() == 0);
+	CHECK(sh.get_pages() == 17);
+	CHECK(memcmp(cfg, mem + 100, sizeof(cfg)) == 0);
+	CHECK(!sh.dirty());
+
+	// Three changes in three pages: those written, nothing read
+	cfg[0] = 1;
+	cfg[500] = 2;
+	cfg[999] = 3;
+	CHECK(sh.dirty());
+	sim.resetStats();
+	CHECK(sh.sync() == 0);
+	CHECK(sh.get_written() == 3);
+	CHECK(sim.get_bytesRead() == 0);
+	CHECK(memcmp(cfg, mem + 100, sizeof(cfg)) == 0);
+
+	CHECK(sh.sync() == 0);
+	CHECK(sh.get_written() == 0);
+
+	// touch(): across a page boundary (offset 27 = PROM 127)
+	sh.touch(27, 2);
+	CHECK(sh.sync() == 0);
+	CHECK(sh.get_written() == 2);
+
+	uint32_t t = I2C_eepromSim::now();
+	cfg[10] = 9;
+	CHECK(sh.sync() == 0);
+	uint32_t one = I2C_eepromSim::now() - t;
+	t = I2C_eepromSim::now();
+	CHECK(ee.writeBlock(100, cfg, sizeof(cfg)) == 0);
+	uint32_t all = I2C_eepromSim::now() - t;
+	printf("one change: %6.1f ms, whole region: %6.1f ms\n", one / 1000.0, all / 1000.0);
+
+	// Unknown type, no page size: no pages instead of a divide by zero
+	I2C_eeprom	unknown(sim, 0x50, 0);
+	unknown.begin(400);
+	I2C_eepromShadow none(unknown, 0, cfg, 100);
+	CHECK(none.begin() == I2C_EEPROM_ERR_RANGE);
+	CHECK(none.get_pages() == 0);
+	none.touch(0, 10);
+	CHECK(!none.dirty());
+	return TEST_DONE();
+}
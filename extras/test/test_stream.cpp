@@ -0,0 +1,145 @@
+//
+//               FILE:  test_stream.cpp
+//            PURPOSE:  writeStream(): an image over a 115200 baud link, both flow modes, CRC-32 and timing;
+//                      a page a chunk on a large bus buffer (writeStream(), copyTo(), crc32())
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, 32 byte Wire buffer; 24xx512, 4096 byte buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// The link hands out a byte once model time has reached its arrival; a
+// look at an empty link lets 1 us pass, as a polling loop does. With
+// I2C_EEPROM_FLOW_ACK the sender follows I2C_eeprom-flash.ino: one chunk,
+// then it waits for the ACK.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+#define LENGTH		4096
+#define BYTE_NS		86806		// 10 bits @ 115200 baud
+
+static uint8_t	mem[32768], m0[65536], m1[65536];
+static uint8_t	img[LENGTH];
+
+
+class Link : public Stream {
+public:
+    Link(const uint8_t* data, const uint32_t length, const bool ack, const uint16_t page, const uint16_t at) {
+	_data	= data;
+	_at	= at;
+	_length	= length;
+	_ack	= ack;
+	_page	= page;
+	_sent	= 0;
+	_acks	= 0;
+	_chunk(I2C_eepromSim::now());
+    }
+
+    int		available(void)	{ return _ready() ? 1 : 0; }
+    int		peek(void)	{ return _ready() ? _data[_sent] : -1; }
+    int		read(void) {
+	if (!_ready()) {
+		I2C_eepromSim::advance(1);
+		return -1;
+	}
+	_sent++;
+	return _data[_sent - 1];
+    }
+    size_t	write(uint8_t c) {
+	if (c == I2C_EEPROM_ACK && _ack) {
+		_acks++;
+		_chunk(I2C_eepromSim::now());
+	}
+	return 1;
+    }
+
+    uint32_t	get_acks(void)	{ return _acks; }
+
+private:
+    const uint8_t* _data;
+    uint32_t	_length;
+    bool	_ack;
+    uint16_t	_page;
+    uint16_t	_at;		// PROM address of byte 0 ... chunks follow its pages
+    uint32_t	_sent;
+    uint32_t	_end;		// bytes on their way
+    uint64_t	_startNs;	// byte _first arrives BYTE_NS after
+    uint32_t	_first;
+    uint32_t	_acks;
+
+    // Next chunk from <us> on ... without flow control the whole image
+    void	_chunk(const uint32_t us) {
+	_startNs = us * 1000ULL;
+	_first	 = _sent;
+	_end	 = _ack ? _sent + min(min(_page - (_at + _sent) % _page, I2C_TWIBUFFERSIZE), _length - _sent) : _length;
+    }
+    bool	_ready(void) {
+	return _sent < _length && _sent < _end && I2C_eepromSim::now() * 1000ULL >= _startNs + (_sent - _first + 1) * (uint64_t)BYTE_NS;
+    }
+};
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	ee.begin(400);
+
+	for (uint32_t i=0; i<LENGTH; i++) img[i] = rand();
+	uint32_t crcImg = I2C_eeprom::crc32Update(0, img, LENGTH);
+
+	// Received first, then written: the time writeStream() saves on
+	uint32_t t = I2C_eepromSim::now();
+	CHECK(ee.writeBlock(100, img, LENGTH) == 0);
+	uint32_t block = I2C_eepromSim::now() - t + (uint32_t)((uint64_t)LENGTH * BYTE_NS / 1000);
+	printf("receive, then writeBlock: %7.1f ms\n", block / 1000.0);
+	memset(mem, 0xFF, sizeof(mem));
+
+	for (int ack=0; ack<=1; ack++) {
+		Link		link(img, LENGTH, ack, ee.get_pageSize(), 100);
+		uint32_t	crc = 0;
+
+		sim.resetStats();
+		t = I2C_eepromSim::now();
+		int rv = ee.writeStream(link, 100, LENGTH, ack ? I2C_EEPROM_FLOW_ACK : I2C_EEPROM_FLOW_NONE, &crc);
+		t = I2C_eepromSim::now() - t;
+
+		CHECK(rv == 0);
+		CHECK(crc == crcImg);
+		CHECK(ee.crc32(100, LENGTH) == crcImg);
+		CHECK(memcmp(mem + 100, img, LENGTH) == 0);
+		CHECK(t < block);
+		if (ack) CHECK(link.get_acks() == sim.get_writeCycles());
+		printf("writeStream, %-4s flow: %7.1f ms\n", ack ? "ACK" : "no", t / 1000.0);
+		memset(mem, 0xFF, sizeof(mem));
+	}
+
+	// Short image: times out; past the end: range
+	Link	cut(img, 1000, false, 64, 0);
+	CHECK(ee.writeStream(cut, 0, 2000) == I2C_EEPROM_ERR_READ);
+	CHECK(ee.writeStream(cut, 32000, 1000) == I2C_EEPROM_ERR_RANGE);
+
+	// i2c-dev alike: one write cycle, one read a 128 byte page
+	I2C_eepromSim	big(4096);
+	big.attach(0x50, m0, sizeof(m0), 2, 128);
+	big.attach(0x51, m1, sizeof(m1), 2, 128);
+	I2C_eeprom	e0(big, 0x50, 512), e1(big, 0x51, 512);
+	I2C_eepromCopyStat stat;
+	e0.begin(400);
+	e1.begin(400);
+
+	Link	fast(img, 1024, false, 128, 0);
+	big.resetStats();
+	CHECK(e0.writeStream(fast, 0, 1024) == 0);
+	CHECK(big.get_writeCycles() == 8);
+	big.resetStats();
+	CHECK(e0.crc32(0, 1024) == I2C_eeprom::crc32Update(0, img, 1024));
+	CHECK(big.get_transactions() == 2 * 8);			// address, then data
+	big.resetStats();
+	CHECK(e0.copyTo(e1, 0, 0, 1024, &stat) == 0);
+	CHECK(stat.written == 8 && big.get_writeCycles() == 8);
+	CHECK(memcmp(m1, img, 1024) == 0);
+	return TEST_DONE();
+}
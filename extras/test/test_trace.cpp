@@ -0,0 +1,117 @@
+//
+//               FILE:  test_trace.cpp
+//            PURPOSE:  I2C_eepromTrace: records of a session, dump()/load(), records from several tasks
+//           Platform:  Linux host, I2C_eepromSim; built with I2C_EEPROM_TRACE and I2C_EEPROM_THREADSAFE
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromTrace.h>
+#include <pthread.h>
+#include "test.h"
+
+#define WRITERS		3
+#define RECORDS		200000		// per writer
+
+static uint8_t		mem[32768];
+static volatile bool	writing;
+
+
+//
+// Records whose fields belong together ... a torn one shows
+//
+static void* writer(void* arg) {
+uint8_t id = (uintptr_t)arg;
+
+	for (uint32_t k=0; k<RECORDS; k++) {
+		uint16_t a = k;
+		I2C_eepromTrace::record(id, id, a, a ^ 0x5A5A, a * 3UL, id);
+	}
+	return NULL;
+}
+
+static void* reader(void* arg) {
+I2C_eepromTraceRec	r;
+uint32_t*		torn = (uint32_t*)arg;
+
+	while (writing)
+		for (uint16_t i=0; i<I2C_EEPROM_TRACE_SIZE; i++)
+			if (I2C_eepromTrace::get(i, &r))
+				if (r.device != r.type || r.result != r.type || r.length != (r.address ^ 0x5A5A) || r.start != r.address * 3UL)
+					(*torn)++;
+	return NULL;
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 256);
+	I2C_eeprom	ghost(sim, 0x57, 256);
+	uint8_t		buf[200];
+	ee.begin(400);
+
+	// A session: every transaction a record, the NACK of the missing PROM too
+	I2C_eepromTrace::clear();
+	for (int i=0; i<200; i++) buf[i] = i;
+	CHECK(ee.writeBlock(10, buf, 200) == 0);
+	CHECK(ee.readBlock(10, buf, 100) == 100);
+	CHECK(ghost.readBlock(0, buf, 10) != 10);
+
+	uint32_t total = I2C_eepromTrace::get_total();
+	uint16_t count = I2C_eepromTrace::get_count();
+	CHECK(total > 8);
+	CHECK(count == min(total, (uint32_t)I2C_EEPROM_TRACE_SIZE));
+
+	I2C_eepromTraceRec last, back;
+	CHECK(I2C_eepromTrace::get(count - 1, &last));
+	CHECK(last.device == 0x57 && last.result != 0);
+
+	// dump() and load() give the same ring
+	FILE* f = tmpfile();
+	I2C_eepromFile out(f);
+	I2C_eepromTrace::dump(out);
+	rewind(f);
+	I2C_eepromTrace::clear();
+	I2C_eepromFile in(f);
+	CHECK(I2C_eepromTrace::load(in));
+	fclose(f);
+	CHECK(I2C_eepromTrace::get_count() == count);
+	CHECK(I2C_eepromTrace::get(count - 1, &back) && memcmp(&back, &last, sizeof(last)) == 0);
+
+	// A dump of 3 records out of 1000: 3 in the ring, the session's total kept
+	static const uint8_t head[12] = { 'I', '2', 'C', 'T', 1, I2C_EEPROM_TRACE_RECORD, 3, 0, 0xE8, 0x03, 0, 0 };
+	f = tmpfile();
+	fwrite(head, 1, sizeof(head), f);
+	for (int i=0; i<3; i++) {
+		uint8_t rec[I2C_EEPROM_TRACE_RECORD] = { 1, 0x50, 0 };
+		rec[3] = i;
+		fwrite(rec, 1, sizeof(rec), f);
+	}
+	rewind(f);
+	I2C_eepromFile	in3(f);
+	CHECK(I2C_eepromTrace::load(in3));
+	fclose(f);
+	CHECK(I2C_eepromTrace::get_count() == 3 && I2C_eepromTrace::get_total() == 1000);
+	CHECK(I2C_eepromTrace::get(2, &back) && back.address == 2 && !I2C_eepromTrace::get(3, &back));
+
+	// Writers and a reader at once: no record seen half written
+	pthread_t	w[WRITERS], r;
+	uint32_t	torn = 0;
+
+	I2C_eepromTrace::clear();
+	writing = true;
+	pthread_create(&r, NULL, reader, &torn);
+	for (uintptr_t i=0; i<WRITERS; i++) pthread_create(&w[i], NULL, writer, (void*)(i + 1));
+	for (int i=0; i<WRITERS; i++) pthread_join(w[i], NULL);
+	writing = false;
+	pthread_join(r, NULL);
+
+	CHECK(torn == 0);
+	CHECK(I2C_eepromTrace::get_total() == (uint32_t)WRITERS * RECORDS);
+	printf("%u records from %u tasks, %u torn\n", I2C_eepromTrace::get_total(), WRITERS, torn);
+	return TEST_DONE();
+}
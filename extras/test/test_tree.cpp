@@ -0,0 +1,133 @@
+//
+//               FILE:  test_tree.cpp
+//            PURPOSE:  I2C_eepromTree: lookups and page reads per level, seek() and range scans against the source, duplicates
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz, 32 byte Wire buffer)
+//---------------------------------------------------------------------------------------------------------
+//
+// Records: 4 byte big endian key rising with <i> (divided by 8: runs of duplicate
+// keys), 4 byte value <i>.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromTree.h>
+#include "test.h"
+
+#define PAGES		512		// whole PROM
+
+static uint8_t	mem[65536];
+
+
+static uint32_t keyOf(const uint32_t i, const bool dup) {
+	uint32_t k = i * 3 + i / 7;
+	return dup ? k / 8 : k;
+}
+
+static void source(void* ctx, const uint32_t i, uint8_t* rec) {
+	uint32_t k = keyOf(i, ctx != NULL);
+
+	rec[0] = k >> 24;
+	rec[1] = k >> 16;
+	rec[2] = k >> 8;
+	rec[3] = k;
+	memcpy(rec + 4, &i, 4);
+}
+
+
+// Keys falling back once, half way
+static void unsorted(void* ctx, const uint32_t i, uint8_t* rec) {
+	source(ctx, i == 3500 ? 0 : i, rec);
+}
+
+
+//
+// seek() to random keys: the scan from there is the source from the first
+// record >= key to the end
+//
+static int scans(I2C_eepromTree& t, const uint32_t n, void* ctx) {
+	uint8_t	rec[8], got[8], key[4];
+	int	bad = 0;
+
+	for (int q=0; q<100; q++) {
+		uint32_t k = rand() % (keyOf(n, ctx != NULL) + 5);
+		uint32_t e = 0;
+
+		key[0] = k >> 24; key[1] = k >> 16; key[2] = k >> 8; key[3] = k;
+		while (e < n) {
+			source(ctx, e, rec);
+			if (memcmp(rec, key, 4) >= 0) break;
+			e++;
+		}
+		if (t.seek(key) != (e < n)) {
+			bad++;
+			continue;
+		}
+		for (; e < n; e++) {
+			source(ctx, e, rec);
+			if (!t.next(got) || memcmp(got, rec, 8) != 0) break;
+		}
+		if (e != n || t.next(got)) bad++;
+	}
+	return bad;
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 512);
+	ee.begin(400);
+
+	I2C_eepromTree	t(ee, 0, PAGES);
+	CHECK(t.begin() == I2C_EEPROM_ERR_VERIFY);
+
+	// From one leaf to three levels; with and without duplicates
+	static const uint32_t counts[]	= { 1, 20, 500, 7000 };
+	static const uint8_t  levels[]	= { 1, 2, 3, 3 };
+	for (unsigned c=0; c<sizeof(counts)/sizeof(counts[0]); c++) {
+		for (int dup=0; dup<2; dup++) {
+			uint32_t n   = counts[c];
+			void*	 ctx = dup ? (void*)1 : NULL;
+			uint8_t	 rec[8], val[4];
+			int	 bad = 0;
+
+			CHECK(t.build(4, 4, n, source, ctx) == 0);
+			I2C_eepromTree r(ee, 0, PAGES);
+			CHECK(r.begin() == 0);
+			CHECK(r.get_entries() == n && r.get_levels() == levels[c]);
+
+			uint32_t reads = r.get_pageReads();
+			for (uint32_t i=0; i<n; i++) {
+				source(ctx, i, rec);
+				if (!r.find(rec, val) || (!dup && memcmp(val, rec + 4, 4) != 0)) bad++;
+			}
+			reads = r.get_pageReads() - reads;
+			CHECK(reads == n * r.get_levels());
+			CHECK(bad == 0);
+			CHECK(scans(r, n, ctx) == 0);
+
+			// Between keys and past the end: not found
+			if (!dup && n > 1) {
+				uint8_t miss[4] = { 0, 0, 0, 1 };
+				CHECK(!r.find(miss));
+				memset(miss, 0xFF, 4);
+				CHECK(!r.find(miss) && !r.seek(miss));
+			}
+			if (dup && c == 3)
+				printf("%u records, %u nodes: %u levels, %u page reads per lookup\n", n, r.get_nodes(), r.get_levels(), reads / n);
+		}
+	}
+
+	// More leaves and nodes than pages: refused up front, the old tree kept
+	CHECK(t.build(4, 4, 7500, source, (void*)1) == I2C_EEPROM_ERR_RANGE);
+	I2C_eepromTree	r(ee, 0, PAGES);
+	CHECK(r.begin() == 0 && r.get_entries() == 7000);
+
+	// Records out of order: found while writing, no tree left behind
+	CHECK(t.build(4, 4, 7000, unsorted, NULL) == I2C_EEPROM_ERR_RANGE);
+	CHECK(r.begin() == I2C_EEPROM_ERR_VERIFY);
+	return TEST_DONE();
+}
@@ -0,0 +1,110 @@
+//
+//               FILE:  test_ts.cpp
+//            PURPOSE:  I2C_eepromTS: range queries against a full scan, reads per seek(), reopen, ring wrap
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+// Samples: 4 data bytes, times rising by 3 with every 5th repeated.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromTS.h>
+#include "test.h"
+
+#define QUERIES		200
+
+static uint8_t	mem[65536];
+
+
+//
+// Samples in [from, to]: by seek() and by a scan from the oldest; the first
+// query pass counts the index reads of seek()
+//
+static void queries(I2C_eepromTS& ts, const uint32_t last, uint32_t* seekReads) {
+	uint32_t t, v;
+	int	 bad = 0;
+
+	*seekReads = 0;
+	for (int q=0; q<QUERIES; q++) {
+		uint32_t from = rand() % (last + 100);
+		uint32_t to   = from + rand() % 2000;
+		uint32_t all = 0, some = 0, prev = 0;
+
+		ts.seek(0);
+		while (ts.next(&t, (uint8_t*)&v))
+			if (t >= from && t <= to) all++;
+
+		uint32_t reads = ts.get_pageReads();
+		ts.seek(from);
+		*seekReads += ts.get_pageReads() - reads;
+		while (ts.next(&t, (uint8_t*)&v) && t <= to) {
+			if (t < from || t < prev || v != t * 7) bad++;
+			prev = t;
+			some++;
+		}
+		if (some != all) bad++;
+	}
+	CHECK(bad == 0);
+}
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	memset(mem, 0xFF, sizeof(mem));
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	sim.useVirtualClock();
+
+	I2C_eeprom	ee(sim, 0x50, 512);
+	ee.begin(400);
+
+	I2C_eepromTS	ts(ee, 0, 512, 4);
+	CHECK(ts.begin() == 0);
+	CHECK(ts.get_blocks() == 496);
+	CHECK(ts.get_perBlock() == 16);
+
+	// Part full, flushed and reopened
+	uint32_t T = 1000, v, reads;
+	for (int i=0; i<7000; i++) {
+		T += (i % 5 == 0) ? 0 : 3;
+		v = T * 7;
+		CHECK(ts.append(T, (uint8_t*)&v) == 0);
+	}
+	CHECK(ts.flush() == 0);
+	{
+		I2C_eepromTS r(ee, 0, 512, 4);
+		CHECK(r.begin() == 0);
+		CHECK(r.get_blocksUsed() == ts.get_blocksUsed());
+		queries(r, T, &reads);
+	}
+
+	// Wrapped: the oldest blocks dropped, the ring full
+	for (int i=0; i<5000; i++) {
+		T += (i % 5 == 0) ? 0 : 3;
+		v = T * 7;
+		CHECK(ts.append(T, (uint8_t*)&v) == 0);
+	}
+	queries(ts, T, &reads);
+	printf("%u blocks: %.1f index reads per seek()\n", ts.get_blocks(), reads / (double)QUERIES);
+	CHECK(reads <= QUERIES * 9UL);
+
+	uint32_t t, n = 0, prev = 0;
+	ts.seek(0);
+	while (ts.next(&t, (uint8_t*)&v)) {
+		CHECK(t >= prev);
+		prev = t;
+		n++;
+	}
+	CHECK(n == (ts.get_blocks() - 1UL) * ts.get_perBlock());
+	CHECK(prev == T);
+
+	CHECK(ts.flush() == 0);
+	I2C_eepromTS	r(ee, 0, 512, 4);
+	CHECK(r.begin() == 0);
+	n = 0;
+	r.seek(0);
+	while (r.next(&t, (uint8_t*)&v)) n++;
+	CHECK(n == (ts.get_blocks() - 1UL) * ts.get_perBlock());
+	printf("%u samples kept of 12000, after a reopen too\n", n);
+	return TEST_DONE();
+}
@@ -0,0 +1,213 @@
+//
+//               FILE:  test_twi.cpp
+//            PURPOSE:  I2C_eepromTWI: its interrupt steps against a model of the TWI, background transfer, NACK, hung bus
+//           Platform:  Linux host, model/ TWI registers on I2C_eepromSim (24xx256, 400 kHz); built as AVR with I2C_EEPROM_TWI
+//---------------------------------------------------------------------------------------------------------
+//
+// The model does what the TWI does on a write of TWCR with TWINT: START, one
+// byte out or in, STOP; the PROM side is the simulator. The step is done, TWSR
+// set and TWI_vect called on the next micros() after it, the CPU's time
+// passing a microsecond per call, so that a transfer only moves on while the
+// caller waits or works.
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromAsync.h>
+#include <I2C_eepromTWI.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+#include "test.h"
+
+#if !defined(__AVR__) || !defined(I2C_EEPROM_TWI)
+#error build with __AVR__ and I2C_EEPROM_TWI, model/ on the include path
+#endif
+
+static uint8_t	mem[32768];
+static uint8_t	data[4096], back[4096];
+
+
+//
+// The TWI ... one step pending at a time
+//
+I2C_eepromTWCR		TWCR;
+volatile uint8_t	TWDR, TWSR, TWBR, SREG = 0x80;
+
+extern "C" void TWI_vect(void);
+
+static I2C_eepromSim*	bus;
+static uint8_t	cr;			// TWCR as written, without TWINT
+static bool	flag;			// TWINT: step done
+static bool	pending;		// step to do
+static bool	hang;			// no step done: the bus hangs
+static bool	open, addressNext, reading;
+static uint8_t	sla, tx[64], txLen;
+
+static void stop() {
+	if (open && !reading && txLen > 0) {
+		bus->beginTransmission(sla >> 1);
+		bus->write(tx, txLen);
+		bus->endTransmission();
+	}
+	open	= false;
+	reading	= false;
+}
+
+static void step() {
+uint8_t st;
+
+	if (!pending || hang || !(SREG & 0x80)) return;
+	pending = false;
+
+	if (cr & _BV(TWSTA)) {
+		if (open && !reading && txLen > 0) {		// address words, then read
+			bus->beginTransmission(sla >> 1);
+			bus->write(tx, txLen);
+			bus->endTransmission(false);
+		}
+		st		= open ? TW_REP_START : TW_START;
+		open		= true;
+		reading		= false;
+		addressNext	= true;
+		txLen		= 0;
+	} else if (addressNext) {
+		addressNext	= false;
+		sla		= TWDR;
+		if (sla & TW_READ) {
+			reading = true;
+			st = bus->requestFrom(sla >> 1, 255) > 0 ? TW_MR_SLA_ACK : TW_MR_SLA_NACK;
+		} else {
+			bus->beginTransmission(sla >> 1);
+			st = bus->endTransmission() == 0 ? TW_MT_SLA_ACK : TW_MT_SLA_NACK;
+		}
+	} else if (!reading) {
+		tx[txLen++] = TWDR;
+		st = TW_MT_DATA_ACK;
+	} else {
+		TWDR = bus->read();
+		st = (cr & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+	}
+	TWSR = st;
+	flag = true;
+	if (cr & _BV(TWIE)) TWI_vect();
+}
+
+I2C_eepromTWCR& I2C_eepromTWCR::operator=(const uint8_t v) {
+	cr = v & ~_BV(TWINT);
+	if (!(v & _BV(TWINT))) {			// reset, or released
+		open	= false;
+		pending	= false;
+		return *this;
+	}
+	flag = false;
+	if (v & _BV(TWSTO)) {				// out at once, no interrupt
+		stop();
+		cr &= ~_BV(TWSTO);
+	} else {
+		pending = true;
+	}
+	return *this;
+}
+
+I2C_eepromTWCR::operator uint8_t() const {
+	return cr | (flag ? _BV(TWINT) : 0);
+}
+
+
+// The CPU's clock: interrupt first, a microsecond a call
+static uint32_t cpuNow() {
+static bool inStep = false;
+
+	if (!inStep) {
+		inStep = true;
+		step();
+		inStep = false;
+	}
+	I2C_eepromSim::advance(1);
+	return I2C_eepromSim::now();
+}
+
+static void cpuSleep(uint32_t us) {
+	I2C_eepromSim::advance(us);
+	step();
+}
+
+static const I2C_eepromClock_t cpuClock = { cpuNow, cpuSleep };
+
+
+int main() {
+	I2C_eepromSim	sim(32);
+	bus = &sim;
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+	sim.useVirtualClock();
+	sim.begin(400);
+	I2C_eepromHost_setClock(&cpuClock);
+	for (unsigned i=0; i<sizeof(data); i++) data[i] = i * 7 + 3;
+
+	// Clock as Wire's at 400 kHz from 16 MHz
+	I2C_eepromTWI	twi;
+	twi.begin(400);
+	CHECK(TWBR == 12 && TWSR == 0 && TWCR == _BV(TWEN));
+	CHECK(twi.get_background() && twi.get_bufferSize() == I2C_EEPROM_TWI_BUFFER);
+
+	// startTransfer() returns with the START on its way; the interrupt does the rest
+	volatile uint8_t status;
+	uint8_t		 frame[2 + 20] = { 0, 100 };
+	int		 calls = 0;
+	memcpy(frame + 2, data, 20);
+	twi.startTransfer(0x50, frame, sizeof(frame), NULL, 0, &status);
+	CHECK(status == I2C_EEPROM_BUS_PENDING && mem[100] == 0);
+	while (status == I2C_EEPROM_BUS_PENDING && calls < 1000) {
+		micros();
+		calls++;
+	}
+	CHECK(status == 0 && calls == 1 + 22 + 1);		// START, SLA+W, 22 bytes
+	CHECK(memcmp(mem + 100, data, 20) == 0);
+
+	// In its write cycle the PROM NACKs its address; then a read after a repeated START
+	twi.startTransfer(0x50, frame, 2, back, 20, &status);
+	while (status == I2C_EEPROM_BUS_PENDING) micros();
+	CHECK(status == 2);
+	delay(5);
+	twi.startTransfer(0x50, frame, 2, back, 20, &status);
+	while (status == I2C_EEPROM_BUS_PENDING) micros();
+	CHECK(status == 0 && memcmp(back, data, 20) == 0);
+
+	// The library on it: Wire-style calls, each waited for
+	I2C_eeprom	ee(twi, 0x50, 256);
+	ee.begin(400);
+	CHECK(ee.writeBlock(1000, data, sizeof(data)) == 0);
+	CHECK(memcmp(mem + 1000, data, sizeof(data)) == 0);
+	CHECK(ee.readBlock(1000, back, sizeof(back)) == sizeof(back));
+	CHECK(memcmp(back, data, sizeof(back)) == 0);
+	CHECK(ee.writeByte(7, 0xA5) == 0 && ee.readByte(7) == 0xA5);
+
+	// Nobody at the address
+	I2C_eeprom	none(twi, 0x53, 256);
+	none.begin(400);
+	CHECK(none.readBlock(0, back, 10) == 0);
+	CHECK(none.writeByte(0, 1) != 0);
+
+	// A job: moved on by the interrupt while loop() works, poll() only hands over
+	I2C_eepromAsync	job(ee);
+	int		polls = 0;
+	memset(back, 0, sizeof(back));
+	CHECK(job.startRead(1000, back, sizeof(back)) == 0);
+	while (job.poll()) {
+		for (int i=0; i<100; i++) micros();
+		polls++;
+	}
+	CHECK(job.result() == 0 && memcmp(back, data, sizeof(back)) == 0);
+	printf("4096 bytes read by a job in %d polls\n", polls);
+
+	// A hung bus: reset after I2C_EEPROM_TIMEOUT, usable again
+	hang = true;
+	uint32_t t = millis();
+	twi.beginTransmission(0x50);
+	twi.write(frame, 2);
+	CHECK(twi.endTransmission() == 4);
+	CHECK(millis() - t >= I2C_EEPROM_TIMEOUT && TWCR == _BV(TWEN));
+	hang = false;
+	CHECK(ee.readBlock(1000, back, 100) == 100 && memcmp(back, data, 100) == 0);
+	return TEST_DONE();
+}
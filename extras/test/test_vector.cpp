@@ -0,0 +1,120 @@
+//
+//               FILE:  test_vector.cpp
+//            PURPOSE:  writev()/readv(): scattered records against a reference image, write cycles saved
+//           Platform:  Linux host, I2C_eepromSim (24LC512, 400 kHz)
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include "test.h"
+
+#define ROUNDS		300
+#define SEGS		20		// more than I2C_EEPROM_SEGMAX
+
+static uint8_t	mem[65536];
+static uint8_t	ref[65536];
+static uint8_t	bufs[SEGS][300];
+static uint8_t	back[SEGS][300];
+
+
+//
+// 16 records of 6 bytes in 2 pages, given in falling order: writev() and
+// 16 writeBlock() calls
+//
+static void records(const uint16_t bufferSize) {
+	I2C_eepromSim	sim(bufferSize);
+	I2C_eeprom	ee(sim, 0x50, 512);
+	I2C_eepromSeg	s[16], q[16];
+	uint8_t		d[16][6], r[16][6];
+
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	ee.begin(400);
+
+	for (int i=0; i<16; i++) {
+		memset(d[i], i, 6);
+		s[i].addr = 1024 + (15 - i) * 8 + (i > 7 ? 200 : 0);
+		s[i].buf  = d[i];
+		s[i].len  = 6;
+		q[i]	  = s[i];
+		q[i].buf  = r[i];
+	}
+
+	sim.resetStats();
+	uint32_t t = I2C_eepromSim::now();
+	CHECK(ee.writev(s, 16) == 0);
+	uint32_t tv = I2C_eepromSim::now() - t;
+	uint32_t cv = sim.get_writeCycles();
+
+	sim.resetStats();
+	t = I2C_eepromSim::now();
+	for (int i=0; i<16; i++) ee.writeBlock(s[i].addr, s[i].buf, 6);
+	uint32_t tn = I2C_eepromSim::now() - t;
+	uint32_t cn = sim.get_writeCycles();
+
+	sim.resetStats();
+	CHECK(ee.readv(q, 16) == 0);
+	for (int i=0; i<16; i++) CHECK(q[i].status == 0 && memcmp(r[i], d[i], 6) == 0);
+
+	CHECK(cv < cn);
+	printf("%4u byte bus: writev %2u cycles %5.1f ms, writeBlock x16 %2u cycles %5.1f ms, readv %u transactions\n",
+		bufferSize, cv, tv / 1000.0, cn, tn / 1000.0, sim.get_transactions() - sim.get_nacks());
+}
+
+
+int main() {
+	I2C_eepromSim::useVirtualClock();
+	records(32);
+	records(4096);
+
+	// Random rounds: segments small and large, some back to back, some at
+	// the end of the PROM, overlaps included (written in the order given)
+	I2C_eepromSim	sim(32);
+	I2C_eeprom	ee(sim, 0x50, 512);
+	I2C_eepromSeg	seg[SEGS], rs[SEGS];
+	sim.attach(0x50, mem, sizeof(mem), 2, 128);
+	ee.begin(400);
+
+	srand(1);
+	for (uint32_t i=0; i<sizeof(mem); i++) mem[i] = ref[i] = rand();
+
+	int bad = 0;
+	for (int it=0; it<ROUNDS; it++) {
+		int n = 1 + rand() % SEGS;
+		for (int i=0; i<n; i++) {
+			seg[i].len  = rand() % (rand() % 3 ? 20 : 300);
+			seg[i].addr = (it % 5 == 0) ? 65536 - 400 + rand() % 100 : rand() % (65536 - 300);
+			if (rand() % 4 == 0 && i) seg[i].addr = seg[i-1].addr + seg[i-1].len + rand() % 8;
+			if (seg[i].addr + seg[i].len > 65536) seg[i].len = 0;
+			seg[i].buf = bufs[i];
+			for (int k=0; k<seg[i].len; k++) bufs[i][k] = rand();
+		}
+		for (int i=0; i<n; i++) memcpy(ref + seg[i].addr, seg[i].buf, seg[i].len);
+
+		if (ee.writev(seg, n) != 0 || memcmp(mem, ref, sizeof(mem)) != 0) bad++;
+
+		for (int i=0; i<n; i++) {
+			rs[i]	  = seg[i];
+			rs[i].buf = back[i];
+		}
+		if (ee.readv(rs, n) != 0) bad++;
+		for (int i=0; i<n; i++)
+			if (memcmp(back[i], ref + seg[i].addr, seg[i].len) != 0) bad++;
+	}
+	CHECK(bad == 0);
+
+	// Overlap: the later segment wins where they meet
+	uint8_t		a[10], b[10];
+	memset(a, 1, sizeof(a));
+	memset(b, 2, sizeof(b));
+	I2C_eepromSeg	o[2] = { { 100, a, 10, 0 }, { 95, b, 10, 0 } };
+	CHECK(ee.writev(o, 2) == 0);
+	CHECK(mem[96] == 2 && mem[104] == 2 && mem[108] == 1);
+
+	// Past the end: that segment's status, the others written
+	I2C_eepromSeg	r[2] = { { 65530, a, 10, 0 }, { 200, b, 10, 0 } };
+	CHECK(ee.writev(r, 2) == I2C_EEPROM_ERR_RANGE);
+	CHECK(r[0].status == I2C_EEPROM_ERR_RANGE && r[1].status == 0);
+	CHECK(memcmp(mem + 200, b, 10) == 0);
+	return TEST_DONE();
+}
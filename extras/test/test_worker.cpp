@@ -0,0 +1,103 @@
+//
+//               FILE:  test_worker.cpp
+//            PURPOSE:  I2C_eepromWorker: records from many tasks next to direct users, saved page writes
+//           Platform:  Linux host, I2C_eepromSim (24xx256, 400 kHz, i2c-dev sized buffer); built with I2C_EEPROM_THREADSAFE
+//---------------------------------------------------------------------------------------------------------
+//
+
+#include <I2C_eepromV2.h>
+#include <I2C_eepromSim.h>
+#include <I2C_eepromWorker.h>
+#include <pthread.h>
+#include "test.h"
+
+#define TASKS		8
+#define RECORDS		40		// per task
+#define DIRECT		2		// tasks on the I2C_eeprom itself
+
+static uint8_t		mem[32768];
+static I2C_eeprom*	ee;
+static I2C_eepromWorker* worker;
+static volatile int	bad;
+
+
+//
+// Record r of task t: 8 bytes, the tasks' records interleaved
+//
+static void* recorder(void* arg) {
+int t = (intptr_t)arg;
+
+	for (int r=0; r<RECORDS; r++) {
+		uint8_t	 rec[8], back[8];
+		uint16_t a = (r * TASKS + t) * 8;
+		for (int i=0; i<8; i++) rec[i] = t * 16 + r + i;
+		if (worker->write(a, rec, 8) != 0 || worker->read(a, back, 8) != 0 || memcmp(back, rec, 8) != 0) bad++;
+	}
+	return NULL;
+}
+
+static void* direct(void* arg) {
+int t = (intptr_t)arg;
+
+	for (int r=0; r<50; r++) {
+		uint8_t	 rec[40], back[40];
+		uint16_t a = 8192 + t * 4096 + r * 40;
+		memset(rec, t + r, sizeof(rec));
+		if (ee->writeBlock(a, rec, 40) != 0 || ee->readBlock(a, back, 40) != 40 || memcmp(back, rec, 40) != 0) bad++;
+	}
+	return NULL;
+}
+
+
+int main() {
+	I2C_eepromSim	sim(4096);			// a page per transaction
+	sim.attach(0x50, mem, sizeof(mem), 2, 64);
+
+	I2C_eeprom	prom(sim, 0x50, 256);
+	I2C_eepromWorker w(prom);
+	pthread_t	th[TASKS + DIRECT];
+
+	ee = &prom;
+	worker = &w;
+	prom.begin(400);
+
+	I2C_eepromReq	req;
+	CHECK(w.submit(&req, I2C_EEPROM_REQ_WRITE, 0, mem, 8) == I2C_EEPROM_ERR_BUSY);
+	CHECK(w.begin());
+
+	for (intptr_t t=0; t<TASKS; t++) pthread_create(&th[t], NULL, recorder, (void*)t);
+	for (intptr_t t=0; t<DIRECT; t++) pthread_create(&th[TASKS + t], NULL, direct, (void*)t);
+	for (int t=0; t<TASKS + DIRECT; t++) pthread_join(th[t], NULL);
+
+	CHECK(bad == 0);
+	for (int t=0; t<TASKS; t++)
+		for (int r=0; r<RECORDS; r++)
+			for (int i=0; i<8; i++)
+				if (mem[(r * TASKS + t) * 8 + i] != (uint8_t)(t * 16 + r + i)) bad++;
+	CHECK(bad == 0);
+	CHECK(w.get_requests() == 2UL * TASKS * RECORDS);
+	printf("%u requests in %u batches\n", w.get_requests(), w.get_batches());
+
+	// 16 records of 8 bytes in 2 pages, submitted at once: every page write
+	// is either made (a write cycle) or saved by merging
+	I2C_eepromReq	q[16];
+	uint8_t		d[16][8];
+	uint32_t	merged = w.get_merged();
+
+	sim.resetStats();
+	for (int i=0; i<16; i++) {
+		memset(d[i], 0xA0 + i, 8);
+		w.submit(&q[i], I2C_EEPROM_REQ_WRITE, 16384 + (15 - i) * 8, d[i], 8);
+	}
+	for (int i=0; i<16; i++) CHECK(w.wait(&q[i]) == 0);
+	for (int i=0; i<16; i++) CHECK(memcmp(mem + 16384 + (15 - i) * 8, d[i], 8) == 0);
+
+	merged = w.get_merged() - merged;
+	CHECK(merged + sim.get_writeCycles() == 16);
+	printf("16 records: %u write cycles, %u page writes saved\n", sim.get_writeCycles(), merged);
+
+	CHECK(w.submit(&req, I2C_EEPROM_REQ_READ, 32760, d[0], 16) == I2C_EEPROM_ERR_RANGE);
+	w.end();
+	CHECK(w.write(0, d[0], 8) == I2C_EEPROM_ERR_BUSY);
+	return TEST_DONE();
+}